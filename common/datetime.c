@@ -4,6 +4,12 @@
 #include <openenclave/internal/datetime.h>
 #include <openenclave/internal/raise.h>
 
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/time.h>
+#else
+#include <time.h>
+#endif
+
 #define UNIX_EPOCH_YEAR (1970)
 
 oe_result_t oe_datetime_is_valid(const oe_datetime_t* datetime)
@@ -221,3 +227,59 @@ int32_t oe_datetime_compare(
 
     return 0;
 }
+
+oe_result_t oe_datetime_now(oe_datetime_t* value)
+{
+    oe_result_t result = OE_FAILURE;
+    uint64_t seconds;
+    uint64_t days;
+
+    if (value == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+#ifdef OE_BUILD_ENCLAVE
+    {
+        uint64_t msec = oe_get_time();
+
+        if (msec == (uint64_t)-1)
+            OE_RAISE(OE_FAILURE);
+
+        seconds = msec / 1000;
+    }
+#else
+    {
+        time_t now = time(NULL);
+
+        if (now == (time_t)-1 || now < 0)
+            OE_RAISE(OE_FAILURE);
+
+        seconds = (uint64_t)now;
+    }
+#endif
+
+    days = seconds / 86400;
+    value->hours = (uint32_t)(seconds % 86400 / 3600);
+    value->minutes = (uint32_t)(seconds % 3600 / 60);
+    value->seconds = (uint32_t)(seconds % 60);
+
+    // Convert days since the Unix epoch to a civil date (proleptic Gregorian
+    // calendar, eras of 400 years starting on March 1st).
+    {
+        const uint64_t z = days + 719468;
+        const uint64_t era = z / 146097;
+        const uint64_t doe = z - era * 146097;
+        const uint64_t yoe =
+            (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const uint64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const uint64_t mp = (5 * doy + 2) / 153;
+        const uint32_t month = (uint32_t)(mp < 10 ? mp + 3 : mp - 9);
+
+        value->year = (uint32_t)(yoe + era * 400 + (month <= 2));
+        value->month = month;
+        value->day = (uint32_t)(doy - (153 * mp + 2) / 5 + 1);
+    }
+
+    result = OE_OK;
+done:
+    return result;
+}
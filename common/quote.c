@@ -11,6 +11,13 @@
 #include "common.h"
 #include "revocation.h"
 
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/atexit.h>
+#include <openenclave/internal/thread.h>
+#else
+#include "../host/hostthread.h"
+#endif
+
 #ifdef OE_USE_LIBSGX
 
 // Public key of Intel's root certificate.
@@ -149,6 +156,290 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** PCK certificate chain cache:
+**
+**     Quotes from the same platform carry the same PCK certificate chain.
+**     A chain that was parsed, verified and found to end in Intel's root key
+**     is kept with its leaf and intermediate certificates. It is keyed by the
+**     SHA-256 hash of its PEM encoding. Failed chains are not cached.
+**     Revocation is still checked for every quote. The leaf public key is
+**     read for every quote: mbedtls fills in the EC group's precomputed
+**     table on first use without a lock, so one key must not be used by
+**     several threads.
+**
+**==============================================================================
+*/
+
+#define PCK_CHAIN_CACHE_SIZE 8
+
+typedef struct _pck_chain
+{
+    /* Hash of the PEM encoding */
+    OE_SHA256 hash;
+
+    oe_cert_chain_t chain;
+    oe_cert_t leaf_cert;
+    oe_cert_t intermediate_cert;
+
+    /* Number of verifications using this chain */
+    size_t refs;
+
+    /* The chain is held by _pck_chain_cache */
+    bool cached;
+} pck_chain_t;
+
+static pck_chain_t* _pck_chain_cache[PCK_CHAIN_CACHE_SIZE];
+static size_t _pck_chain_cache_next;
+
+/* Intel's root public key, read once from g_expected_root_certificate_key */
+static oe_ec_public_key_t _expected_root_public_key;
+static bool _expected_root_public_key_read;
+
+#ifdef OE_BUILD_ENCLAVE
+static oe_mutex_t _pck_chain_lock = OE_MUTEX_INITIALIZER;
+static bool _pck_chain_cache_atexit;
+#else
+static oe_mutex _pck_chain_lock = OE_H_MUTEX_INITIALIZER;
+#endif
+
+static void _free_pck_chain(pck_chain_t* pck_chain)
+{
+    oe_cert_free(&pck_chain->leaf_cert);
+    oe_cert_free(&pck_chain->intermediate_cert);
+    oe_cert_chain_free(&pck_chain->chain);
+    free(pck_chain);
+}
+
+#ifdef OE_BUILD_ENCLAVE
+/* Free the cache when the enclave terminates, before debug malloc checks for
+ * leaks */
+static void _free_pck_chain_cache(void)
+{
+    oe_mutex_lock(&_pck_chain_lock);
+
+    for (size_t i = 0; i < PCK_CHAIN_CACHE_SIZE; i++)
+    {
+        if (_pck_chain_cache[i] && _pck_chain_cache[i]->refs == 0)
+        {
+            _free_pck_chain(_pck_chain_cache[i]);
+            _pck_chain_cache[i] = NULL;
+        }
+    }
+
+    if (_expected_root_public_key_read)
+    {
+        oe_ec_public_key_free(&_expected_root_public_key);
+        _expected_root_public_key_read = false;
+    }
+
+    oe_mutex_unlock(&_pck_chain_lock);
+}
+#endif
+
+/* Called with the lock held */
+static oe_result_t _register_pck_chain_cache_atexit(void)
+{
+#ifdef OE_BUILD_ENCLAVE
+    if (!_pck_chain_cache_atexit)
+    {
+        if (oe_atexit(_free_pck_chain_cache) != 0)
+            return OE_FAILURE;
+
+        _pck_chain_cache_atexit = true;
+    }
+#endif
+
+    return OE_OK;
+}
+
+/* Check that the root key is Intel's, reading Intel's key the first time */
+static oe_result_t _check_root_public_key(
+    const oe_ec_public_key_t* root_public_key)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    bool key_equal = false;
+
+    oe_mutex_lock(&_pck_chain_lock);
+
+    if (!_expected_root_public_key_read)
+    {
+        OE_CHECK(_register_pck_chain_cache_atexit());
+        OE_CHECK(
+            oe_ec_public_key_read_pem(
+                &_expected_root_public_key,
+                (const uint8_t*)g_expected_root_certificate_key,
+                strlen(g_expected_root_certificate_key) + 1));
+        _expected_root_public_key_read = true;
+    }
+
+    OE_CHECK(
+        oe_ec_public_key_equal(
+            root_public_key, &_expected_root_public_key, &key_equal));
+    if (!key_equal)
+        OE_RAISE(OE_VERIFY_FAILED);
+
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&_pck_chain_lock);
+    return result;
+}
+
+/* Find a cached chain and take a reference to it */
+static pck_chain_t* _find_pck_chain(const OE_SHA256* hash)
+{
+    pck_chain_t* found = NULL;
+
+    oe_mutex_lock(&_pck_chain_lock);
+
+    for (size_t i = 0; i < PCK_CHAIN_CACHE_SIZE; i++)
+    {
+        pck_chain_t* pck_chain = _pck_chain_cache[i];
+
+        if (pck_chain &&
+            memcmp(&pck_chain->hash, hash, sizeof(OE_SHA256)) == 0)
+        {
+            pck_chain->refs++;
+            found = pck_chain;
+            break;
+        }
+    }
+
+    oe_mutex_unlock(&_pck_chain_lock);
+
+    return found;
+}
+
+/* Cache a newly verified chain in place of the oldest unused entry */
+static void _cache_pck_chain(pck_chain_t* pck_chain)
+{
+    oe_mutex_lock(&_pck_chain_lock);
+
+    if (_register_pck_chain_cache_atexit() == OE_OK)
+    {
+        for (size_t n = 0; n < PCK_CHAIN_CACHE_SIZE; n++)
+        {
+            size_t i = _pck_chain_cache_next;
+            pck_chain_t* old = _pck_chain_cache[i];
+
+            _pck_chain_cache_next = (i + 1) % PCK_CHAIN_CACHE_SIZE;
+
+            if (old && old->refs)
+                continue;
+
+            if (old)
+                _free_pck_chain(old);
+
+            _pck_chain_cache[i] = pck_chain;
+            pck_chain->cached = true;
+            break;
+        }
+    }
+
+    oe_mutex_unlock(&_pck_chain_lock);
+}
+
+static void _release_pck_chain(pck_chain_t* pck_chain)
+{
+    bool free_pck_chain;
+
+    oe_mutex_lock(&_pck_chain_lock);
+    pck_chain->refs--;
+    free_pck_chain = !pck_chain->cached && pck_chain->refs == 0;
+    oe_mutex_unlock(&_pck_chain_lock);
+
+    if (free_pck_chain)
+        _free_pck_chain(pck_chain);
+}
+
+/* Parse and verify a PEM PCK certificate chain */
+static oe_result_t _load_pck_chain(
+    const uint8_t* pem_pck_certificate,
+    size_t pem_pck_certificate_size,
+    const OE_SHA256* hash,
+    pck_chain_t** pck_chain_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    pck_chain_t* pck_chain = NULL;
+    oe_cert_t root_cert = {0};
+    oe_ec_public_key_t root_public_key = {0};
+
+    *pck_chain_out = NULL;
+
+    if (!(pck_chain = (pck_chain_t*)malloc(sizeof(pck_chain_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(pck_chain, 0, sizeof(pck_chain_t));
+    pck_chain->hash = *hash;
+    pck_chain->refs = 1;
+
+    // Read and validate the chain.
+    OE_CHECK(
+        oe_cert_chain_read_pem(
+            &pck_chain->chain, pem_pck_certificate, pem_pck_certificate_size));
+
+    // Fetch leaf, intermediate and root certificates.
+    OE_CHECK(
+        oe_cert_chain_get_leaf_cert(&pck_chain->chain, &pck_chain->leaf_cert));
+    OE_CHECK(oe_cert_chain_get_root_cert(&pck_chain->chain, &root_cert));
+    OE_CHECK(
+        oe_cert_chain_get_cert(
+            &pck_chain->chain, 1, &pck_chain->intermediate_cert));
+
+    OE_CHECK(oe_cert_get_ec_public_key(&root_cert, &root_public_key));
+
+    // Ensure that the root certificate matches root of trust.
+    OE_CHECK(_check_root_public_key(&root_public_key));
+
+    *pck_chain_out = pck_chain;
+    pck_chain = NULL;
+    result = OE_OK;
+
+done:
+    if (pck_chain)
+        _free_pck_chain(pck_chain);
+
+    oe_ec_public_key_free(&root_public_key);
+    oe_cert_free(&root_cert);
+    return result;
+}
+
+/* Get the verified PCK certificate chain, from the cache if possible */
+static oe_result_t _get_pck_chain(
+    const uint8_t* pem_pck_certificate,
+    size_t pem_pck_certificate_size,
+    pck_chain_t** pck_chain)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_t sha256_ctx = {0};
+    OE_SHA256 hash = {0};
+
+    OE_CHECK(oe_sha256_init(&sha256_ctx));
+    OE_CHECK(
+        oe_sha256_update(
+            &sha256_ctx, pem_pck_certificate, pem_pck_certificate_size));
+    OE_CHECK(oe_sha256_final(&sha256_ctx, &hash));
+
+    if (!(*pck_chain = _find_pck_chain(&hash)))
+    {
+        OE_CHECK(
+            _load_pck_chain(
+                pem_pck_certificate,
+                pem_pck_certificate_size,
+                &hash,
+                pck_chain));
+        _cache_pck_chain(*pck_chain);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t VerifyQuoteImpl(
     const uint8_t* quote,
     size_t quote_size,
@@ -164,17 +455,11 @@ oe_result_t VerifyQuoteImpl(
     sgx_quote_auth_data_t* quote_auth_data = NULL;
     sgx_qe_auth_data_t qe_auth_data = {0};
     sgx_qe_cert_data_t qe_cert_data = {0};
-    oe_cert_chain_t pck_cert_chain = {0};
+    pck_chain_t* pck_chain = NULL;
     oe_sha256_context_t sha256_ctx = {0};
     OE_SHA256 sha256 = {0};
     oe_ec_public_key_t attestation_key = {0};
-    oe_cert_t leaf_cert = {0};
-    oe_cert_t root_cert = {0};
-    oe_cert_t intermediate_cert = {0};
     oe_ec_public_key_t leaf_public_key = {0};
-    oe_ec_public_key_t root_public_key = {0};
-    oe_ec_public_key_t expected_root_public_key = {0};
-    bool key_equal = false;
 
     OE_CHECK(
         _parse_quote(
@@ -208,38 +493,19 @@ oe_result_t VerifyQuoteImpl(
 
     // PckCertificate Chain validations.
     {
-        // Read and validate the chain.
-        OE_CHECK(
-            oe_cert_chain_read_pem(
-                &pck_cert_chain,
-                pem_pck_certificate,
-                pem_pck_certificate_size));
-
-        // Fetch leaf and root certificates.
-        OE_CHECK(oe_cert_chain_get_leaf_cert(&pck_cert_chain, &leaf_cert));
-        OE_CHECK(oe_cert_chain_get_root_cert(&pck_cert_chain, &root_cert));
+        // Read and validate the chain, or find it already validated.
         OE_CHECK(
-            oe_cert_chain_get_cert(&pck_cert_chain, 1, &intermediate_cert));
-
-        OE_CHECK(oe_cert_get_ec_public_key(&leaf_cert, &leaf_public_key));
-        OE_CHECK(oe_cert_get_ec_public_key(&root_cert, &root_public_key));
+            _get_pck_chain(
+                pem_pck_certificate, pem_pck_certificate_size, &pck_chain));
 
-        // Ensure that the root certificate matches root of trust.
         OE_CHECK(
-            oe_ec_public_key_read_pem(
-                &expected_root_public_key,
-                (const uint8_t*)g_expected_root_certificate_key,
-                strlen(g_expected_root_certificate_key) + 1));
-
-        OE_CHECK(
-            oe_ec_public_key_equal(
-                &root_public_key, &expected_root_public_key, &key_equal));
-        if (!key_equal)
-            OE_RAISE(OE_VERIFY_FAILED);
+            oe_enforce_revocation(
+                &pck_chain->leaf_cert,
+                &pck_chain->intermediate_cert,
+                &pck_chain->chain));
 
         OE_CHECK(
-            oe_enforce_revocation(
-                &leaf_cert, &intermediate_cert, &pck_cert_chain));
+            oe_cert_get_ec_public_key(&pck_chain->leaf_cert, &leaf_public_key));
     }
 
     // Quote validations.
@@ -313,13 +579,11 @@ oe_result_t VerifyQuoteImpl(
 
 done:
     oe_ec_public_key_free(&leaf_public_key);
-    oe_ec_public_key_free(&root_public_key);
-    oe_ec_public_key_free(&expected_root_public_key);
     oe_ec_public_key_free(&attestation_key);
-    oe_cert_free(&leaf_cert);
-    oe_cert_free(&root_cert);
-    oe_cert_free(&intermediate_cert);
-    oe_cert_chain_free(&pck_cert_chain);
+
+    if (pck_chain)
+        _release_pck_chain(pck_chain);
+
     return result;
 }
 
@@ -3,9 +3,11 @@
 
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/safecrt.h>
+#include <openenclave/bits/safemath.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/sha.h>
 #include <openenclave/internal/utils.h>
 #include "common.h"
 
@@ -190,3 +192,91 @@ oe_result_t oe_get_target_info(
 done:
     return result;
 }
+
+oe_result_t oe_find_duplicate_reports(
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    size_t* first)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    OE_SHA256* hashes = NULL;
+    size_t* table = NULL;
+    size_t table_size = 1;
+    size_t min_table_size;
+    oe_sha256_context_t sha256_ctx = {0};
+    size_t size;
+
+    if ((count && (!reports || !report_sizes)) || !first)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (count == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    OE_CHECK(oe_safe_mul_sizet(count, sizeof(OE_SHA256), &size));
+
+    if (!(hashes = (OE_SHA256*)malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* The distinct reports seen so far are kept in an open-addressed table
+     * indexed by their hash. It is at least twice as large as the batch, so
+     * it always has a free slot. Free slots hold count. */
+    OE_CHECK(oe_safe_mul_sizet(count, 2, &min_table_size));
+
+    while (table_size < min_table_size)
+        OE_CHECK(oe_safe_mul_sizet(table_size, 2, &table_size));
+
+    OE_CHECK(oe_safe_mul_sizet(table_size, sizeof(size_t), &size));
+
+    if (!(table = (size_t*)malloc(size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t k = 0; k < table_size; k++)
+        table[k] = count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t key;
+
+        first[i] = i;
+
+        if (!reports[i])
+            continue;
+
+        OE_CHECK(oe_sha256_init(&sha256_ctx));
+        OE_CHECK(oe_sha256_update(&sha256_ctx, reports[i], report_sizes[i]));
+        OE_CHECK(oe_sha256_final(&sha256_ctx, &hashes[i]));
+
+        /* Look for an identical report, or add this one */
+        memcpy(&key, hashes[i].buf, sizeof(key));
+
+        for (size_t k = key & (table_size - 1);; k = (k + 1) & (table_size - 1))
+        {
+            size_t j = table[k];
+
+            if (j == count)
+            {
+                table[k] = i;
+                break;
+            }
+
+            if (report_sizes[j] == report_sizes[i] &&
+                memcmp(&hashes[j], &hashes[i], sizeof(OE_SHA256)) == 0 &&
+                memcmp(reports[j], reports[i], report_sizes[i]) == 0)
+            {
+                first[i] = j;
+                break;
+            }
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    free(table);
+    free(hashes);
+    return result;
+}
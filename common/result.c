@@ -93,6 +93,8 @@ const char* oe_result_str(oe_result_t result)
             return "OE_INVALID_REVOCATION_INFO";
         case OE_INVALID_UTC_DATE_TIME:
             return "OE_INVALID_UTC_DATE_TIME";
+        case OE_TIMEOUT:
+            return "OE_TIMEOUT";
         case __OE_RESULT_MAX:
             break;
     }
@@ -20,6 +20,12 @@
 #include "common.h"
 #include "tcbinfo.h"
 
+#ifdef OE_BUILD_ENCLAVE
+#include <openenclave/internal/atexit.h>
+#else
+#include "../host/hostthread.h"
+#endif
+
 #ifdef OE_USE_LIBSGX
 
 // Defaults to Intel SGX 1.8 Release Date.
@@ -153,50 +159,281 @@ static void _trace_datetime(const char* msg, const oe_datetime_t* date)
 #endif
 }
 
-oe_result_t oe_enforce_revocation(
-    oe_cert_t* leaf_cert,
-    oe_cert_t* intermediate_cert,
-    oe_cert_chain_t* pck_cert_chain)
+/*
+**==============================================================================
+**
+** Collateral cache:
+**
+**     The revocation information of a platform (the TCB info and the CRLs
+**     with their issuer chains) is fetched with an OCALL, parsed and checked
+**     once, and then kept until the earliest next update date of the CRLs
+**     and the TCB info. Entries are keyed by the FMSPC and the CRL
+**     distribution points of the PCK certificates. Each entry also records
+**     the platform TCB levels found up to date, so that the TCB info is not
+**     parsed again for the same platform. Inside an enclave, the current
+**     time used for the expiry is provided by the host.
+**
+**     Inside an enclave, verifications that use the same entry are
+**     serialized: mbedtls fills in the comb table of the issuer keys' EC group
+**     (grp->T) on first use without a lock, so the cached issuer chains and
+**     CRLs must not be used by two threads at once.
+**
+**==============================================================================
+*/
+
+#define COLLATERAL_CACHE_SIZE 8
+#define MAX_CACHED_TCB_LEVELS 16
+
+typedef struct _collateral
+{
+    /* Key */
+    uint8_t fmspc[6];
+    char* crl_urls[2];
+
+    oe_crl_t crls[2];
+    oe_cert_chain_t crl_issuer_chain[2];
+    uint8_t* tcb_info;
+    size_t tcb_info_size;
+
+    /* Earliest next update date of the CRLs and the TCB info */
+    oe_datetime_t next_update;
+
+    /* The minimum issue date that the collateral was checked against */
+    oe_datetime_t minimum_issue_date;
+
+    /* Platform TCB levels that the TCB info reports as up to date */
+    oe_tcb_level_t tcb_levels[MAX_CACHED_TCB_LEVELS];
+    size_t num_tcb_levels;
+
+    /* Number of verifications using this collateral */
+    size_t refs;
+
+    /* The collateral is held by _collateral_cache */
+    bool cached;
+
+#ifdef OE_BUILD_ENCLAVE
+    /* Serializes the use of crls and crl_issuer_chain */
+    oe_mutex_t verify_lock;
+#endif
+} collateral_t;
+
+static collateral_t* _collateral_cache[COLLATERAL_CACHE_SIZE];
+
+#ifdef OE_BUILD_ENCLAVE
+static oe_mutex_t _collateral_lock = OE_MUTEX_INITIALIZER;
+#define _lock_collateral() oe_mutex_lock(&_collateral_lock)
+#define _unlock_collateral() oe_mutex_unlock(&_collateral_lock)
+#else
+static oe_mutex _collateral_lock = OE_H_MUTEX_INITIALIZER;
+#define _lock_collateral() oe_mutex_lock(&_collateral_lock)
+#define _unlock_collateral() oe_mutex_unlock(&_collateral_lock)
+#endif
+
+static void _free_collateral(collateral_t* collateral)
+{
+    for (uint32_t i = 0; i < OE_COUNTOF(collateral->crls); ++i)
+    {
+        oe_crl_free(&collateral->crls[i]);
+        oe_cert_chain_free(&collateral->crl_issuer_chain[i]);
+        free(collateral->crl_urls[i]);
+    }
+
+    free(collateral->tcb_info);
+#ifdef OE_BUILD_ENCLAVE
+    oe_mutex_destroy(&collateral->verify_lock);
+#endif
+    free(collateral);
+}
+
+static bool _is_same_string(const char* s1, const char* s2)
+{
+    size_t n = strlen(s1);
+
+    return n == strlen(s2) && memcmp(s1, s2, n) == 0;
+}
+
+static bool _collateral_matches(
+    const collateral_t* collateral,
+    const uint8_t fmspc[6],
+    char* const crl_urls[2])
+{
+    return memcmp(collateral->fmspc, fmspc, sizeof(collateral->fmspc)) == 0 &&
+           _is_same_string(collateral->crl_urls[0], crl_urls[0]) &&
+           _is_same_string(collateral->crl_urls[1], crl_urls[1]) &&
+           oe_datetime_compare(
+               &collateral->minimum_issue_date,
+               &_sgx_minimim_crl_tcb_issue_date) == 0;
+}
+
+/* Find unexpired collateral and take a reference to it */
+static collateral_t* _find_collateral(
+    const uint8_t fmspc[6],
+    char* const crl_urls[2],
+    const oe_datetime_t* now)
+{
+    collateral_t* found = NULL;
+
+    _lock_collateral();
+
+    for (size_t i = 0; i < COLLATERAL_CACHE_SIZE; i++)
+    {
+        collateral_t* collateral = _collateral_cache[i];
+
+        if (!collateral || !_collateral_matches(collateral, fmspc, crl_urls))
+            continue;
+
+        if (oe_datetime_compare(now, &collateral->next_update) < 0)
+        {
+            collateral->refs++;
+            found = collateral;
+            break;
+        }
+
+        /* Drop expired collateral that is no longer in use */
+        if (collateral->refs == 0)
+        {
+            _free_collateral(collateral);
+            _collateral_cache[i] = NULL;
+        }
+    }
+
+    _unlock_collateral();
+
+    return found;
+}
+
+#ifdef OE_BUILD_ENCLAVE
+static bool _collateral_cache_atexit;
+
+/* Free the cache when the enclave terminates, before debug malloc checks for
+ * leaks */
+static void _free_collateral_cache(void)
+{
+    _lock_collateral();
+
+    for (size_t i = 0; i < COLLATERAL_CACHE_SIZE; i++)
+    {
+        if (_collateral_cache[i] && _collateral_cache[i]->refs == 0)
+        {
+            _free_collateral(_collateral_cache[i]);
+            _collateral_cache[i] = NULL;
+        }
+    }
+
+    _unlock_collateral();
+}
+#endif
+
+/* Cache newly loaded collateral, unless all entries are in use */
+static void _cache_collateral(collateral_t* collateral)
+{
+    size_t slot = COLLATERAL_CACHE_SIZE;
+
+    _lock_collateral();
+
+#ifdef OE_BUILD_ENCLAVE
+    if (!_collateral_cache_atexit)
+    {
+        if (oe_atexit(_free_collateral_cache) != 0)
+        {
+            _unlock_collateral();
+            return;
+        }
+
+        _collateral_cache_atexit = true;
+    }
+#endif
+
+    for (size_t i = 0; i < COLLATERAL_CACHE_SIZE; i++)
+    {
+        if (!_collateral_cache[i])
+        {
+            slot = i;
+            break;
+        }
+
+        if (_collateral_cache[i]->refs == 0 && slot == COLLATERAL_CACHE_SIZE)
+            slot = i;
+    }
+
+    if (slot != COLLATERAL_CACHE_SIZE)
+    {
+        if (_collateral_cache[slot])
+            _free_collateral(_collateral_cache[slot]);
+
+        _collateral_cache[slot] = collateral;
+        collateral->cached = true;
+    }
+
+    _unlock_collateral();
+}
+
+static void _release_collateral(collateral_t* collateral)
+{
+    bool free_collateral;
+
+    _lock_collateral();
+    collateral->refs--;
+    free_collateral = !collateral->cached && collateral->refs == 0;
+    _unlock_collateral();
+
+    if (free_collateral)
+        _free_collateral(collateral);
+}
+
+/* Fetch, parse and check the revocation information of a platform */
+static oe_result_t _load_collateral(
+    const uint8_t fmspc[6],
+    char* const crl_urls[2],
+    const oe_tcb_level_t* platform_tcb_level,
+    collateral_t** collateral_out)
 {
     oe_result_t result = OE_FAILURE;
     oe_result_t r = OE_FAILURE;
-    ParsedExtensionInfo parsed_extension_info = {{0}};
+    collateral_t* collateral = NULL;
     oe_get_revocation_info_args_t revocation_args = {0};
     oe_cert_chain_t tcb_issuer_chain = {0};
-    oe_cert_chain_t crl_issuer_chain[3] = {{{0}}};
     oe_parsed_tcb_info_t parsed_tcb_info = {0};
-    oe_tcb_level_t platform_tcb_level = {{0}};
-    oe_verify_cert_error_t cert_verify_error = {0};
-    char* intermediate_crl_url = NULL;
-    char* leaf_crl_url = NULL;
-    oe_crl_t crls[2] = {{{0}}};
-    const oe_crl_t* crl_ptrs[2] = {&crls[0], &crls[1]};
+    oe_tcb_level_t tcb_level = *platform_tcb_level;
     oe_datetime_t crl_this_update_date = {0};
     oe_datetime_t crl_next_update_date = {0};
 
-    if (intermediate_cert == NULL || leaf_cert == NULL)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
     OE_STATIC_ASSERT(
-        OE_COUNTOF(crl_issuer_chain) ==
+        OE_COUNTOF(collateral->crl_issuer_chain) <=
         OE_COUNTOF(revocation_args.crl_issuer_chain));
 
-    // Gather fmspc.
-    OE_CHECK(_parse_sgx_extensions(leaf_cert, &parsed_extension_info));
+    *collateral_out = NULL;
+
+    if (!(collateral = (collateral_t*)malloc(sizeof(collateral_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(collateral, 0, sizeof(collateral_t));
+#ifdef OE_BUILD_ENCLAVE
+    oe_mutex_init(&collateral->verify_lock);
+#endif
+    collateral->refs = 1;
+    collateral->minimum_issue_date = _sgx_minimim_crl_tcb_issue_date;
+
+    // Copy the key.
     OE_CHECK(
         oe_memcpy_s(
-            revocation_args.fmspc,
-            sizeof(revocation_args.fmspc),
-            parsed_extension_info.fmspc,
-            sizeof(parsed_extension_info.fmspc)));
+            collateral->fmspc, sizeof(collateral->fmspc), fmspc, 6));
 
-    // Gather CRL distribution point URLs from certs.
-    OE_CHECK(
-        _get_crl_distribution_point(intermediate_cert, &intermediate_crl_url));
-    OE_CHECK(_get_crl_distribution_point(leaf_cert, &leaf_crl_url));
+    for (uint32_t i = 0; i < OE_COUNTOF(collateral->crl_urls); ++i)
+    {
+        size_t size = strlen(crl_urls[i]) + 1;
+
+        if (!(collateral->crl_urls[i] = (char*)malloc(size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
 
-    revocation_args.crl_urls[0] = leaf_crl_url;
-    revocation_args.crl_urls[1] = intermediate_crl_url;
+        OE_CHECK(oe_memcpy_s(collateral->crl_urls[i], size, crl_urls[i], size));
+    }
+
+    OE_CHECK(
+        oe_memcpy_s(
+            revocation_args.fmspc, sizeof(revocation_args.fmspc), fmspc, 6));
+    revocation_args.crl_urls[0] = crl_urls[0];
+    revocation_args.crl_urls[1] = crl_urls[1];
     revocation_args.num_crl_urls = 2;
 
     OE_CHECK(oe_get_revocation_info(&revocation_args));
@@ -214,53 +451,39 @@ oe_result_t oe_enforce_revocation(
     {
         OE_CHECK(
             oe_crl_read_der(
-                &crls[i], revocation_args.crl[i], revocation_args.crl_size[i]));
+                &collateral->crls[i],
+                revocation_args.crl[i],
+                revocation_args.crl_size[i]));
         OE_CHECK(
             oe_cert_chain_read_pem(
-                &crl_issuer_chain[i],
+                &collateral->crl_issuer_chain[i],
                 revocation_args.crl_issuer_chain[i],
                 revocation_args.crl_issuer_chain_size[i]));
     }
 
-    // Verify the leaf cert.
-    // oe_cert_verify incorporates openssl -crl_check_all semantics.
-    // For successful verification:
-    //    1. The certificate chain must be valid. Each cert must
-    //       have its issuer CA in the chain.
-    //    2. Each issuer CA (ie all certs other than the leaf cert)
-    //       must also have a matching CRL issued by the issuer CA.
-    //    3. The certificate chain must pass signature verification.
-    //    4. No certificate in the chain must be revoked.
-    // Note: An issuer CA can revoke only the certs that it has issued.
-    // this follows that the certificate chain and CRL issuer chains must
-    // be the same. We pass the crl_issuer_chain here to assert that
-    // constraint. If the crl_issuer_chain was different from the certificate
-    // chain, then verification would fail because the CRLs will not be found
-    // for certificates in the chain.
-    r = oe_cert_verify(
-        leaf_cert, &crl_issuer_chain[0], crl_ptrs, 2, &cert_verify_error);
-    if (r != OE_OK)
-    {
-        OE_TRACE_INFO(
-            "oe_cer_verify failed with error = %s\n", cert_verify_error.buf);
-        OE_RAISE(r);
-    }
-
-    for (uint32_t i = 0; i < OE_COUNTOF(platform_tcb_level.sgx_tcb_comp_svn);
-         ++i)
-    {
-        platform_tcb_level.sgx_tcb_comp_svn[i] =
-            parsed_extension_info.comp_svn[i];
-    }
-    platform_tcb_level.pce_svn = parsed_extension_info.pce_svn;
-    platform_tcb_level.status = OE_TCB_LEVEL_STATUS_UNKNOWN;
+    // Keep a copy of the TCB info to find the status of other platforms.
+    if (!(collateral->tcb_info =
+              (uint8_t*)malloc(revocation_args.tcb_info_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
 
     OE_CHECK(
-        oe_parse_tcb_info_json(
-            revocation_args.tcb_info,
+        oe_memcpy_s(
+            collateral->tcb_info,
             revocation_args.tcb_info_size,
-            &platform_tcb_level,
-            &parsed_tcb_info));
+            revocation_args.tcb_info,
+            revocation_args.tcb_info_size));
+    collateral->tcb_info_size = revocation_args.tcb_info_size;
+
+    // Parse the TCB info. The signature and dates are checked even if this
+    // platform is not up to date, since the TCB info is cached.
+    tcb_level.status = OE_TCB_LEVEL_STATUS_UNKNOWN;
+    r = oe_parse_tcb_info_json(
+        collateral->tcb_info,
+        collateral->tcb_info_size,
+        &tcb_level,
+        &parsed_tcb_info);
+    if (r != OE_OK && r != OE_TCB_LEVEL_INVALID)
+        OE_RAISE(r);
 
     OE_CHECK(
         oe_verify_tcb_signature(
@@ -269,20 +492,27 @@ oe_result_t oe_enforce_revocation(
             (sgx_ecdsa256_signature_t*)parsed_tcb_info.signature,
             &tcb_issuer_chain));
 
+    if (r == OE_OK)
+        collateral->tcb_levels[collateral->num_tcb_levels++] = tcb_level;
+
     // Check that the tcb has been issued after the earliest date that the
     // enclave accepts.
     if (oe_datetime_compare(
             &parsed_tcb_info.issue_date, &_sgx_minimim_crl_tcb_issue_date) != 1)
         OE_RAISE(OE_INVALID_REVOCATION_INFO);
 
+    collateral->next_update = parsed_tcb_info.next_update;
+
     // Check that the CRLs have not expired.
     // The next update of the CRL must be after the earliest date that
     // the enclave accepts.
-    for (uint32_t i = 0; i < OE_COUNTOF(crls); ++i)
+    for (uint32_t i = 0; i < OE_COUNTOF(collateral->crls); ++i)
     {
         OE_CHECK(
             oe_crl_get_update_dates(
-                &crls[0], &crl_this_update_date, &crl_next_update_date));
+                &collateral->crls[i],
+                &crl_this_update_date,
+                &crl_next_update_date));
 
         _trace_datetime("crl this update date ", &crl_this_update_date);
         _trace_datetime("crl next update date ", &crl_next_update_date);
@@ -296,24 +526,181 @@ oe_result_t oe_enforce_revocation(
         if (oe_datetime_compare(
                 &crl_next_update_date, &_sgx_minimim_crl_tcb_issue_date) != 1)
             OE_RAISE(OE_INVALID_REVOCATION_INFO);
+
+        if (oe_datetime_compare(
+                &crl_next_update_date, &collateral->next_update) < 0)
+            collateral->next_update = crl_next_update_date;
     }
 
+    *collateral_out = collateral;
+    collateral = NULL;
     result = OE_OK;
 
 done:
-    for (int32_t i = revocation_args.num_crl_urls - 1; i >= 0; --i)
+    if (collateral)
+        _free_collateral(collateral);
+
+    oe_cert_chain_free(&tcb_issuer_chain);
+    oe_cleanup_get_revocation_info_args(&revocation_args);
+
+    return result;
+}
+
+static bool _is_same_tcb_level(
+    const oe_tcb_level_t* level1,
+    const oe_tcb_level_t* level2)
+{
+    return level1->pce_svn == level2->pce_svn &&
+           memcmp(
+               level1->sgx_tcb_comp_svn,
+               level2->sgx_tcb_comp_svn,
+               sizeof(level1->sgx_tcb_comp_svn)) == 0;
+}
+
+/* Check that the TCB info reports the platform as up to date */
+static oe_result_t _check_tcb_level(
+    collateral_t* collateral,
+    const oe_tcb_level_t* platform_tcb_level)
+{
+    oe_result_t result = OE_FAILURE;
+    oe_tcb_level_t tcb_level = *platform_tcb_level;
+    oe_parsed_tcb_info_t parsed_tcb_info = {0};
+    bool found = false;
+
+    _lock_collateral();
+
+    for (size_t i = 0; i < collateral->num_tcb_levels && !found; i++)
+        found = _is_same_tcb_level(&collateral->tcb_levels[i], &tcb_level);
+
+    _unlock_collateral();
+
+    if (!found)
     {
-        oe_crl_free(&crls[i]);
+        tcb_level.status = OE_TCB_LEVEL_STATUS_UNKNOWN;
+        OE_CHECK(
+            oe_parse_tcb_info_json(
+                collateral->tcb_info,
+                collateral->tcb_info_size,
+                &tcb_level,
+                &parsed_tcb_info));
+
+        _lock_collateral();
+
+        if (collateral->num_tcb_levels < MAX_CACHED_TCB_LEVELS)
+            collateral->tcb_levels[collateral->num_tcb_levels++] = tcb_level;
+
+        _unlock_collateral();
     }
-    for (uint32_t i = 0; i < revocation_args.num_crl_urls; ++i)
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_enforce_revocation(
+    oe_cert_t* leaf_cert,
+    oe_cert_t* intermediate_cert,
+    oe_cert_chain_t* pck_cert_chain)
+{
+    oe_result_t result = OE_FAILURE;
+    oe_result_t r = OE_FAILURE;
+    ParsedExtensionInfo parsed_extension_info = {{0}};
+    oe_tcb_level_t platform_tcb_level = {{0}};
+    oe_verify_cert_error_t cert_verify_error = {0};
+    char* crl_urls[2] = {NULL, NULL};
+    collateral_t* collateral = NULL;
+    const oe_crl_t* crl_ptrs[2] = {NULL, NULL};
+    oe_datetime_t now = {0};
+    bool have_now = false;
+
+    if (intermediate_cert == NULL || leaf_cert == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Gather fmspc.
+    OE_CHECK(_parse_sgx_extensions(leaf_cert, &parsed_extension_info));
+
+    // Gather CRL distribution point URLs from certs.
+    OE_CHECK(_get_crl_distribution_point(leaf_cert, &crl_urls[0]));
+    OE_CHECK(_get_crl_distribution_point(intermediate_cert, &crl_urls[1]));
+
+    for (uint32_t i = 0; i < OE_COUNTOF(platform_tcb_level.sgx_tcb_comp_svn);
+         ++i)
+    {
+        platform_tcb_level.sgx_tcb_comp_svn[i] =
+            parsed_extension_info.comp_svn[i];
+    }
+    platform_tcb_level.pce_svn = parsed_extension_info.pce_svn;
+    platform_tcb_level.status = OE_TCB_LEVEL_STATUS_UNKNOWN;
+
+    // Use cached collateral if it has not expired. Without the current time,
+    // fetch the collateral and do not cache it.
+    have_now = (oe_datetime_now(&now) == OE_OK);
+
+    if (have_now)
+        collateral =
+            _find_collateral(parsed_extension_info.fmspc, crl_urls, &now);
+
+    if (!collateral)
     {
-        oe_cert_chain_free(&crl_issuer_chain[i]);
+        OE_CHECK(
+            _load_collateral(
+                parsed_extension_info.fmspc,
+                crl_urls,
+                &platform_tcb_level,
+                &collateral));
+
+        if (have_now && oe_datetime_compare(&now, &collateral->next_update) < 0)
+            _cache_collateral(collateral);
     }
-    oe_cert_chain_free(&tcb_issuer_chain);
 
-    free(leaf_crl_url);
-    free(intermediate_crl_url);
-    oe_cleanup_get_revocation_info_args(&revocation_args);
+    crl_ptrs[0] = &collateral->crls[0];
+    crl_ptrs[1] = &collateral->crls[1];
+
+    // Verify the leaf cert.
+    // oe_cert_verify incorporates openssl -crl_check_all semantics.
+    // For successful verification:
+    //    1. The certificate chain must be valid. Each cert must
+    //       have its issuer CA in the chain.
+    //    2. Each issuer CA (ie all certs other than the leaf cert)
+    //       must also have a matching CRL issued by the issuer CA.
+    //    3. The certificate chain must pass signature verification.
+    //    4. No certificate in the chain must be revoked.
+    // Note: An issuer CA can revoke only the certs that it has issued.
+    // this follows that the certificate chain and CRL issuer chains must
+    // be the same. We pass the crl_issuer_chain here to assert that
+    // constraint. If the crl_issuer_chain was different from the certificate
+    // chain, then verification would fail because the CRLs will not be found
+    // for certificates in the chain.
+#ifdef OE_BUILD_ENCLAVE
+    oe_mutex_lock(&collateral->verify_lock);
+#endif
+    r = oe_cert_verify(
+        leaf_cert,
+        &collateral->crl_issuer_chain[0],
+        crl_ptrs,
+        2,
+        &cert_verify_error);
+#ifdef OE_BUILD_ENCLAVE
+    oe_mutex_unlock(&collateral->verify_lock);
+#endif
+    if (r != OE_OK)
+    {
+        OE_TRACE_INFO(
+            "oe_cer_verify failed with error = %s\n", cert_verify_error.buf);
+        OE_RAISE(r);
+    }
+
+    OE_CHECK(_check_tcb_level(collateral, &platform_tcb_level));
+
+    result = OE_OK;
+
+done:
+    if (collateral)
+        _release_collateral(collateral);
+
+    free(crl_urls[0]);
+    free(crl_urls[1]);
 
     return result;
 }
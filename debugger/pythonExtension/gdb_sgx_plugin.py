@@ -17,12 +17,25 @@ OE_ENCLAVE_HEADER_LENGTH = 0X28
 OE_ENCLAVE_HEADER_FORMAT = 'QQQQQ'
 OE_ENCLAVE_MAGIC_VALUE = 0x20dc98463a5ad8b8
 
-# The following is the offset of the 'debug' and
-# 'simulate' fields which must lie one after the other.
-OE_ENCLAVE_FLAGS_OFFSET = 0x598
+# Layout version 1 embedded a fixed array of thread bindings right after the
+# header. Later layouts store OE_ENCLAVE_DEBUG_LAYOUT_VERSION there instead,
+# which can never be mistaken for a TCS address.
+OE_ENCLAVE_LAYOUT_VERSION_OFFSET = 0x28
+OE_ENCLAVE_LAYOUT_VERSION_MAX = 0x1000
+
+# Layout version 1: the 'debug' and 'simulate' fields must lie one after
+# the other.
+OE_ENCLAVE_V1_FLAGS_OFFSET = 0x598
+OE_ENCLAVE_V1_THREAD_DATA_OFFSET = 0x28
+
+# Layout version 2: pointer to the thread binding table and its length,
+# followed by the 'debug' and 'simulate' fields.
+OE_ENCLAVE_V2_THREAD_DATA_POINTER_OFFSET = 0x30
+OE_ENCLAVE_V2_NUM_THREAD_DATA_OFFSET = 0x38
+OE_ENCLAVE_V2_FLAGS_OFFSET = 0x40
+
 OE_ENCLAVE_FLAGS_LENGTH = 2
 OE_ENCLAVE_FLAGS_FORMAT = 'BB'
-OE_ENCLAVE_THREAD_DATA_OFFSET = 0x28
 
 # These constant definitions must align with ThreadData structure defined in host\enclave.h
 THREAD_DATA_SIZE = 0x28
@@ -147,8 +160,19 @@ def enable_oeenclave_debug(oe_enclave_addr, enclave_path):
     enclave_tuple = struct.unpack(OE_ENCLAVE_HEADER_FORMAT, enclave_blob)
     if enclave_tuple[OE_ENCLAVE_MAGIC_FIELD] != OE_ENCLAVE_MAGIC_VALUE:
         return False
+    # Locate the flags and the thread binding table for this layout version.
+    version_blob = read_from_memory(oe_enclave_addr + OE_ENCLAVE_LAYOUT_VERSION_OFFSET, POINTER_SIZE)
+    version = struct.unpack('Q', version_blob)[0]
+    if version < OE_ENCLAVE_LAYOUT_VERSION_MAX:
+        flags_offset = OE_ENCLAVE_V2_FLAGS_OFFSET
+        thread_data_addr = struct.unpack('Q', read_from_memory(oe_enclave_addr + OE_ENCLAVE_V2_THREAD_DATA_POINTER_OFFSET, POINTER_SIZE))[0]
+        num_thread_data = struct.unpack('Q', read_from_memory(oe_enclave_addr + OE_ENCLAVE_V2_NUM_THREAD_DATA_OFFSET, POINTER_SIZE))[0]
+    else:
+        flags_offset = OE_ENCLAVE_V1_FLAGS_OFFSET
+        thread_data_addr = oe_enclave_addr + OE_ENCLAVE_V1_THREAD_DATA_OFFSET
+        num_thread_data = None
     # Check if it's SGX debug mode enclave.
-    flags_blob = read_from_memory(oe_enclave_addr + OE_ENCLAVE_FLAGS_OFFSET, OE_ENCLAVE_FLAGS_LENGTH)
+    flags_blob = read_from_memory(oe_enclave_addr + flags_offset, OE_ENCLAVE_FLAGS_LENGTH)
     flags_tuple = struct.unpack(OE_ENCLAVE_FLAGS_FORMAT, flags_blob)
     # Debug == 1 and simulation == 0
     if flags_tuple[0] == 0 or flags_tuple[1] != 0:
@@ -157,7 +181,12 @@ def enable_oeenclave_debug(oe_enclave_addr, enclave_path):
     if load_enclave_symbol(enclave_path, enclave_tuple[OE_ENCLAVE_ADDR_FIELD]) != 1:
         return False
     # Set debug flag for each TCS in this enclave.
-    thread_data_addr = oe_enclave_addr + OE_ENCLAVE_THREAD_DATA_OFFSET
+    if num_thread_data is not None:
+        for i in range(num_thread_data):
+            thread_data_blob = read_from_memory(thread_data_addr + i * THREAD_DATA_SIZE, THREAD_DATA_HEADER_LENGTH)
+            thread_data_tuple = struct.unpack(THREAD_DATA_HEADER_FORMAT, thread_data_blob)
+            set_tcs_debug_flag(thread_data_tuple[0])
+        return True
     thread_data_blob = read_from_memory(thread_data_addr, THREAD_DATA_HEADER_LENGTH)
     thread_data_tuple = struct.unpack(THREAD_DATA_HEADER_FORMAT, thread_data_blob)
     while thread_data_tuple[0] > 0 :
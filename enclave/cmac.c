@@ -47,3 +47,85 @@ oe_result_t oe_aes_cmac_sign(
 done:
     return result;
 }
+
+typedef struct _oe_aes_cmac_context_impl
+{
+    mbedtls_cipher_context_t ctx;
+} oe_aes_cmac_context_impl_t;
+
+OE_STATIC_ASSERT(
+    sizeof(oe_aes_cmac_context_impl_t) <= sizeof(oe_aes_cmac_context_t));
+
+oe_result_t oe_aes_cmac_init(
+    oe_aes_cmac_context_t* context,
+    const uint8_t* key,
+    size_t key_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_aes_cmac_context_impl_t* impl = (oe_aes_cmac_context_impl_t*)context;
+    const mbedtls_cipher_info_t* info = NULL;
+    size_t key_size_bits = key_size * 8;
+
+    if (context == NULL || key == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    mbedtls_cipher_init(&impl->ctx);
+
+    if (key_size_bits != 128)
+        OE_RAISE(OE_UNSUPPORTED);
+
+    info = mbedtls_cipher_info_from_type(MBEDTLS_CIPHER_AES_128_ECB);
+    if (info == NULL)
+        OE_RAISE(OE_FAILURE);
+
+    if (mbedtls_cipher_setup(&impl->ctx, info) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    if (mbedtls_cipher_cmac_starts(&impl->ctx, key, key_size_bits) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    result = OE_OK;
+
+done:
+    if (result != OE_OK && context)
+        mbedtls_cipher_free(&impl->ctx);
+
+    return result;
+}
+
+oe_result_t oe_aes_cmac_compute(
+    oe_aes_cmac_context_t* context,
+    const uint8_t* message,
+    size_t message_length,
+    oe_aes_cmac_t* aes_cmac)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_aes_cmac_context_impl_t* impl = (oe_aes_cmac_context_impl_t*)context;
+
+    if (context == NULL || aes_cmac == NULL)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_secure_zero_fill(aes_cmac->impl, sizeof(*aes_cmac));
+
+    if (mbedtls_cipher_cmac_reset(&impl->ctx) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    if (mbedtls_cipher_cmac_update(&impl->ctx, message, message_length) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    if (mbedtls_cipher_cmac_finish(&impl->ctx, (uint8_t*)aes_cmac->impl) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_aes_cmac_free(oe_aes_cmac_context_t* context)
+{
+    oe_aes_cmac_context_impl_t* impl = (oe_aes_cmac_context_impl_t*)context;
+
+    if (context)
+        mbedtls_cipher_free(&impl->ctx);
+}
@@ -24,6 +24,7 @@
 #include "cpuid.h"
 #include "init.h"
 #include "report.h"
+#include "switchless.h"
 #include "td.h"
 #include "thread.h"
 
@@ -169,6 +170,12 @@ static oe_result_t _handle_init_enclave(uint64_t arg_in)
                     OE_RAISE(OE_INVALID_PARAMETER);
 
                 oe_enclave = safe_args.enclave;
+
+                /* Switchless OCALLs may be made by global constructors */
+                OE_CHECK(oe_init_switchless_ocalls(safe_args.switchless_ring));
+
+                /* So may reads of the time */
+                OE_CHECK(oe_init_time_page(safe_args.time_page));
             }
 
             /* Call all enclave state initialization functions */
@@ -256,7 +263,7 @@ extern const size_t _oe_ecalls_table_size;
 /**
  * This is the preferred way to call enclave functions.
  */
-static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in)
 {
     oe_call_enclave_function_args_t args, *args_ptr;
     oe_result_t result = OE_OK;
@@ -381,7 +388,12 @@ static void _handle_ecall(
         }
         case OE_ECALL_CALL_ENCLAVE_FUNCTION:
         {
-            arg_out = _handle_call_enclave_function(arg_in);
+            arg_out = oe_handle_call_enclave_function(arg_in);
+            break;
+        }
+        case OE_ECALL_SWITCHLESS_WORKER:
+        {
+            arg_out = oe_handle_switchless_worker(arg_in);
             break;
         }
         case OE_ECALL_DESTRUCTOR:
@@ -435,8 +447,13 @@ done:
     // Release any thread-specific-data for this thread if returning from
     // a non-nested ECALL.
     if (td->depth == 1)
+    {
         oe_thread_destruct_specific();
 
+        /* Do not hold console output back while the thread is outside */
+        oe_host_flush();
+    }
+
     /* Remove ECALL context from front of td_t.ecalls list */
     td_pop_callsite(td);
 
@@ -527,6 +544,123 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _lookup_host_func_id()
+** _intern_host_func_id()
+**
+**     Enclave-side map from host function names to the IDs interned by the
+**     host (see _find_host_func() in host/calls.c). Once a name is known, the
+**     OE_OCALL_CALL_HOST request carries its ID instead of a copy of the name.
+**     The map is an open-addressed table whose entries are only removed when
+**     the enclave terminates, so lookups need no lock.
+**
+**==============================================================================
+*/
+
+#define HOST_FUNC_TABLE_SIZE (2 * OE_CALL_HOST_MAX_FUNCS)
+
+typedef struct _host_func_id
+{
+    uint64_t hash;
+    uint64_t id;
+    const char* volatile name;
+} HostFuncID;
+
+static HostFuncID _host_func_ids[HOST_FUNC_TABLE_SIZE];
+static size_t _num_host_func_ids;
+static oe_spinlock_t _host_func_ids_lock = OE_SPINLOCK_INITIALIZER;
+static bool _host_func_ids_atexit;
+
+static uint64_t _lookup_host_func_id(const char* name, uint64_t hash)
+{
+    for (size_t i = 0; i < HOST_FUNC_TABLE_SIZE; i++)
+    {
+        HostFuncID* entry =
+            &_host_func_ids[(hash + i) % HOST_FUNC_TABLE_SIZE];
+        const char* entry_name = entry->name;
+
+        if (!entry_name)
+            break;
+
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        if (entry->hash == hash && oe_strcmp(entry_name, name) == 0)
+            return entry->id;
+    }
+
+    return OE_CALL_HOST_FUNC_ID_NONE;
+}
+
+/* Free the interned names when the enclave terminates, before debug malloc
+ * checks for leaks */
+static void _free_host_func_ids(void)
+{
+    oe_spin_lock(&_host_func_ids_lock);
+
+    for (size_t i = 0; i < HOST_FUNC_TABLE_SIZE; i++)
+    {
+        oe_free((void*)_host_func_ids[i].name);
+        _host_func_ids[i].name = NULL;
+    }
+
+    _num_host_func_ids = 0;
+
+    oe_spin_unlock(&_host_func_ids_lock);
+}
+
+static void _intern_host_func_id(
+    const char* name,
+    size_t len,
+    uint64_t hash,
+    uint64_t id)
+{
+    if (id >= OE_CALL_HOST_MAX_FUNCS)
+        return;
+
+    oe_spin_lock(&_host_func_ids_lock);
+
+    if (!_host_func_ids_atexit)
+    {
+        if (oe_atexit(_free_host_func_ids) != 0)
+        {
+            oe_spin_unlock(&_host_func_ids_lock);
+            return;
+        }
+
+        _host_func_ids_atexit = true;
+    }
+
+    if (_num_host_func_ids < OE_CALL_HOST_MAX_FUNCS &&
+        _lookup_host_func_id(name, hash) == OE_CALL_HOST_FUNC_ID_NONE)
+    {
+        char* copy;
+
+        if ((copy = (char*)oe_malloc(len + 1)))
+        {
+            HostFuncID* entry = &_host_func_ids[hash % HOST_FUNC_TABLE_SIZE];
+
+            while (entry->name)
+            {
+                if (++entry == _host_func_ids + HOST_FUNC_TABLE_SIZE)
+                    entry = _host_func_ids;
+            }
+
+            oe_memcpy(copy, name, len + 1);
+            entry->hash = hash;
+            entry->id = id;
+
+            /* Publish the entry to lock-free lookups */
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            entry->name = copy;
+            _num_host_func_ids++;
+        }
+    }
+
+    oe_spin_unlock(&_host_func_ids_lock);
+}
+
 /*
 **==============================================================================
 **
@@ -539,20 +673,28 @@ oe_result_t oe_call_host(const char* func, void* args_in)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_host_args_t* args = NULL;
+    size_t len;
+    uint64_t hash;
+    uint64_t id;
 
     /* Reject invalid parameters */
     if (!func)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Initialize the arguments */
+    len = oe_strlen(func);
+    hash = oe_fnv1a_hash(func, len);
+    id = _lookup_host_func_id(func, hash);
+
+    /* Initialize the arguments. The name is only sent until the host has
+     * interned it. */
     {
-        size_t len = oe_strlen(func);
+        size_t name_len = (id == OE_CALL_HOST_FUNC_ID_NONE) ? len : 0;
         size_t total_len;
 
         OE_STATIC_ASSERT(sizeof(oe_call_host_args_t) < OE_SIZE_MAX);
         OE_CHECK(
             oe_safe_add_sizet(
-                len, 1 + sizeof(oe_call_host_args_t), &total_len));
+                name_len, 1 + sizeof(oe_call_host_args_t), &total_len));
 
         if (!(args = oe_host_alloc_for_call_host(total_len)))
         {
@@ -562,15 +704,21 @@ oe_result_t oe_call_host(const char* func, void* args_in)
             OE_RAISE(OE_OUT_OF_MEMORY);
         }
 
-        OE_CHECK(oe_memcpy_s(args->func, len + 1, func, len + 1));
+        OE_CHECK(oe_memcpy_s(args->func, name_len + 1, func, name_len));
+        args->func[name_len] = '\0';
 
         args->args = args_in;
         args->result = OE_UNEXPECTED;
+        args->func_id = id;
     }
 
     /* Call into the host */
     OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST, (int64_t)args, NULL));
 
+    /* Remember the ID the host assigned to this name */
+    if (id == OE_CALL_HOST_FUNC_ID_NONE)
+        _intern_host_func_id(func, len, hash, args->func_id);
+
     /* Check the result */
     OE_CHECK(args->result);
 
@@ -674,8 +822,9 @@ oe_result_t oe_call_host_function(
         args->result = OE_UNEXPECTED;
     }
 
-    /* Call the host function with this address */
-    OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST_FUNCTION, (int64_t)args, NULL));
+    /* Post the call to a host worker if possible, else exit to the host */
+    if (oe_switchless_call_host_function(args) != OE_OK)
+        OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST_FUNCTION, (int64_t)args, NULL));
 
     /* Check the result */
     OE_CHECK(args->result);
@@ -689,6 +838,29 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_allocate_ocall_buffer()
+** oe_free_ocall_buffer()
+**
+**     Marshaling buffers for oeedger8r-generated OCALL wrappers. These come
+**     from the per-thread host stack (see hoststack.c) rather than from
+**     oe_host_malloc(), which would cost an extra OCALL each way.
+**
+**==============================================================================
+*/
+
+void* oe_allocate_ocall_buffer(size_t size)
+{
+    return oe_host_alloc_for_call_host(size);
+}
+
+void oe_free_ocall_buffer(void* buffer)
+{
+    oe_host_free_for_call_host(buffer);
+}
+
 /*
 **==============================================================================
 **
@@ -918,6 +1090,11 @@ void _oe_notify_nested_exit_start(
 
 void oe_abort(void)
 {
+    // Write out any buffered console output while OCALLs still work. The
+    // buffer is emptied before the OCALL, so a nested abort cannot recurse.
+    if (__oe_enclave_status == OE_OK)
+        oe_host_flush();
+
     // Once it starts to crash, the state can only transit forward, not
     // backward.
     if (__oe_enclave_status < OE_ENCLAVE_ABORTING)
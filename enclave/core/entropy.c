@@ -5,12 +5,27 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/enclavelibc.h>
 
-uint64_t _rdrand(void)
+/* RDRAND may briefly run out of entropy under heavy use; the Intel DRNG
+ * guide recommends giving up after ten consecutive failures */
+#define RDRAND_RETRIES 10
+
+static bool _rdrand(uint64_t* r)
 {
-    uint64_t r;
-    __asm__ volatile("rdrand %0\n\t" : "=r"(r));
+    for (size_t i = 0; i < RDRAND_RETRIES; i++)
+    {
+        unsigned char ok;
+
+        __asm__ volatile("rdrand %0\n\t"
+                         "setc %1\n\t"
+                         : "=r"(*r), "=qm"(ok)
+                         :
+                         : "cc");
+
+        if (ok)
+            return true;
+    }
 
-    return r;
+    return false;
 }
 
 /*
@@ -39,7 +54,10 @@ int mbedtls_hardware_poll(
 
         while (n--)
         {
-            uint64_t x = _rdrand();
+            uint64_t x;
+
+            if (!_rdrand(&x))
+                goto done;
 
             if (oe_memcpy_s(p, sizeof(uint64_t), &x, sizeof(uint64_t)) != OE_OK)
                 goto done;
@@ -51,9 +69,12 @@ int mbedtls_hardware_poll(
     /* Copy remaining random bytes to output */
     {
         size_t r = len % sizeof(uint64_t);
-        uint64_t x = _rdrand();
+        uint64_t x;
         const unsigned char* q = (const unsigned char*)&x;
 
+        if (r && !_rdrand(&x))
+            goto done;
+
         while (r--)
             *p++ = *q++;
     }
@@ -98,40 +98,75 @@ char* oe_host_strndup(const char* str, size_t n)
     return p;
 }
 
-int oe_host_write(int device, const char* str, size_t len)
+/*
+**==============================================================================
+**
+** Host console output:
+**
+**     Each thread collects its output in td_t.host_output and writes it to
+**     the host with a single OE_OCALL_WRITEV when the buffer receives a
+**     newline, when it would overflow, when the output device changes, when
+**     oe_host_flush() is called and when the outermost ECALL returns. Writes
+**     that do not fit in the buffer are sent in the same OCALL as the
+**     buffered output that precedes them.
+**
+**==============================================================================
+*/
+
+typedef struct _host_iov
+{
+    const void* base;
+    size_t len;
+} HostIOV;
+
+static volatile bool _output_buffering = true;
+
+/* Write the given buffers to the host with one OCALL */
+static int _host_writev(int device, const HostIOV* iov, size_t iovcnt)
 {
     int ret = -1;
-    oe_print_args_t* args = NULL;
+    oe_writev_args_t* args = NULL;
+    size_t total_size;
+    size_t size;
+    char* data;
 
-    /* Reject invalid arguments */
-    if ((device != 0 && device != 1) || !str)
+    if (iovcnt > OE_WRITEV_MAX_IOV)
         goto done;
 
-    /* Determine the length of the string */
-    if (len == (size_t)-1)
-        len = oe_strlen(str);
+    /* Allocate space for the arguments followed by the data */
+    if (oe_safe_mul_sizet(iovcnt, sizeof(oe_writev_iov_t), &size) != OE_OK)
+        goto done;
 
-    /* Check for integer overflow and allocate space for the arguments followed
-     * by null-terminated string */
-    size_t total_size;
-    if (oe_safe_add_sizet(len, 1 + sizeof(oe_print_args_t), &total_size) !=
-        OE_OK)
+    if (oe_safe_add_sizet(size, sizeof(oe_writev_args_t), &total_size) != OE_OK)
         goto done;
 
-    if (!(args = (oe_print_args_t*)oe_host_alloc_for_call_host(total_size)))
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        if (oe_safe_add_sizet(total_size, iov[i].len, &total_size) != OE_OK)
+            goto done;
+    }
+
+    if (!(args = (oe_writev_args_t*)oe_host_alloc_for_call_host(total_size)))
         goto done;
 
     /* Initialize the arguments */
     args->device = device;
-    args->str = (char*)(args + 1);
+    args->iovcnt = iovcnt;
+    data = (char*)&args->iov[iovcnt];
 
-    if (oe_memcpy_s(args->str, len, str, len) != OE_OK)
-        goto done;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].len &&
+            oe_memcpy_s(data, iov[i].len, iov[i].base, iov[i].len) != OE_OK)
+            goto done;
 
-    args->str[len] = '\0';
+        args->iov[i].base = data;
+        args->iov[i].len = iov[i].len;
+        data += iov[i].len;
+    }
 
     /* Perform OCALL */
-    if (oe_ocall(OE_OCALL_WRITE, (uint64_t)args, NULL) != OE_OK)
+    if (oe_ocall(OE_OCALL_WRITEV, (uint64_t)args, NULL) != OE_OK)
         goto done;
 
     ret = 0;
@@ -141,6 +176,101 @@ done:
     return ret;
 }
 
+/* Write the buffered output of the given thread followed by 'str' */
+static int _flush_output(td_t* td, const char* str, size_t len)
+{
+    HostIOV iov[2];
+    size_t iovcnt = 0;
+    int device = (int)td->host_output_device;
+
+    if (td->host_output_size)
+    {
+        iov[iovcnt].base = td->host_output;
+        iov[iovcnt].len = td->host_output_size;
+        iovcnt++;
+    }
+
+    if (len)
+    {
+        iov[iovcnt].base = str;
+        iov[iovcnt].len = len;
+        iovcnt++;
+    }
+
+    /* Drop the buffered output even on failure so it is not repeated */
+    td->host_output_size = 0;
+
+    if (iovcnt == 0)
+        return 0;
+
+    return _host_writev(device, iov, iovcnt);
+}
+
+int oe_host_flush(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td_initialized(td))
+        return 0;
+
+    return _flush_output(td, NULL, 0);
+}
+
+void oe_host_set_output_buffering(bool enabled)
+{
+    _output_buffering = enabled;
+
+    /* Do not leave earlier output of this thread behind in the buffer */
+    if (!enabled)
+        oe_host_flush();
+}
+
+int oe_host_write(int device, const char* str, size_t len)
+{
+    td_t* td = oe_get_td();
+    bool newline = false;
+
+    /* Reject invalid arguments */
+    if ((device != 0 && device != 1) || !str)
+        return -1;
+
+    /* Determine the length of the string */
+    if (len == (size_t)-1)
+        len = oe_strlen(str);
+
+    /* Write through if buffering is off or there is no thread data yet */
+    if (!_output_buffering || !td_initialized(td))
+    {
+        HostIOV iov = {str, len};
+
+        if (td_initialized(td) && td->host_output_size)
+            _flush_output(td, NULL, 0);
+
+        return _host_writev(device, &iov, 1);
+    }
+
+    /* Keep output to stdout and stderr in order */
+    if (td->host_output_size && td->host_output_device != (uint32_t)device)
+        _flush_output(td, NULL, 0);
+
+    td->host_output_device = (uint32_t)device;
+
+    /* Send the buffer and the new data together if they do not fit */
+    if (len > sizeof(td->host_output) - td->host_output_size)
+        return _flush_output(td, str, len);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if ((td->host_output[td->host_output_size++] = str[i]) == '\n')
+            newline = true;
+    }
+
+    if (newline || td->host_output_size == sizeof(td->host_output))
+        return _flush_output(td, NULL, 0);
+
+    return 0;
+}
+
 int oe_host_vfprintf(int device, const char* fmt, oe_va_list ap_)
 {
     char buf[256];
@@ -9,16 +9,19 @@
  from) and one "standby" bucket. "active" put to standby on underflow (i.e.,
  freeing from a different bucket than the "active").
 
+ The buckets of a thread are kept in its td_t and survive from one ECALL to
+ the next, so a warm thread allocates without an OCALL. They are released
+ when the enclave terminates. Buckets all have the same size; allocations
+ that do not fit an empty bucket go directly to oe_host_malloc() and are
+ marked by a null bucket pointer.
+
 */
 
 #include <openenclave/enclave.h>
 #include <openenclave/internal/atexit.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/thread.h>
-
-#ifndef MAX
-#define MAX(a, b) (((a) > (b)) ? (a) : (b))
-#endif
+#include "td.h"
 
 struct Bucket;
 
@@ -49,8 +52,22 @@ typedef struct ThreadBuckets
     volatile Bucket* standby_host;
     Bucket cached; // valid if active_host != NULL
     ThreadBucketFlags flags;
+    struct ThreadBuckets* next; // in _thread_buckets_list
 } ThreadBuckets;
 
+// largest allocation that fits an empty bucket
+static const size_t _bucket_max_alloc =
+    _bucket_min_size - sizeof(Bucket) - sizeof(BucketElement);
+
+// slot in td_t holding the ThreadBuckets of the calling thread
+#ifndef OE_HOST_STACK_THREAD_SLOT
+#define OE_HOST_STACK_THREAD_SLOT (oe_get_td()->host_stack)
+#endif
+
+// ThreadBuckets of every thread that used the host stack, for rundown
+static ThreadBuckets* _thread_buckets_list;
+static oe_spinlock_t _thread_buckets_lock = OE_SPINLOCK_INITIALIZER;
+
 // oe_once() replacement to work around recursion limitation
 static struct OnceType
 {
@@ -71,8 +88,6 @@ static void _once(struct OnceType* once, void (*f)(void))
     }
 }
 
-static oe_thread_key_t _host_stack_tls_key;
-
 // cleanup handler for regular exit (must be visible to ocall-alloc test)
 void oe_free_thread_buckets(void* arg)
 {
@@ -91,9 +106,20 @@ void oe_free_thread_buckets(void* arg)
     tb->flags |= THREAD_BUCKET_FLAG_RUNDOWN;
 }
 
+// release the buckets of all threads when the enclave terminates
+static void _free_all_thread_buckets(void)
+{
+    oe_spin_lock(&_thread_buckets_lock);
+
+    for (ThreadBuckets* tb = _thread_buckets_list; tb; tb = tb->next)
+        oe_free_thread_buckets(tb);
+
+    oe_spin_unlock(&_thread_buckets_lock);
+}
+
 static void _host_stack_init(void)
 {
-    if (oe_thread_key_create(&_host_stack_tls_key, oe_free_thread_buckets))
+    if (oe_atexit(_free_all_thread_buckets))
     {
         oe_abort();
     }
@@ -104,14 +130,21 @@ static ThreadBuckets* _get_thread_buckets()
     ThreadBuckets* tb;
 
     _once(&_host_stack_initialized, _host_stack_init);
-    tb = oe_thread_getspecific(_host_stack_tls_key);
+    tb = (ThreadBuckets*)OE_HOST_STACK_THREAD_SLOT;
     if (tb == NULL)
     {
+        // allocated once per thread and never released, like the td_t
         if ((tb = (ThreadBuckets*)oe_sbrk(sizeof(ThreadBuckets))) == (void*)-1)
             return NULL;
 
         *tb = (ThreadBuckets){};
-        oe_thread_setspecific(_host_stack_tls_key, tb);
+
+        oe_spin_lock(&_thread_buckets_lock);
+        tb->next = _thread_buckets_list;
+        _thread_buckets_list = tb;
+        oe_spin_unlock(&_thread_buckets_lock);
+
+        OE_HOST_STACK_THREAD_SLOT = tb;
     }
 
     // Under normal operation, there is no reentrancy. There could be if the
@@ -169,14 +202,34 @@ static size_t _get_bucket_available_bytes(const Bucket* b)
     return b->size - b->base_free;
 }
 
+// allocation too large for a bucket, with a null bucket pointer
+static void* _alloc_direct(size_t size)
+{
+    volatile BucketElement* bucket_element;
+
+    if (size > OE_SIZE_MAX - sizeof(BucketElement))
+        return NULL;
+
+    bucket_element =
+        (BucketElement*)oe_host_malloc(size + sizeof(BucketElement));
+    if (bucket_element == NULL)
+        return NULL;
+
+    bucket_element->bucket = NULL;
+    return (void*)(&bucket_element->data);
+}
+
 void* oe_host_alloc_for_call_host(size_t size)
 {
     ThreadBuckets* tb; // deliberate non-init
     void* ret_val = NULL;
 
-    if (!size || (size > OE_INT32_MAX))
+    if (!size)
         return NULL;
 
+    if (size > _bucket_max_alloc)
+        return _alloc_direct(size);
+
     if ((tb = _get_thread_buckets()) == NULL)
         return NULL;
 
@@ -215,15 +268,15 @@ void* oe_host_alloc_for_call_host(size_t size)
             }
         }
 
+        // the old active bucket is only replaced while it holds allocations
+        // (all buckets have the same size), and comes back into rotation
+        // when they are freed
         if (is_host == NULL)
         {
-            size_t alloc_size =
-                MAX(size + sizeof(Bucket) + sizeof(BucketElement),
-                    _bucket_min_size);
-            if ((is_host = (Bucket*)oe_host_malloc(alloc_size)) == NULL)
+            if ((is_host = (Bucket*)oe_host_malloc(_bucket_min_size)) == NULL)
                 goto Exit;
 
-            is_host->size = tb->cached.size = alloc_size - sizeof(Bucket);
+            is_host->size = tb->cached.size = _bucket_min_size - sizeof(Bucket);
         }
 
         tb->cached.base_free = size + sizeof(BucketElement);
@@ -251,6 +304,12 @@ void oe_host_free_for_call_host(void* p)
     if (_fetch_bucket_element(bucket_element, &e))
         oe_abort();
 
+    if (e.bucket == NULL)
+    {
+        oe_host_free((void*)bucket_element);
+        return;
+    }
+
     tb = _get_thread_buckets();
     oe_assert(tb != NULL);
 
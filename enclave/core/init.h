@@ -5,6 +5,7 @@
 #define OE_INIT_H
 
 #include <openenclave/enclave.h>
+#include <openenclave/internal/time.h>
 #include "td.h"
 
 void oe_initialize_enclave();
@@ -13,4 +14,7 @@ void oe_call_init_functions(void);
 
 void oe_call_fini_functions(void);
 
+/* Validate and save the host time page (if any) passed by the host */
+oe_result_t oe_init_time_page(oe_time_page_t* page);
+
 #endif /* OE_INIT_H */
@@ -2,12 +2,14 @@
 // Licensed under the MIT License.
 
 #include <openenclave/bits/safecrt.h>
+#include <openenclave/bits/safemath.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/fault.h>
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/malloc.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
 #include "debugmalloc.h"
 
@@ -42,7 +44,136 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic pop
 
-/* Choose release mode or debug mode allocation functions */
+/*
+**==============================================================================
+**
+** Per-thread malloc caches (OE_USE_MALLOC_THREAD_CACHE):
+**
+**     Small chunks freed by a thread are kept in a cache owned by its TCS,
+**     with one list per dlmalloc chunk size, and handed back to the next
+**     allocation of the same size on that TCS without taking the global
+**     dlmalloc lock. Cached chunks remain allocated from the point of view of
+**     dlmalloc (and of oe_get_malloc_stats()). A chunk may be freed by a
+**     different thread than the one that allocated it. Allocations that miss
+**     the cache, large allocations and aligned allocations go to dlmalloc.
+**
+**==============================================================================
+*/
+
+#if defined(OE_USE_MALLOC_THREAD_CACHE) && !defined(OE_USE_DEBUG_MALLOC)
+
+/* Largest chunk size (including the dlmalloc header) kept in the cache */
+#define CACHE_MAX_CHUNK_SIZE 1024
+
+/* Maximum number of chunks kept per size */
+#define CACHE_MAX_CHUNKS 32
+
+#define CACHE_NUM_LISTS (CACHE_MAX_CHUNK_SIZE / MALLOC_ALIGNMENT + 1)
+
+typedef struct _cache_chunk
+{
+    struct _cache_chunk* next;
+} CacheChunk;
+
+typedef struct _malloc_cache
+{
+    CacheChunk* lists[CACHE_NUM_LISTS];
+    uint32_t counts[CACHE_NUM_LISTS];
+} MallocCache;
+
+static MallocCache* _get_cache(void)
+{
+    td_t* td = oe_get_td();
+
+    /* The cache lives as long as the TCS, across ECALLs */
+    if (!td->malloc_cache)
+        td->malloc_cache = dlcalloc(1, sizeof(MallocCache));
+
+    return (MallocCache*)td->malloc_cache;
+}
+
+/* Pop a cached chunk for a request of the given size (or return null) */
+static void* _cache_pop(size_t size)
+{
+    MallocCache* cache;
+    CacheChunk* chunk;
+    size_t index;
+
+    if (size > CACHE_MAX_CHUNK_SIZE)
+        return NULL;
+
+    index = request2size(size) / MALLOC_ALIGNMENT;
+
+    if (index >= CACHE_NUM_LISTS || !(cache = _get_cache()))
+        return NULL;
+
+    if (!(chunk = cache->lists[index]))
+        return NULL;
+
+    cache->lists[index] = chunk->next;
+    cache->counts[index]--;
+
+    return chunk;
+}
+
+/* Push a chunk into the cache. Returns false if the cache is full. */
+static bool _cache_push(void* ptr)
+{
+    MallocCache* cache;
+    CacheChunk* chunk = (CacheChunk*)ptr;
+    size_t index = chunksize(mem2chunk(ptr)) / MALLOC_ALIGNMENT;
+
+    if (index >= CACHE_NUM_LISTS || !(cache = _get_cache()))
+        return false;
+
+    if (cache->counts[index] == CACHE_MAX_CHUNKS)
+        return false;
+
+    chunk->next = cache->lists[index];
+    cache->lists[index] = chunk;
+    cache->counts[index]++;
+
+    return true;
+}
+
+static void* _cached_malloc(size_t size)
+{
+    void* p = _cache_pop(size);
+
+    return p ? p : dlmalloc(size);
+}
+
+static void* _cached_calloc(size_t nmemb, size_t size)
+{
+    size_t total;
+    void* p;
+
+    if (oe_safe_mul_sizet(nmemb, size, &total) != OE_OK)
+        return NULL;
+
+    if ((p = _cache_pop(total)))
+    {
+        oe_memset(p, 0, total);
+        return p;
+    }
+
+    return dlcalloc(nmemb, size);
+}
+
+static void* _cached_realloc(void* ptr, size_t size)
+{
+    return ptr ? dlrealloc(ptr, size) : _cached_malloc(size);
+}
+
+static void _cached_free(void* ptr)
+{
+    if (ptr && !_cache_push(ptr))
+        dlfree(ptr);
+}
+
+#endif /* defined(OE_USE_MALLOC_THREAD_CACHE) && !defined(OE_USE_DEBUG_MALLOC) */
+
+/* Choose release mode, thread cache mode or debug mode allocation functions */
 #if defined(OE_USE_DEBUG_MALLOC)
 #define MALLOC oe_debug_malloc
 #define CALLOC oe_debug_calloc
@@ -50,6 +181,13 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 #define MEMALIGN oe_debug_memalign
 #define POSIX_MEMALIGN oe_debug_posix_memalign
 #define FREE oe_debug_free
+#elif defined(OE_USE_MALLOC_THREAD_CACHE)
+#define MALLOC _cached_malloc
+#define CALLOC _cached_calloc
+#define REALLOC _cached_realloc
+#define MEMALIGN dlmemalign
+#define POSIX_MEMALIGN dlposix_memalign
+#define FREE _cached_free
 #else
 #define MALLOC dlmalloc
 #define CALLOC dlcalloc
@@ -166,12 +166,13 @@ static oe_result_t _oe_get_quote(
 
     oe_get_quote_args_t* args =
         (oe_get_quote_args_t*)oe_host_calloc(1, arg_size);
-    args->sgx_report = *sgx_report;
-    args->quote_size = *quote_size;
 
     if (args == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
+    args->sgx_report = *sgx_report;
+    args->quote_size = *quote_size;
+
     OE_CHECK(oe_ocall(OE_OCALL_GET_QUOTE, (uint64_t)args, NULL));
     result = args->result;
 
@@ -210,31 +211,48 @@ oe_result_t _oe_get_remote_report(
     if (opt_params != NULL || opt_params_size != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /*
-     * OCall: Get target info from Quoting Enclave.
-     * This involves a call to host. The target provided by targetinfo does not
-     * need to be trusted because returning a report is not an operation that
-     * requires privacy. The trust decision is one of integrity verification
-     * on the part of the report recipient.
-     */
-    OE_CHECK(_oe_get_sgx_target_info(&sgx_target_info));
-
-    /*
-     * Get enclave's local report passing in the quoting enclave's target info.
-     */
-    OE_CHECK(
-        _oe_get_local_report(
-            report_data,
-            report_data_size,
-            &sgx_target_info,
-            sizeof(sgx_target_info),
-            &sgx_report,
-            &sgx_report_size));
+    // The host caches the Quoting Enclave's target info and drops it when a
+    // quote fails, since the QE may have changed. Try once more in that case.
+    for (size_t attempt = 0; attempt < 2; attempt++)
+    {
+        size_t size = *report_buffer_size;
+
+        /*
+         * OCall: Get target info from Quoting Enclave.
+         * This involves a call to host. The target provided by targetinfo does
+         * not need to be trusted because returning a report is not an
+         * operation that requires privacy. The trust decision is one of
+         * integrity verification on the part of the report recipient.
+         */
+        OE_CHECK(_oe_get_sgx_target_info(&sgx_target_info));
+
+        /*
+         * Get enclave's local report passing in the quoting enclave's target
+         * info.
+         */
+        OE_CHECK(
+            _oe_get_local_report(
+                report_data,
+                report_data_size,
+                &sgx_target_info,
+                sizeof(sgx_target_info),
+                &sgx_report,
+                &sgx_report_size));
+
+        /*
+         * OCall: Get the quote for the local report.
+         */
+        result = _oe_get_quote(&sgx_report, report_buffer, &size);
+
+        if (result == OE_OK || result == OE_BUFFER_TOO_SMALL ||
+            result == OE_INVALID_PARAMETER || result == OE_OUT_OF_MEMORY)
+        {
+            *report_buffer_size = size;
+            break;
+        }
+    }
 
-    /*
-     * OCall: Get the quote for the local report.
-     */
-    OE_CHECK(_oe_get_quote(&sgx_report, report_buffer, report_buffer_size));
+    OE_CHECK(result);
 
     /*
      * Check that the entire report body in the returned quote matches the local
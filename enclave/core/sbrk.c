@@ -2,31 +2,36 @@
 // Licensed under the MIT License.
 
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/thread.h>
 
+/* Grow the heap by atomically advancing the break, so that threads extending
+ * the heap do not serialize on a lock. The break never moves back: callers
+ * other than dlmalloc (see hoststack.c and atexit.c) take memory from the
+ * break without dlmalloc's lock, so a trim could cut off their blocks. */
 void* oe_sbrk(ptrdiff_t increment)
 {
-    static unsigned char* _heap_next;
-    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
-    void* ptr = (void*)-1;
+    static volatile uint64_t _heap_next;
+    uint64_t heap_end = (uint64_t)__oe_get_heap_end();
+    uint64_t next;
 
-    oe_spin_lock(&_lock);
-    {
-        size_t remaining;
+    if (increment < 0)
+        return (void*)-1;
 
-        if (!_heap_next)
-            _heap_next = (unsigned char*)__oe_get_heap_base();
+    /* The break starts at the heap base */
+    if (!_heap_next)
+        oe_atomic_compare_and_swap(
+            &_heap_next, 0, (uint64_t)__oe_get_heap_base());
 
-        remaining = (unsigned char*)__oe_get_heap_end() - _heap_next;
+    do
+    {
+        next = _heap_next;
 
-        if (increment <= remaining)
-        {
-            ptr = _heap_next;
-            _heap_next += increment;
-        }
-    }
-    oe_spin_unlock(&_lock);
+        if ((uint64_t)increment > heap_end - next)
+            return (void*)-1;
+    } while (!oe_atomic_compare_and_swap(
+        &_heap_next, next, next + (uint64_t)increment));
 
-    return ptr;
+    return (void*)next;
 }
@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/print.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include "td.h"
+
+extern uint64_t __oe_enclave_status;
+
+/* The ring and its size are captured once, so the host cannot change the
+ * number of slots the enclave indexes into */
+static oe_switchless_ring_t* _ring;
+static uint64_t _num_slots;
+
+/* Check that the ring and all its slots lie outside the enclave */
+static oe_result_t _check_ring(oe_switchless_ring_t* ring, uint64_t* num_slots)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t n;
+    uint64_t size;
+
+    if (!oe_is_outside_enclave(ring, sizeof(oe_switchless_ring_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    n = ring->num_slots;
+
+    if (n == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_safe_mul_u64(n, sizeof(oe_switchless_slot_t), &size));
+    OE_CHECK(oe_safe_add_u64(size, sizeof(oe_switchless_ring_t), &size));
+
+    if (!oe_is_outside_enclave(ring, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *num_slots = n;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_init_switchless_ocalls(oe_switchless_ring_t* ring)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t num_slots;
+
+    if (!ring)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    OE_CHECK(_check_ring(ring, &num_slots));
+
+    _num_slots = num_slots;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    _ring = ring;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Claim a free slot, starting at a per-thread offset to spread contention */
+static oe_switchless_slot_t* _claim_slot(void)
+{
+    uint64_t start = ((uint64_t)oe_get_td() / OE_PAGE_SIZE) % _num_slots;
+
+    for (uint64_t i = 0; i < _num_slots; i++)
+    {
+        oe_switchless_slot_t* slot = &_ring->slots[(start + i) % _num_slots];
+
+        if (slot->state == OE_SWITCHLESS_SLOT_FREE &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_FREE,
+                OE_SWITCHLESS_SLOT_CLAIMED))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+oe_result_t oe_switchless_call_host_function(
+    oe_call_host_function_args_t* args)
+{
+    oe_switchless_slot_t* slot;
+    uint64_t spins = 0;
+
+    if (!_ring || __oe_enclave_status != OE_OK)
+        return OE_BUSY;
+
+    /* All slots busy: the workers are saturated */
+    if (!(slot = _claim_slot()))
+        return OE_BUSY;
+
+    slot->args = args;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    slot->state = OE_SWITCHLESS_SLOT_POSTED;
+
+    /* Wait for a worker to take the request */
+    while (slot->state == OE_SWITCHLESS_SLOT_POSTED)
+    {
+        if (++spins < OE_SWITCHLESS_OCALL_SPIN_BUDGET)
+        {
+            asm volatile("pause");
+            continue;
+        }
+
+        /* No worker took the request in time. Withdraw it unless a worker
+         * takes it concurrently, in which case wait for that worker. */
+        if (oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_FREE))
+        {
+            return OE_BUSY;
+        }
+    }
+
+    /* Wait for the worker to finish */
+    while (slot->state != OE_SWITCHLESS_SLOT_DONE)
+        asm volatile("pause");
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+    slot->state = OE_SWITCHLESS_SLOT_FREE;
+
+    return OE_OK;
+}
+
+/* Run one posted ECALL and report handler failures through its result */
+static void _run_ecall(void* args_ptr)
+{
+    oe_call_enclave_function_args_t* args =
+        (oe_call_enclave_function_args_t*)args_ptr;
+    oe_result_t result;
+
+    if (!oe_is_outside_enclave(args, sizeof(*args)))
+        return;
+
+    if ((result = oe_handle_call_enclave_function((uint64_t)args)) != OE_OK)
+        args->result = result;
+
+    /* The worker never returns to the host between requests, so write out
+     * console output as a returning ECALL would */
+    oe_host_flush();
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_switchless_worker()
+**
+**     Poll the ECALL request ring and run the posted ECALLs until the host
+**     stops the ring or the enclave aborts. Requests run nested inside this
+**     ECALL, so they may make OCALLs but share the thread-specific data of
+**     the worker thread. A worker that stays idle past its spin budget parks
+**     on the host with one OCALL, which returns when a request is posted or
+**     the ring is stopped.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_ring_t* ring = (oe_switchless_ring_t*)arg_in;
+    uint64_t num_slots;
+    uint64_t idle_count = 0;
+
+    OE_CHECK(_check_ring(ring, &num_slots));
+
+    while (!ring->stop && __oe_enclave_status == OE_OK)
+    {
+        bool found = false;
+
+        for (uint64_t i = 0; i < num_slots; i++)
+        {
+            oe_switchless_slot_t* slot = &ring->slots[i];
+
+            if (slot->state != OE_SWITCHLESS_SLOT_POSTED)
+                continue;
+
+            if (!oe_atomic_compare_and_swap(
+                    &slot->state,
+                    OE_SWITCHLESS_SLOT_POSTED,
+                    OE_SWITCHLESS_SLOT_RUNNING))
+                continue;
+
+            OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+            _run_ecall(slot->args);
+
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            slot->state = OE_SWITCHLESS_SLOT_DONE;
+            found = true;
+        }
+
+        if (found)
+            idle_count = 0;
+        else if (++idle_count < OE_SWITCHLESS_ECALL_IDLE_SPINS)
+            asm volatile("pause");
+        else
+        {
+            /* Poll again after waking, whether or not the wait failed */
+            oe_ocall(OE_OCALL_SWITCHLESS_WAIT, 0, NULL);
+            idle_count = 0;
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
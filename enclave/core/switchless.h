@@ -0,0 +1,25 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_ENCLAVE_CORE_SWITCHLESS_H
+#define _OE_ENCLAVE_CORE_SWITCHLESS_H
+
+#include <openenclave/internal/switchless.h>
+
+/* Validate and save the switchless OCALL ring passed by the host */
+oe_result_t oe_init_switchless_ocalls(oe_switchless_ring_t* ring);
+
+/* Post a call to a host worker thread without exiting the enclave. Returns
+ * OE_BUSY if switchless mode is off or no worker took the request, in which
+ * case the caller must perform a regular OCALL. */
+oe_result_t oe_switchless_call_host_function(
+    oe_call_host_function_args_t* args);
+
+/* Run the switchless ECALL worker loop on the calling thread until the host
+ * stops the given ring (OE_ECALL_SWITCHLESS_WORKER) */
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in);
+
+/* Run the oeedger8r-generated ECALL described by arg_in (see calls.c) */
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in);
+
+#endif /* _OE_ENCLAVE_CORE_SWITCHLESS_H */
@@ -4,6 +4,7 @@
 #include "thread.h"
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/hostalloc.h>
@@ -17,22 +18,219 @@
 **
 ** Host requests:
 **
+**     A thread that must wait first polls its wait_state for a wake-up before
+**     it asks the host to block it. Waking a thread that has not yet committed
+**     to blocking just posts a notification, so short waits cost no enclave
+**     transitions. The wait_state of each thread moves as follows:
+**
+**         IDLE -> NOTIFIED        (waker, thread not blocked in the host)
+**         NOTIFIED -> IDLE        (waiter, consumes the notification)
+**         IDLE -> PARKED          (waiter, about to block in the host)
+**         PARKED -> IDLE          (waker, then OE_OCALL_THREAD_WAKE)
+**
+**     As before, a wait may return without a matching wake-up; all callers
+**     recheck their condition and wait again.
+**
 **==============================================================================
 */
 
+#define WAIT_STATE_IDLE 0
+#define WAIT_STATE_NOTIFIED 1
+#define WAIT_STATE_PARKED 2
+
+static volatile uint64_t _spin_count = OE_THREAD_DEFAULT_SPIN_COUNT;
+
+/* Threads whose td_t.wait_stats hold counts (linked by wait_stats_next) */
+static td_t* _wait_stats_tds;
+static oe_spinlock_t _wait_stats_lock = OE_SPINLOCK_INITIALIZER;
+
+OE_STATIC_ASSERT(
+    sizeof(oe_thread_wait_stats_t) == sizeof(((td_t*)0)->wait_stats));
+
+void oe_thread_set_spin_count(uint64_t spin_count)
+{
+    _spin_count = spin_count;
+}
+
+oe_result_t oe_get_thread_wait_stats(oe_thread_wait_stats_t* stats)
+{
+    if (!stats)
+        return OE_INVALID_PARAMETER;
+
+    oe_memset(stats, 0, sizeof(oe_thread_wait_stats_t));
+
+    oe_spin_lock(&_wait_stats_lock);
+
+    for (td_t* td = _wait_stats_tds; td; td = (td_t*)td->wait_stats_next)
+    {
+        const volatile oe_thread_wait_stats_t* p =
+            (const volatile oe_thread_wait_stats_t*)td->wait_stats;
+
+        stats->spin_acquires += p->spin_acquires;
+        stats->spin_wakeups += p->spin_wakeups;
+        stats->host_waits += p->host_waits;
+        stats->elided_wakes += p->elided_wakes;
+        stats->host_wakes += p->host_wakes;
+    }
+
+    oe_spin_unlock(&_wait_stats_lock);
+
+    return OE_OK;
+}
+
+/* Pause between polls; also forces the polled fields to be reloaded */
+static __inline__ void _pause(void)
+{
+    asm volatile("pause" ::: "memory");
+}
+
+/* Counters of the calling thread. Only the owning thread updates them, so
+ * counting needs no atomics and does not share cache lines between threads */
+static oe_thread_wait_stats_t* _thread_stats(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td->wait_stats_listed)
+    {
+        oe_spin_lock(&_wait_stats_lock);
+        td->wait_stats_next = _wait_stats_tds;
+        _wait_stats_tds = td;
+        td->wait_stats_listed = 1;
+        oe_spin_unlock(&_wait_stats_lock);
+    }
+
+    return (oe_thread_wait_stats_t*)td->wait_stats;
+}
+
+static __inline__ void _count(uint64_t* counter)
+{
+    (*(volatile uint64_t*)counter)++;
+}
+
+/* Consume a pending notification. Returns false if there is none. */
+static bool _consume_notification(td_t* td)
+{
+    return oe_atomic_compare_and_swap(
+        &td->wait_state, WAIT_STATE_NOTIFIED, WAIT_STATE_IDLE);
+}
+
+/* Notify the waiter. Returns true if it is blocked in the host. */
+static bool _notify(oe_thread_data_t* waiter)
+{
+    td_t* td = (td_t*)waiter;
+
+    for (;;)
+    {
+        uint64_t state = td->wait_state;
+
+        if (state == WAIT_STATE_NOTIFIED)
+            return false;
+
+        if (oe_atomic_compare_and_swap(
+                &td->wait_state,
+                state,
+                state == WAIT_STATE_PARKED ? WAIT_STATE_IDLE
+                                           : WAIT_STATE_NOTIFIED))
+        {
+            return state == WAIT_STATE_PARKED;
+        }
+    }
+}
+
+/* Poll for a notification, then commit to blocking in the host. Returns true
+ * if the thread was notified, false if it must block. */
+static bool _poll_notification(td_t* td)
+{
+    for (uint64_t i = 0; i < _spin_count; i++)
+    {
+        if (td->wait_state == WAIT_STATE_NOTIFIED && _consume_notification(td))
+        {
+            _count(&_thread_stats()->spin_wakeups);
+            return true;
+        }
+
+        _pause();
+    }
+
+    /* Fails if a notification arrived after the last poll */
+    if (!oe_atomic_compare_and_swap(
+            &td->wait_state, WAIT_STATE_IDLE, WAIT_STATE_PARKED))
+    {
+        _consume_notification(td);
+        _count(&_thread_stats()->spin_wakeups);
+        return true;
+    }
+
+    _count(&_thread_stats()->host_waits);
+    return false;
+}
+
 static int _thread_wait(oe_thread_data_t* self)
 {
-    const void* tcs = td_to_tcs((td_t*)self);
+    td_t* td = (td_t*)self;
+    const void* tcs = td_to_tcs(td);
+    int ret = -1;
 
-    if (oe_ocall(OE_OCALL_THREAD_WAIT, (uint64_t)tcs, NULL) != OE_OK)
-        return -1;
+    if (_poll_notification(td))
+        return 0;
 
-    return 0;
+    if (oe_ocall(OE_OCALL_THREAD_WAIT, (uint64_t)tcs, NULL) == OE_OK)
+        ret = 0;
+
+    /* Still parked if the host returned without a wake-up */
+    oe_atomic_compare_and_swap(
+        &td->wait_state, WAIT_STATE_PARKED, WAIT_STATE_IDLE);
+
+    return ret;
 }
 
-static int _thread_wake(oe_thread_data_t* self)
+/* Like _thread_wait(), but sets timed_out if the deadline passed first */
+static int _thread_timed_wait(
+    oe_thread_data_t* self,
+    uint64_t deadline,
+    bool* timed_out)
 {
-    const void* tcs = td_to_tcs((td_t*)self);
+    td_t* td = (td_t*)self;
+    oe_thread_timed_wait_args_t* args = NULL;
+    uint64_t arg_out = 0;
+    int ret = -1;
+
+    *timed_out = false;
+
+    if (_poll_notification(td))
+        return 0;
+
+    if (!(args =
+              oe_host_alloc_for_call_host(sizeof(oe_thread_timed_wait_args_t))))
+        goto done;
+
+    args->tcs = td_to_tcs(td);
+    args->deadline = deadline;
+
+    if (oe_ocall(OE_OCALL_THREAD_TIMED_WAIT, (uint64_t)args, &arg_out) != OE_OK)
+        goto done;
+
+    *timed_out = arg_out != 0;
+    ret = 0;
+
+done:
+    oe_atomic_compare_and_swap(
+        &td->wait_state, WAIT_STATE_PARKED, WAIT_STATE_IDLE);
+    oe_host_free_for_call_host(args);
+    return ret;
+}
+
+static int _thread_wake(oe_thread_data_t* waiter)
+{
+    const void* tcs = td_to_tcs((td_t*)waiter);
+
+    if (!_notify(waiter))
+    {
+        _count(&_thread_stats()->elided_wakes);
+        return 0;
+    }
+
+    _count(&_thread_stats()->host_wakes);
 
     if (oe_ocall(OE_OCALL_THREAD_WAKE, (uint64_t)tcs, NULL) != OE_OK)
         return -1;
@@ -43,14 +241,41 @@ static int _thread_wake(oe_thread_data_t* self)
 static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
 {
     int ret = -1;
+    td_t* td = (td_t*)self;
     oe_thread_wake_wait_args_t* args = NULL;
 
+    /* The waiter was still spinning: just wait (and spin) for self */
+    if (!_notify(waiter))
+    {
+        _count(&_thread_stats()->elided_wakes);
+        return _thread_wait(self);
+    }
+
+    _count(&_thread_stats()->host_wakes);
+
+    /* Self was notified meanwhile: only the waiter needs the host */
+    if (!oe_atomic_compare_and_swap(
+            &td->wait_state, WAIT_STATE_IDLE, WAIT_STATE_PARKED))
+    {
+        _consume_notification(td);
+        _count(&_thread_stats()->spin_wakeups);
+
+        if (oe_ocall(
+                OE_OCALL_THREAD_WAKE, (uint64_t)td_to_tcs((td_t*)waiter), NULL) !=
+            OE_OK)
+            return -1;
+
+        return 0;
+    }
+
+    _count(&_thread_stats()->host_waits);
+
     if (!(args =
               oe_host_alloc_for_call_host(sizeof(oe_thread_wake_wait_args_t))))
         goto done;
 
     args->waiter_tcs = td_to_tcs((td_t*)waiter);
-    args->self_tcs = td_to_tcs((td_t*)self);
+    args->self_tcs = td_to_tcs(td);
 
     if (oe_ocall(OE_OCALL_THREAD_WAKE_WAIT, (uint64_t)args, NULL) != OE_OK)
         goto done;
@@ -58,6 +283,8 @@ static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
     ret = 0;
 
 done:
+    oe_atomic_compare_and_swap(
+        &td->wait_state, WAIT_STATE_PARKED, WAIT_STATE_IDLE);
     oe_host_free_for_call_host(args);
     return ret;
 }
@@ -116,11 +343,88 @@ static bool _queue_contains(Queue* queue, oe_thread_data_t* thread)
     return false;
 }
 
+static void _queue_remove(Queue* queue, oe_thread_data_t* thread)
+{
+    oe_thread_data_t* prev = NULL;
+    oe_thread_data_t* p;
+
+    for (p = queue->front; p; prev = p, p = p->next)
+    {
+        if (p == thread)
+        {
+            if (prev)
+                prev->next = p->next;
+            else
+                queue->front = p->next;
+
+            if (queue->back == p)
+                queue->back = prev;
+
+            return;
+        }
+    }
+}
+
 static __inline__ bool _queue_empty(Queue* queue)
 {
     return queue->front ? false : true;
 }
 
+/* Wake all threads on the queue, making one OCALL for all of the threads that
+ * are blocked in the host (see OE_OCALL_THREAD_WAKE_MULTIPLE) */
+static void _queue_wake_all(Queue* queue)
+{
+    oe_thread_wake_multiple_args_t* args = NULL;
+    oe_thread_data_t* p;
+    oe_thread_data_t* p_next = NULL;
+    size_t n = 0;
+
+    for (p = queue->front; p; p = p->next)
+        n++;
+
+    if (n > 1)
+        args = oe_host_alloc_for_call_host(
+            sizeof(oe_thread_wake_multiple_args_t) + n * sizeof(void*));
+
+    /* Without a buffer, wake the threads one at a time */
+    if (!args)
+    {
+        for (p = queue->front; p; p = p_next)
+        {
+            p_next = p->next;
+            _thread_wake(p);
+        }
+
+        return;
+    }
+
+    args->num_tcs = 0;
+
+    for (p = queue->front; p; p = p_next)
+    {
+        // p could wake up and immediately use a synchronization
+        // primitive that could modify the next field.
+        // Therefore fetch the next thread before waking up p.
+        p_next = p->next;
+
+        const void* tcs = td_to_tcs((td_t*)p);
+
+        if (_notify(p))
+            args->tcs[args->num_tcs++] = tcs;
+        else
+            _count(&_thread_stats()->elided_wakes);
+    }
+
+    if (args->num_tcs == 1)
+        oe_ocall(OE_OCALL_THREAD_WAKE, (uint64_t)args->tcs[0], NULL);
+    else if (args->num_tcs > 1)
+        oe_ocall(OE_OCALL_THREAD_WAKE_MULTIPLE, (uint64_t)args, NULL);
+
+    _thread_stats()->host_wakes += args->num_tcs;
+
+    oe_host_free_for_call_host(args);
+}
+
 /*
 **==============================================================================
 **
@@ -220,7 +524,8 @@ static int _mutex_lock(oe_mutex_impl_t* m, oe_thread_data_t* self)
     return -1;
 }
 
-oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
+/* Lock the mutex, waiting until the deadline if not null */
+static oe_result_t _mutex_wait(oe_mutex_t* mutex, const uint64_t* deadline)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
     oe_thread_data_t* self = oe_get_thread_data();
@@ -228,9 +533,27 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
     if (!m)
         return OE_INVALID_PARAMETER;
 
+    if (oe_mutex_trylock(mutex) == OE_OK)
+        return OE_OK;
+
+    /* Poll for the owner to release the mutex before joining the queue */
+    for (uint64_t i = 0; i < _spin_count; i++)
+    {
+        _pause();
+
+        if (m->owner == NULL && m->queue.front == NULL &&
+            oe_mutex_trylock(mutex) == OE_OK)
+        {
+            _count(&_thread_stats()->spin_acquires);
+            return OE_OK;
+        }
+    }
+
     /* Loop until SELF obtains mutex */
     for (;;)
     {
+        bool timed_out = false;
+
         oe_spin_lock(&m->lock);
         {
             /* Attempt to acquire lock */
@@ -250,12 +573,52 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
         oe_spin_unlock(&m->lock);
 
         /* Ask host to wait for an event on this thread */
-        _thread_wait(self);
+        if (!deadline)
+            _thread_wait(self);
+        else
+            _thread_timed_wait(self, *deadline, &timed_out);
+
+        if (timed_out)
+        {
+            oe_thread_data_t* waiter = NULL;
+
+            oe_spin_lock(&m->lock);
+            {
+                /* The mutex may have been handed to this thread meanwhile */
+                if (_mutex_lock(m, self) == 0)
+                {
+                    oe_spin_unlock(&m->lock);
+                    return OE_OK;
+                }
+
+                _queue_remove(&m->queue, self);
+
+                /* Pass on a wake-up that may have been meant for self */
+                if (m->owner == NULL)
+                    waiter = m->queue.front;
+            }
+            oe_spin_unlock(&m->lock);
+
+            if (waiter)
+                _thread_wake(waiter);
+
+            return OE_TIMEOUT;
+        }
     }
 
     /* Unreachable! */
 }
 
+oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
+{
+    return _mutex_wait(mutex, NULL);
+}
+
+oe_result_t oe_mutex_timedlock(oe_mutex_t* mutex, uint64_t deadline)
+{
+    return _mutex_wait(mutex, &deadline);
+}
+
 oe_result_t oe_mutex_trylock(oe_mutex_t* mutex)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
@@ -409,10 +772,15 @@ oe_result_t oe_cond_destroy(oe_cond_t* condition)
     return OE_OK;
 }
 
-oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+/* Wait on the condition, until the deadline if not null */
+static oe_result_t _cond_wait(
+    oe_cond_t* condition,
+    oe_mutex_t* mutex,
+    const uint64_t* deadline)
 {
     oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
     oe_thread_data_t* self = oe_get_thread_data();
+    oe_result_t result = OE_OK;
 
     if (!cond || !mutex)
         return OE_INVALID_PARAMETER;
@@ -427,15 +795,28 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
         /* Unlock this mutex and get the waiter at the front of the queue */
         if (_mutex_unlock(mutex, &waiter) != 0)
         {
+            _queue_remove((Queue*)&cond->queue, self);
             oe_spin_unlock(&cond->lock);
             return OE_BUSY;
         }
 
         for (;;)
         {
+            bool timed_out = false;
+
             oe_spin_unlock(&cond->lock);
             {
-                if (waiter)
+                if (deadline)
+                {
+                    if (waiter)
+                    {
+                        _thread_wake(waiter);
+                        waiter = NULL;
+                    }
+
+                    _thread_timed_wait(self, *deadline, &timed_out);
+                }
+                else if (waiter)
                 {
                     _thread_wake_wait(waiter, self);
                     waiter = NULL;
@@ -450,12 +831,32 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
             /* If self is no longer in the queue, then it was selected */
             if (!_queue_contains((Queue*)&cond->queue, self))
                 break;
+
+            if (timed_out)
+            {
+                _queue_remove((Queue*)&cond->queue, self);
+                result = OE_TIMEOUT;
+                break;
+            }
         }
     }
     oe_spin_unlock(&cond->lock);
     oe_mutex_lock(mutex);
 
-    return OE_OK;
+    return result;
+}
+
+oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+{
+    return _cond_wait(condition, mutex, NULL);
+}
+
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* condition,
+    oe_mutex_t* mutex,
+    uint64_t deadline)
+{
+    return _cond_wait(condition, mutex, &deadline);
 }
 
 oe_result_t oe_cond_signal(oe_cond_t* condition)
@@ -494,15 +895,7 @@ oe_result_t oe_cond_broadcast(oe_cond_t* condition)
     }
     oe_spin_unlock(&cond->lock);
 
-    oe_thread_data_t* p_next = NULL;
-    for (oe_thread_data_t* p = waiters.front; p; p = p_next)
-    {
-        // p could wake up and immediately use a synchronization
-        // primitive that could modify the next field.
-        // Therefore fetch the next thread before waking up p.
-        p_next = p->next;
-        _thread_wake(p);
-    }
+    _queue_wake_all(&waiters);
 
     return OE_OK;
 }
@@ -554,16 +947,26 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
     oe_thread_data_t* self = oe_get_thread_data();
+    bool spun = false;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    // Poll for the writer to finish before joining the queue.
+    for (uint64_t i = 0; i < _spin_count && rw_lock->writer != NULL; i++)
+    {
+        _pause();
+        spun = true;
+    }
+
     oe_spin_lock(&rw_lock->lock);
 
     // Wait for writer to finish.
     // Multiple readers can concurrently operate.
     while (rw_lock->writer != NULL)
     {
+        spun = false;
+
         // Add self to list of waiters, and go to wait state.
         if (!_queue_contains(&rw_lock->queue, self))
             _queue_push_back(&rw_lock->queue, self);
@@ -579,6 +982,9 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
     // Increment number of readers.
     rw_lock->readers++;
 
+    if (spun)
+        _count(&_thread_stats()->spin_acquires);
+
     oe_spin_unlock(&rw_lock->lock);
 
     return OE_OK;
@@ -625,8 +1031,7 @@ static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
 
     // Wake the waiters in FIFO order. However actual acquisition of the lock
     // will be dependent on OS scheduling of the threads.
-    while ((p = _queue_pop_front(&waiters)))
-        _thread_wake(p);
+    _queue_wake_all(&waiters);
 
     return OE_OK;
 }
@@ -662,6 +1067,7 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
     oe_thread_data_t* self = oe_get_thread_data();
+    bool spun = false;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
@@ -675,9 +1081,29 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
         return OE_BUSY;
     }
 
+    // Poll for readers and any other writer to finish before joining the
+    // queue.
+    if (rw_lock->readers > 0 || rw_lock->writer != NULL)
+    {
+        oe_spin_unlock(&rw_lock->lock);
+
+        for (uint64_t i = 0; i < _spin_count; i++)
+        {
+            _pause();
+            spun = true;
+
+            if (rw_lock->readers == 0 && rw_lock->writer == NULL)
+                break;
+        }
+
+        oe_spin_lock(&rw_lock->lock);
+    }
+
     // Wait for all readers and any other writer to finish.
     while (rw_lock->readers > 0 || rw_lock->writer != NULL)
     {
+        spun = false;
+
         // Add self to list of waiters, and go to wait state.
         if (!_queue_contains(&rw_lock->queue, self))
             _queue_push_back(&rw_lock->queue, self);
@@ -694,6 +1120,9 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
     rw_lock->writer = self;
     oe_spin_unlock(&rw_lock->lock);
 
+    if (spun)
+        _count(&_thread_stats()->spin_acquires);
+
     return OE_OK;
 }
 
@@ -1,8 +1,26 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/time.h>
+#include <openenclave/internal/utils.h>
+#include "init.h"
+
+/* Attempts to read a consistent snapshot of the time page before falling
+ * back to an OCALL (the host holds the page only briefly) */
+#define TIME_PAGE_READ_ATTEMPTS 64
+
+static const uint64_t _MSEC_TO_NSEC = 1000000UL;
+
+/* The host time page, or null if the host does not publish one */
+static oe_time_page_t* _time_page;
+
+static volatile oe_time_policy_t _time_policy = OE_TIME_POLICY_SHARED_PAGE;
+
+/* Largest monotonic reading returned so far */
+static volatile uint64_t _last_monotonic;
 
 int oe_sleep(uint64_t milliseconds)
 {
@@ -18,11 +36,121 @@ done:
     return ret;
 }
 
+oe_result_t oe_init_time_page(oe_time_page_t* page)
+{
+    if (!page)
+        return OE_OK;
+
+    if (!oe_is_outside_enclave(page, sizeof(oe_time_page_t)))
+        return OE_INVALID_PARAMETER;
+
+    _time_page = page;
+
+    return OE_OK;
+}
+
+int oe_set_time_policy(oe_time_policy_t policy)
+{
+    if (policy != OE_TIME_POLICY_SHARED_PAGE && policy != OE_TIME_POLICY_OCALL)
+        return -1;
+
+    _time_policy = policy;
+
+    return 0;
+}
+
+/* Read one clock from the time page. Returns false if the page is absent,
+ * disabled by the policy or did not settle. */
+static bool _read_time_page(oe_clock_t clock, uint64_t* value)
+{
+    oe_time_page_t* page = _time_page;
+
+    if (!page || _time_policy != OE_TIME_POLICY_SHARED_PAGE)
+        return false;
+
+    for (size_t i = 0; i < TIME_PAGE_READ_ATTEMPTS; i++)
+    {
+        uint64_t sequence = page->sequence;
+        uint64_t v;
+
+        /* Wait for the host to finish an update */
+        if (sequence & 1)
+        {
+            asm volatile("pause" ::: "memory");
+            continue;
+        }
+
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        if (clock == OE_CLOCK_MONOTONIC)
+            v = page->monotonic;
+        else
+            v = page->realtime;
+
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        if (page->sequence == sequence)
+        {
+            *value = v;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Never return a monotonic reading older than one already returned */
+static uint64_t _clamp_monotonic(uint64_t value)
+{
+    for (;;)
+    {
+        uint64_t last = _last_monotonic;
+
+        if (value <= last)
+            return last;
+
+        if (oe_atomic_compare_and_swap(&_last_monotonic, last, value))
+            return value;
+    }
+}
+
+uint64_t oe_get_clock_time(oe_clock_t clock)
+{
+    uint64_t ret = (uint64_t)-1;
+    uint64_t arg_in;
+
+    if (clock == OE_CLOCK_REALTIME)
+        arg_in = OE_GET_TIME_REALTIME_NSEC;
+    else if (clock == OE_CLOCK_MONOTONIC)
+        arg_in = OE_GET_TIME_MONOTONIC_NSEC;
+    else
+        goto done;
+
+    if (!_read_time_page(clock, &ret))
+    {
+        if (oe_ocall(OE_OCALL_GET_TIME, arg_in, &ret) != OE_OK)
+        {
+            ret = (uint64_t)-1;
+            goto done;
+        }
+    }
+
+    if (clock == OE_CLOCK_MONOTONIC)
+        ret = _clamp_monotonic(ret);
+
+done:
+
+    return ret;
+}
+
 uint64_t oe_get_time(void)
 {
     uint64_t ret = (uint64_t)-1;
 
-    if (oe_ocall(OE_OCALL_GET_TIME, 0, &ret) != OE_OK)
+    if (_read_time_page(OE_CLOCK_REALTIME, &ret))
+        return ret / _MSEC_TO_NSEC;
+
+    if (oe_ocall(OE_OCALL_GET_TIME, OE_GET_TIME_MSEC, &ret) != OE_OK)
     {
         ret = (uint32_t)-1;
         goto done;
@@ -3,54 +3,72 @@
 
 #include "random.h"
 #include <mbedtls/ctr_drbg.h>
-#include <mbedtls/entropy.h>
+#include <mbedtls/entropy_poll.h>
 #include <openenclave/enclave.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/random.h>
-#include <openenclave/internal/thread.h>
+#include <openenclave/internal/sgxtypes.h>
 
 /*
 **==============================================================================
 **
 ** Local definitions
 **
+**     Every thread (TCS) owns a CTR_DRBG instance that lives in its td_t, so
+**     threads never share generator state or contend for a lock. Each
+**     instance is seeded from the CPU (mbedtls_hardware_poll) the first time
+**     its thread asks for random bytes and is reseeded from the same source
+**     every _reseed_interval requests.
+**
 **==============================================================================
 */
 
-static mbedtls_ctr_drbg_context _drbg;
-static mbedtls_entropy_context _entropy;
+OE_STATIC_ASSERT(
+    sizeof(mbedtls_ctr_drbg_context) <= sizeof(((td_t*)0)->drbg));
+
+static volatile int _reseed_interval = MBEDTLS_CTR_DRBG_RESEED_INTERVAL;
 
-static oe_result_t _seed_entropy_source()
+/* Entropy callback of the CTR_DRBG instances */
+static int _get_entropy(void* data, unsigned char* output, size_t len)
 {
-    oe_result_t result = OE_UNEXPECTED;
+    size_t olen = 0;
 
-    mbedtls_ctr_drbg_init(&_drbg);
-    mbedtls_entropy_init(&_entropy);
+    if (mbedtls_hardware_poll(data, output, len, &olen) != 0 || olen != len)
+        return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 
-    OE_CHECK(
-        mbedtls_ctr_drbg_seed(
-            &_drbg, mbedtls_entropy_func, &_entropy, NULL, 0));
+    return 0;
+}
 
-    result = OE_OK;
+/* Get the generator of the calling thread, seeding it on first use */
+static mbedtls_ctr_drbg_context* _get_thread_drbg(void)
+{
+    td_t* td = oe_get_td();
+    mbedtls_ctr_drbg_context* drbg = (mbedtls_ctr_drbg_context*)td->drbg;
+    int reseed_interval = _reseed_interval;
 
-done:
-    return result;
-}
+    if (!td->drbg_seeded)
+    {
+        mbedtls_ctr_drbg_init(drbg);
 
-static oe_result_t _seed_result = OE_UNEXPECTED;
-static oe_once_t _seed_once = OE_ONCE_INIT;
+        if (mbedtls_ctr_drbg_seed(drbg, _get_entropy, NULL, NULL, 0) != 0)
+        {
+            mbedtls_ctr_drbg_free(drbg);
+            return NULL;
+        }
 
-/* Wrapper to set file-scope _seed_result */
-static void _seed_entropy_source_once()
-{
-    _seed_result = _seed_entropy_source();
+        td->drbg_seeded = 1;
+    }
+
+    if (drbg->reseed_interval != reseed_interval)
+        mbedtls_ctr_drbg_set_reseed_interval(drbg, reseed_interval);
+
+    return drbg;
 }
 
 mbedtls_ctr_drbg_context* oe_mbedtls_get_drbg()
 {
-    oe_once(&_seed_once, _seed_entropy_source_once);
-    return &_drbg;
+    return _get_thread_drbg();
 }
 
 /*
@@ -72,19 +90,32 @@ oe_result_t oe_random(void* data, size_t size)
 oe_result_t oe_random_internal(void* data, size_t size)
 {
     oe_result_t result = OE_UNEXPECTED;
-    int rc;
+    mbedtls_ctr_drbg_context* drbg;
+    unsigned char* p = (unsigned char*)data;
+
+    if (!data && size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Seed the generator of this thread on the first call */
+    if (!(drbg = _get_thread_drbg()))
+        OE_RAISE(OE_FAILURE);
 
-    /* Seed the entropy source on the first call */
+    /* The instance is private to this thread, so bypass the locking
+     * mbedtls_ctr_drbg_random(). Large requests are split into the largest
+     * chunks CTR_DRBG generates at once. */
+    while (size)
     {
-        oe_once(&_seed_once, _seed_entropy_source_once);
-        OE_CHECK(_seed_result);
-    }
+        size_t n = size;
 
-    /* Generate random data (synchronize access to _drbg instance) */
-    rc = mbedtls_ctr_drbg_random(&_drbg, data, size);
+        if (n > MBEDTLS_CTR_DRBG_MAX_REQUEST)
+            n = MBEDTLS_CTR_DRBG_MAX_REQUEST;
 
-    if (rc != 0)
-        OE_RAISE(OE_FAILURE);
+        if (mbedtls_ctr_drbg_random_with_add(drbg, p, n, NULL, 0) != 0)
+            OE_RAISE(OE_FAILURE);
+
+        p += n;
+        size -= n;
+    }
 
     result = OE_OK;
 
@@ -92,3 +123,13 @@ done:
 
     return result;
 }
+
+oe_result_t oe_random_set_reseed_interval(uint32_t interval)
+{
+    if (interval == 0 || interval > MBEDTLS_CTR_DRBG_RESEED_INTERVAL)
+        return OE_INVALID_PARAMETER;
+
+    _reseed_interval = (int)interval;
+
+    return OE_OK;
+}
@@ -5,6 +5,7 @@
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/bits/types.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atexit.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/cmac.h>
 #include <openenclave/internal/enclavelibc.h>
@@ -12,6 +13,7 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include "../common/quote.h"
 
@@ -42,6 +44,196 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** Report key cache:
+**
+**     The report key of this enclave for a given KEYID does not change, and
+**     the KEYID of reports only changes when the platform restarts. The
+**     AES-CMAC key schedule of the report key is therefore kept for the last
+**     few KEYIDs seen, which saves an EGETKEY and a key setup per local
+**     report. _report_keys_lock only covers the lookup and the choice of an
+**     entry; the key setup and the AES-CMAC computations use the lock of the
+**     entry, so reports with different KEYIDs are verified concurrently.
+**     Entries in use are not evicted. Evicted keys are zeroed, and the cache
+**     is freed when the enclave terminates.
+**
+**==============================================================================
+*/
+
+#define REPORT_KEY_CACHE_SIZE 4
+
+typedef struct _report_key
+{
+    /* The entry holds keyid (protected by _report_keys_lock) */
+    bool valid;
+    uint8_t keyid[SGX_KEYID_SIZE];
+
+    /* Number of threads using the entry (protected by _report_keys_lock) */
+    size_t refs;
+
+    /* Serializes the setup and the use of cmac */
+    oe_mutex_t lock;
+
+    /* The key schedule in cmac is set up (protected by lock) */
+    bool ready;
+    oe_aes_cmac_context_t cmac;
+} report_key_t;
+
+static report_key_t _report_keys[REPORT_KEY_CACHE_SIZE];
+static size_t _report_keys_next;
+static bool _report_keys_atexit;
+static oe_mutex_t _report_keys_lock = OE_MUTEX_INITIALIZER;
+
+static void _evict_report_key(report_key_t* report_key)
+{
+    if (report_key->ready)
+        oe_aes_cmac_free(&report_key->cmac);
+
+    report_key->valid = false;
+    report_key->ready = false;
+    oe_secure_zero_fill(report_key->keyid, sizeof(report_key->keyid));
+    oe_secure_zero_fill(&report_key->cmac, sizeof(report_key->cmac));
+}
+
+static void _free_report_keys(void)
+{
+    oe_mutex_lock(&_report_keys_lock);
+
+    for (size_t i = 0; i < REPORT_KEY_CACHE_SIZE; i++)
+    {
+        if (_report_keys[i].refs == 0)
+            _evict_report_key(&_report_keys[i]);
+    }
+
+    oe_mutex_unlock(&_report_keys_lock);
+}
+
+/* Find or add the entry for the KEYID of the report and take a reference to
+ * it. Returns NULL if every entry is in use. */
+static report_key_t* _acquire_report_key(const sgx_report_t* sgx_report)
+{
+    report_key_t* report_key = NULL;
+
+    oe_mutex_lock(&_report_keys_lock);
+
+    for (size_t i = 0; i < REPORT_KEY_CACHE_SIZE; i++)
+    {
+        if (_report_keys[i].valid &&
+            oe_memcmp(
+                _report_keys[i].keyid,
+                sgx_report->keyid,
+                sizeof(sgx_report->keyid)) == 0)
+        {
+            report_key = &_report_keys[i];
+            break;
+        }
+    }
+
+    if (!report_key)
+    {
+        if (!_report_keys_atexit)
+        {
+            if (oe_atexit(_free_report_keys) != 0)
+                goto done;
+
+            _report_keys_atexit = true;
+        }
+
+        /* Replace the next entry that is not in use */
+        for (size_t i = 0; i < REPORT_KEY_CACHE_SIZE && !report_key; i++)
+        {
+            report_key_t* p = &_report_keys[_report_keys_next];
+
+            _report_keys_next = (_report_keys_next + 1) % REPORT_KEY_CACHE_SIZE;
+
+            if (p->refs == 0)
+                report_key = p;
+        }
+
+        if (!report_key)
+            goto done;
+
+        _evict_report_key(report_key);
+        oe_secure_memcpy(
+            report_key->keyid, sgx_report->keyid, sizeof(sgx_report->keyid));
+        report_key->valid = true;
+    }
+
+    report_key->refs++;
+
+done:
+    oe_mutex_unlock(&_report_keys_lock);
+    return report_key;
+}
+
+static void _release_report_key(report_key_t* report_key)
+{
+    oe_mutex_lock(&_report_keys_lock);
+    report_key->refs--;
+    oe_mutex_unlock(&_report_keys_lock);
+}
+
+// Compute the AES-CMAC of the report body with the report key of its KEYID.
+static oe_result_t _compute_report_cmac(
+    const sgx_report_t* sgx_report,
+    oe_aes_cmac_t* aes_cmac)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    report_key_t* report_key = NULL;
+    sgx_key_t sgx_key = {{0}};
+
+    // Without a free cache entry, compute the AES-CMAC with a fresh key.
+    if (!(report_key = _acquire_report_key(sgx_report)))
+    {
+        OE_CHECK(_oe_get_report_key(sgx_report, &sgx_key));
+        OE_CHECK(
+            oe_aes_cmac_sign(
+                (uint8_t*)&sgx_key,
+                sizeof(sgx_key),
+                (const uint8_t*)&sgx_report->body,
+                sizeof(sgx_report->body),
+                aes_cmac));
+
+        result = OE_OK;
+        goto done;
+    }
+
+    oe_mutex_lock(&report_key->lock);
+
+    // The first user of a new entry sets up its key schedule.
+    if (!report_key->ready)
+    {
+        OE_CHECK(_oe_get_report_key(sgx_report, &sgx_key));
+        OE_CHECK(
+            oe_aes_cmac_init(
+                &report_key->cmac, (uint8_t*)&sgx_key, sizeof(sgx_key)));
+        report_key->ready = true;
+    }
+
+    OE_CHECK(
+        oe_aes_cmac_compute(
+            &report_key->cmac,
+            (const uint8_t*)&sgx_report->body,
+            sizeof(sgx_report->body),
+            aes_cmac));
+
+    result = OE_OK;
+
+done:
+    if (report_key)
+    {
+        oe_mutex_unlock(&report_key->lock);
+        _release_report_key(report_key);
+    }
+
+    // Cleanup secret.
+    oe_secure_zero_fill(&sgx_key, sizeof(sgx_key));
+
+    return result;
+}
+
 // oe_verify_report needs crypto library's cmac computation. oecore does not
 // have crypto functionality. Hence oe_verify report is implemented here instead
 // of in oecore. Also see ECall_HandleVerifyReport below.
@@ -52,12 +244,11 @@ oe_result_t oe_verify_report(
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_report_t oe_report = {0};
-    sgx_key_t sgx_key = {{0}};
     oe_report_header_t* header = (oe_report_header_t*)report;
 
     sgx_report_t* sgx_report = NULL;
 
-    const size_t aes_cmac_length = sizeof(sgx_key);
+    const size_t aes_cmac_length = sizeof(sgx_key_t);
     oe_aes_cmac_t report_aes_cmac = {{0}};
     oe_aes_cmac_t computed_aes_cmac = {{0}};
 
@@ -81,15 +272,7 @@ oe_result_t oe_verify_report(
     {
         sgx_report = (sgx_report_t*)header->report;
 
-        OE_CHECK(_oe_get_report_key(sgx_report, &sgx_key));
-
-        OE_CHECK(
-            oe_aes_cmac_sign(
-                (uint8_t*)&sgx_key,
-                sizeof(sgx_key),
-                (uint8_t*)&sgx_report->body,
-                sizeof(sgx_report->body),
-                &computed_aes_cmac));
+        OE_CHECK(_compute_report_cmac(sgx_report, &computed_aes_cmac));
 
         // Fetch cmac from sgx_report.
         // Note: sizeof(sgx_report->mac) <= sizeof(oe_aes_cmac_t).
@@ -110,9 +293,49 @@ oe_result_t oe_verify_report(
     result = OE_OK;
 
 done:
-    // Cleanup secret.
-    oe_secure_zero_fill(&sgx_key, sizeof(sgx_key));
+    return result;
+}
 
+// Reports are verified one after another inside the enclave. A host that
+// needs concurrency can call this function from several threads.
+oe_result_t oe_verify_reports(
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    oe_result_t* results,
+    oe_report_t* parsed_reports)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    size_t* first = NULL;
+
+    if (!reports || !report_sizes || !results)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(first = (size_t*)oe_calloc(count ? count : 1, sizeof(size_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(oe_find_duplicate_reports(reports, report_sizes, count, first));
+
+    result = OE_OK;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        oe_report_t* parsed_report = parsed_reports ? &parsed_reports[i] : NULL;
+
+        // Identical reports share the result of the first one.
+        if (first[i] == i)
+            results[i] =
+                oe_verify_report(reports[i], report_sizes[i], parsed_report);
+        else if ((results[i] = results[first[i]]) == OE_OK && parsed_report)
+            results[i] =
+                oe_parse_report(reports[i], report_sizes[i], parsed_report);
+
+        if (results[i] != OE_OK)
+            result = OE_VERIFY_FAILED;
+    }
+
+done:
+    oe_free(first);
     return result;
 }
 
@@ -20,6 +20,7 @@
 
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/registers.h>
@@ -28,6 +29,8 @@
 #include "asmdefs.h"
 #include "enclave.h"
 #include "ocalls.h"
+#include "strings.h"
+#include "switchless.h"
 
 /*
 **==============================================================================
@@ -232,14 +235,14 @@ done:
 /*
 **==============================================================================
 **
-** _find_host_func()
+** _resolve_host_func()
 **
-**     Find the function in the host with the given name.
+**     Look up the function in the host with the given name.
 **
 **==============================================================================
 */
 
-static oe_host_func_t _find_host_func(const char* name)
+static oe_host_func_t _resolve_host_func(const char* name)
 {
 #if defined(__linux__)
 
@@ -264,6 +267,96 @@ static oe_host_func_t _find_host_func(const char* name)
 #endif
 }
 
+/*
+**==============================================================================
+**
+** _find_host_func()
+**
+**     Find the function in the host with the given interned ID or name.
+**
+**     Functions resolved by name are interned in enclave->host_funcs, so that
+**     the dynamic linker is walked once per name and enclave. The index of
+**     the entry is returned to the enclave, which passes it instead of the
+**     name on later calls. Once the table is full, names are resolved on
+**     every call and *id is set to OE_CALL_HOST_FUNC_ID_NONE.
+**
+**==============================================================================
+*/
+
+static oe_host_func_t _find_host_func(
+    oe_enclave_t* enclave,
+    const char* name,
+    uint64_t* id)
+{
+    oe_host_func_t func = NULL;
+    uint64_t hash;
+    size_t len;
+
+    /* Fast path: an ID interned by an earlier call */
+    if (*id != OE_CALL_HOST_FUNC_ID_NONE)
+    {
+        if (*id < enclave->num_host_funcs)
+        {
+            OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+            return enclave->host_funcs[*id].func;
+        }
+
+        *id = OE_CALL_HOST_FUNC_ID_NONE;
+    }
+
+    len = strlen(name);
+    hash = oe_fnv1a_hash(name, len);
+
+    oe_mutex_lock(&enclave->lock);
+    {
+        size_t n = enclave->num_host_funcs;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            HostFunc* entry = &enclave->host_funcs[i];
+
+            if (entry->hash == hash && strcmp(entry->name, name) == 0)
+            {
+                func = entry->func;
+                *id = i;
+                goto done;
+            }
+        }
+
+        if (!(func = _resolve_host_func(name)))
+            goto done;
+
+        if (n < OE_CALL_HOST_MAX_FUNCS)
+        {
+            HostFunc* entry = &enclave->host_funcs[n];
+
+            if (!(entry->name = oe_strdup(name)))
+                goto done;
+
+            entry->hash = hash;
+            entry->func = func;
+
+            /* Publish the entry to the lock-free ID path */
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            enclave->num_host_funcs = n + 1;
+            *id = n;
+        }
+    }
+done:
+    oe_mutex_unlock(&enclave->lock);
+
+    return func;
+}
+
+/* Release the host functions interned by _find_host_func() */
+void oe_free_host_funcs(oe_enclave_t* enclave)
+{
+    for (size_t i = 0; i < enclave->num_host_funcs; i++)
+        free(enclave->host_funcs[i].name);
+
+    enclave->num_host_funcs = 0;
+}
+
 /*
 **==============================================================================
 **
@@ -278,14 +371,19 @@ static void _handle_call_host(uint64_t arg, oe_enclave_t* enclave)
 {
     oe_call_host_args_t* args = (oe_call_host_args_t*)arg;
     oe_host_func_t func;
+    uint64_t id;
 
     if (!args)
         return;
 
     args->result = OE_UNEXPECTED;
 
-    /* Find the host function with this name */
-    if (!(func = _find_host_func(args->func)))
+    /* Find the host function with this ID or name */
+    id = args->func_id;
+    func = _find_host_func(enclave, args->func, &id);
+    args->func_id = id;
+
+    if (!func)
     {
         args->result = OE_NOT_FOUND;
         return;
@@ -332,14 +430,14 @@ done:
 /*
 **==============================================================================
 **
-** _handle_call_host_function()
+** oe_handle_call_host_function()
 **
-** Handle calls from the enclave.
+** Handle calls from the enclave. Also called by the switchless OCALL workers.
 **
 **==============================================================================
 */
 
-static void _handle_call_host_function(uint64_t arg, oe_enclave_t* enclave)
+void oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_host_function_args_t* args = (oe_call_host_function_args_t*)arg;
@@ -412,7 +510,7 @@ static oe_result_t _handle_ocall(
             break;
 
         case OE_OCALL_CALL_HOST_FUNCTION:
-            _handle_call_host_function(arg_in, enclave);
+            oe_handle_call_host_function(arg_in, enclave);
             break;
 
         case OE_OCALL_MALLOC:
@@ -431,6 +529,14 @@ static oe_result_t _handle_ocall(
             HandlePrint(arg_in);
             break;
 
+        case OE_OCALL_WRITEV:
+            HandleWritev(arg_in);
+            break;
+
+        case OE_OCALL_SWITCHLESS_WAIT:
+            oe_handle_switchless_wait(enclave);
+            break;
+
         case OE_OCALL_THREAD_WAIT:
             HandleThreadWait(enclave, arg_in);
             break;
@@ -443,6 +549,14 @@ static oe_result_t _handle_ocall(
             HandleThreadWakeWait(enclave, arg_in);
             break;
 
+        case OE_OCALL_THREAD_WAKE_MULTIPLE:
+            HandleThreadWakeMultiple(enclave, arg_in);
+            break;
+
+        case OE_OCALL_THREAD_TIMED_WAIT:
+            HandleThreadTimedWait(enclave, arg_in, arg_out);
+            break;
+
         case OE_OCALL_GET_QUOTE:
             HandleGetQuote(arg_in);
             break;
@@ -533,6 +647,61 @@ int __oe_dispatch_ocall(
     return 1;
 }
 
+/*
+**==============================================================================
+**
+** _pop_free_binding()
+** _push_free_binding()
+**
+**     Lock-free stack of unbound TCSs (see oe_enclave_t.free_bindings). Each
+**     update bumps the tag in the high 32 bits of the head, so a stale head
+**     read by a racing thread fails its compare-and-swap.
+**
+**==============================================================================
+*/
+
+static ThreadBinding* _pop_free_binding(oe_enclave_t* enclave)
+{
+    uint64_t head;
+    uint64_t index;
+    uint64_t next;
+
+    do
+    {
+        head = enclave->free_bindings;
+        index = head & OE_THREAD_BINDING_NONE;
+
+        if (index == OE_THREAD_BINDING_NONE)
+            return NULL;
+
+        next = enclave->free_binding_next[index];
+    } while (!oe_atomic_compare_and_swap(
+        &enclave->free_bindings, head, ((head >> 32) + 1) << 32 | next));
+
+    return &enclave->bindings[index];
+}
+
+static void _push_free_binding(oe_enclave_t* enclave, ThreadBinding* binding)
+{
+    uint64_t index = (uint64_t)(binding - enclave->bindings);
+    uint64_t head;
+
+    do
+    {
+        head = enclave->free_bindings;
+        enclave->free_binding_next[index] =
+            (uint32_t)(head & OE_THREAD_BINDING_NONE);
+    } while (!oe_atomic_compare_and_swap(
+        &enclave->free_bindings, head, ((head >> 32) + 1) << 32 | index));
+}
+
+/* Whether the binding belongs to the given enclave */
+static bool _is_enclave_binding(oe_enclave_t* enclave, ThreadBinding* binding)
+{
+    return binding >= enclave->bindings &&
+           binding < enclave->bindings + enclave->num_bindings;
+}
+
 /*
 **==============================================================================
 **
@@ -543,8 +712,18 @@ int __oe_dispatch_ocall(
 **         - an enclave thread context
 **
 **     If such a binding already exists, the binding's count in incremented.
-**     Else, the calling host thread is bound to the first available enclave
-**     thread context.
+**     Else, the calling host thread is bound to the TCS on top of the free
+**     stack.
+**
+**     Thread-specific data holds the binding of the innermost enclave the
+**     thread is in, and each oe_ecall() restores the one it found there when
+**     its binding is dissolved. So the data is null outside all enclaves, and
+**     the table is only scanned when the thread is nested in another
+**     enclave (ECALL A -> OCALL -> ECALL B -> OCALL -> ECALL A). Only its
+**     owning thread updates a busy binding, so no path takes enclave->lock.
+**
+**     The binding found in thread-specific data is returned in *previous,
+**     for _release_tcs().
 **
 **     Returns the address of the thread control structure (TCS) corresponding
 **     to the enclave thread context.
@@ -552,52 +731,50 @@ int __oe_dispatch_ocall(
 **==============================================================================
 */
 
-static void* _assign_tcs(oe_enclave_t* enclave)
+static void* _assign_tcs(oe_enclave_t* enclave, ThreadBinding** previous)
 {
-    void* tcs = NULL;
-    size_t i;
+    ThreadBinding* binding = GetThreadBinding();
     oe_thread thread = oe_thread_self();
 
-    oe_mutex_lock(&enclave->lock);
+    *previous = binding;
+
+    /* The thread is inside another enclave; it may be bound to this one
+     * further out */
+    if (binding && !_is_enclave_binding(enclave, binding))
     {
-        /* First attempt to find a busy td_t owned by this thread */
-        for (i = 0; i < enclave->num_bindings; i++)
+        binding = NULL;
+
+        for (size_t i = 0; i < enclave->num_bindings; i++)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
+            ThreadBinding* b = &enclave->bindings[i];
 
-            if ((binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
+            if ((b->flags & _OE_THREAD_BUSY) && b->thread == thread)
             {
-                binding->count++;
-                tcs = (void*)binding->tcs;
+                binding = b;
                 break;
             }
         }
+    }
 
-        /* If binding not found above, look for an available ThreadBinding */
-        if (!tcs)
-        {
-            for (i = 0; i < enclave->num_bindings; i++)
-            {
-                ThreadBinding* binding = &enclave->bindings[i];
-
-                if (!(binding->flags & _OE_THREAD_BUSY))
-                {
-                    binding->flags |= _OE_THREAD_BUSY;
-                    binding->thread = thread;
-                    binding->count = 1;
-                    tcs = (void*)binding->tcs;
-
-                    /* Set into TSD so asynchronous exceptions can get it */
-                    _set_thread_binding(binding);
-                    assert(GetThreadBinding() == binding);
-                    break;
-                }
-            }
-        }
+    /* Nested call from a thread already bound to this enclave */
+    if (binding && (binding->flags & _OE_THREAD_BUSY))
+    {
+        binding->count++;
+        return (void*)binding->tcs;
     }
-    oe_mutex_unlock(&enclave->lock);
 
-    return tcs;
+    if (!(binding = _pop_free_binding(enclave)))
+        return NULL;
+
+    binding->thread = thread;
+    binding->count = 1;
+    binding->flags |= _OE_THREAD_BUSY;
+
+    /* Set into TSD so asynchronous exceptions can get it */
+    _set_thread_binding(binding);
+    assert(GetThreadBinding() == binding);
+
+    return (void*)binding->tcs;
 }
 
 /*
@@ -606,39 +783,41 @@ static void* _assign_tcs(oe_enclave_t* enclave)
 ** _release_tcs()
 **
 **     Decrement the ThreadBinding.count field of the binding associated with
-**     the given TCS. If the field becomes zero, the binding is dissolved.
+**     the given TCS. If the field becomes zero, the binding is dissolved, the
+**     TCS is pushed back onto the free stack and thread-specific data goes
+**     back to the binding _assign_tcs() found there.
 **
 **==============================================================================
 */
 
-static void _release_tcs(oe_enclave_t* enclave, void* tcs)
+static void _release_tcs(
+    oe_enclave_t* enclave,
+    void* tcs,
+    ThreadBinding* previous)
 {
-    size_t i;
+    ThreadBinding* binding = GetThreadBinding();
 
-    oe_mutex_lock(&enclave->lock);
+    if (!binding || binding->tcs != (uint64_t)tcs)
+        binding = GetThreadBindingByTCS(enclave, (uint64_t)tcs);
+
+    if (!binding || !(binding->flags & _OE_THREAD_BUSY))
+        return;
+
+    if (--binding->count == 0)
     {
-        for (i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
+        binding->flags &= (~_OE_THREAD_BUSY);
+        binding->thread = 0;
+#if defined(__linux__)
+        /* Windows event handles live as long as the enclave */
+        binding->event.value = 0;
+#endif
+        _set_thread_binding(previous);
+        assert(GetThreadBinding() == previous);
 
-            if ((binding->flags & _OE_THREAD_BUSY) &&
-                (void*)binding->tcs == tcs)
-            {
-                binding->count--;
-
-                if (binding->count == 0)
-                {
-                    binding->flags &= (~_OE_THREAD_BUSY);
-                    binding->thread = 0;
-                    memset(&binding->event, 0, sizeof(binding->event));
-                    _set_thread_binding(NULL);
-                    assert(GetThreadBinding() == NULL);
-                }
-                break;
-            }
-        }
+        /* Publish the cleared binding before another thread can pop it */
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        _push_free_binding(enclave, binding);
     }
-    oe_mutex_unlock(&enclave->lock);
 }
 
 /*
@@ -659,6 +838,7 @@ oe_result_t oe_ecall(
 {
     oe_result_t result = OE_UNEXPECTED;
     void* tcs = NULL;
+    ThreadBinding* previous = NULL;
     oe_code_t code = OE_CODE_ECALL;
     oe_code_t code_out = 0;
     uint16_t func_out = 0;
@@ -669,7 +849,7 @@ oe_result_t oe_ecall(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Assign a td_t for this operation */
-    if (!(tcs = _assign_tcs(enclave)))
+    if (!(tcs = _assign_tcs(enclave, &previous)))
         OE_RAISE(OE_OUT_OF_THREADS);
 
     /* Perform ECALL or ORET */
@@ -698,7 +878,7 @@ oe_result_t oe_ecall(
 done:
 
     if (enclave && tcs)
-        _release_tcs(enclave, tcs);
+        _release_tcs(enclave, tcs, previous);
 
     /* ATTN: this causes an assertion with call nesting. */
     /* ATTN: make enclave argument a cookie. */
@@ -713,37 +893,27 @@ done:
 **
 ** _find_enclave_func()
 **
-**     Find the enclave function with the given name
+**     Find the index of the enclave function with the given name through the
+**     hash index built by _build_ecall_array(). Returns the index plus one,
+**     or zero if not found.
 **
 **==============================================================================
 */
 
-static uint64_t _find_enclave_func(
-    oe_enclave_t* enclave,
-    const char* func,
-    uint64_t* index)
+static uint64_t _find_enclave_func(oe_enclave_t* enclave, const char* func)
 {
-    size_t i;
-
-    if (index)
-        *index = 0;
-
-    /* Reject null parameters and empty string funcs (checked by !*func). */
-    if (!enclave || !func || !*func || !index)
-        return 0;
-
     size_t len = strlen(func);
-    uint64_t code = StrCode(func, len);
+    uint64_t code = oe_fnv1a_hash(func, len);
+    size_t mask = enclave->ecall_index_mask;
+    uint32_t slot;
 
-    for (i = 0; i < enclave->num_ecalls; i++)
+    for (size_t j = code & mask; (slot = enclave->ecall_index[j]) != 0;
+         j = (j + 1) & mask)
     {
-        const ECallNameAddr* p = &enclave->ecalls[i];
+        const ECallNameAddr* p = &enclave->ecalls[slot - 1];
 
-        if (p->code == code && memcmp(p->name, func, len) == 0)
-        {
-            *index = i;
-            return enclave->ecalls[i].vaddr;
-        }
+        if (p->code == code && strcmp(p->name, func) == 0)
+            return slot;
     }
 
     /* Not found! */
@@ -753,30 +923,63 @@ static uint64_t _find_enclave_func(
 /*
 **==============================================================================
 **
-** oe_call_enclave()
+** oe_get_enclave_function()
 **
-**     Call the named function in the enclave.
+**     Resolve the named function in the enclave to a handle, which is the
+**     index of the function in enclave->ecalls plus one.
 **
 **==============================================================================
 */
 
-oe_result_t oe_call_enclave(oe_enclave_t* enclave, const char* func, void* args)
+oe_result_t oe_get_enclave_function(
+    oe_enclave_t* enclave,
+    const char* func,
+    oe_enclave_function_handle_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (handle)
+        *handle = 0;
+
+    /* Reject invalid parameters */
+    if (!enclave || !func || !handle)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(*handle = _find_enclave_func(enclave, func)))
+        OE_RAISE(OE_NOT_FOUND);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_by_handle()
+**
+**     Call the enclave function with the given handle.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    oe_enclave_function_handle_t handle,
+    void* args)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_enclave_args_t call_enclave_args;
 
     /* Reject invalid parameters */
-    if (!enclave || !func)
+    if (!enclave || handle == 0 || handle > enclave->num_ecalls)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Initialize the call_enclave_args structure */
     {
-        if (!(call_enclave_args.vaddr =
-                  _find_enclave_func(enclave, func, &call_enclave_args.func)))
-        {
-            OE_RAISE(OE_NOT_FOUND);
-        }
-
+        call_enclave_args.func = handle - 1;
+        call_enclave_args.vaddr = enclave->ecalls[handle - 1].vaddr;
         call_enclave_args.args = args;
         call_enclave_args.result = OE_UNEXPECTED;
     }
@@ -803,6 +1006,34 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_call_enclave()
+**
+**     Call the named function in the enclave.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave(oe_enclave_t* enclave, const char* func, void* args)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_enclave_function_handle_t handle;
+
+    /* Reject invalid parameters */
+    if (!enclave || !func)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_get_enclave_function(enclave, func, &handle));
+    OE_CHECK(oe_call_enclave_by_handle(enclave, handle, args));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -841,7 +1072,8 @@ oe_result_t oe_call_enclave_function(
         args.result = OE_UNEXPECTED;
     }
 
-    /* Perform the ECALL */
+    /* Perform the ECALL, switchless if an enclave worker takes it */
+    if (oe_switchless_call_enclave_function(enclave, &args) != OE_OK)
     {
         uint64_t arg_out = 0;
 
@@ -30,8 +30,10 @@
 #include <string.h>
 #include "cpuid.h"
 #include "enclave.h"
-#include "memalign.h"
 #include "sgxload.h"
+#include "switchless.h"
+#include "symbols.h"
+#include "timepage.h"
 
 static oe_once_type _enclave_init_once;
 
@@ -129,36 +131,197 @@ static void _resolve_flags(
     }
 }
 
+/*
+**==============================================================================
+**
+** Segment pages:
+**
+**     The segments are added straight from the (mapped) ELF image. Only the
+**     pages that differ from the file are assembled in a scratch page: pages
+**     shared by several segments or ending in zero fill, pages the loader
+**     patches (see ImagePatch) and pages that are not page-aligned in the
+**     file. This avoids holding a second copy of the whole image in memory.
+**
+**==============================================================================
+*/
+
+/* A change made to the segment image before it is added to the enclave */
+typedef struct _image_patch
+{
+    uint64_t vaddr;
+    uint64_t size;
+    uint64_t value; /* Written if size is 8 and clear is false */
+    bool clear;     /* Zero the range instead */
+} ImagePatch;
+
+/* Symbol patches, ELF header fields and .oeinfo */
+#define MAX_IMAGE_PATCHES 16
+
+static bool _overlaps(uint64_t lo1, uint64_t hi1, uint64_t lo2, uint64_t hi2)
+{
+    return lo1 < hi2 && lo2 < hi1;
+}
+
+/* Return the contents of the segment page at the given address, either in
+ * place in the image or assembled in the scratch page */
+static const void* _get_segment_page(
+    const oe_segment_t segments[],
+    size_t nsegments,
+    const ImagePatch patches[],
+    size_t npatches,
+    uint64_t vaddr,
+    oe_page_t* scratch)
+{
+    const uint64_t end = vaddr + OE_PAGE_SIZE;
+    const oe_segment_t* source = NULL;
+    size_t nsources = 0;
+    bool patched = false;
+
+    for (size_t i = 0; i < nsegments; i++)
+    {
+        const oe_segment_t* seg = &segments[i];
+
+        if (_overlaps(vaddr, end, seg->vaddr, seg->vaddr + seg->filesz))
+        {
+            source = seg;
+            nsources++;
+        }
+    }
+
+    for (size_t i = 0; i < npatches; i++)
+    {
+        const ImagePatch* patch = &patches[i];
+
+        if (_overlaps(vaddr, end, patch->vaddr, patch->vaddr + patch->size))
+            patched = true;
+    }
+
+    /* Use the page in place if it comes unchanged from a single segment */
+    if (nsources == 1 && !patched && vaddr >= source->vaddr &&
+        end <= source->vaddr + source->filesz)
+    {
+        const uint8_t* src =
+            (const uint8_t*)source->filedata + (vaddr - source->vaddr);
+
+        if ((uint64_t)src % OE_PAGE_SIZE == 0)
+            return src;
+    }
+
+    /* Assemble the page: later segments overwrite earlier ones */
+    memset(scratch, 0, sizeof(oe_page_t));
+
+    for (size_t i = 0; i < nsegments; i++)
+    {
+        const oe_segment_t* seg = &segments[i];
+        uint64_t lo = seg->vaddr > vaddr ? seg->vaddr : vaddr;
+        uint64_t hi = seg->vaddr + seg->filesz;
+
+        if (hi > end)
+            hi = end;
+
+        if (lo < hi)
+        {
+            memcpy(
+                scratch->data + (lo - vaddr),
+                (const uint8_t*)seg->filedata + (lo - seg->vaddr),
+                hi - lo);
+        }
+    }
+
+    for (size_t i = 0; i < npatches; i++)
+    {
+        const ImagePatch* patch = &patches[i];
+        uint64_t lo = patch->vaddr > vaddr ? patch->vaddr : vaddr;
+        uint64_t hi = patch->vaddr + patch->size;
+
+        if (hi > end)
+            hi = end;
+
+        if (lo >= hi)
+            continue;
+
+        if (patch->clear)
+        {
+            memset(scratch->data + (lo - vaddr), 0, hi - lo);
+        }
+        else
+        {
+            memcpy(
+                scratch->data + (lo - vaddr),
+                (const uint8_t*)&patch->value + (lo - patch->vaddr),
+                hi - lo);
+        }
+    }
+
+    return scratch;
+}
+
+/* A run of pages to add that are contiguous in the image and the enclave */
+typedef struct _page_run
+{
+    uint64_t addr;
+    uint64_t src;
+    size_t npages;
+    uint64_t flags;
+} PageRun;
+
+static oe_result_t _flush_page_run(
+    oe_sgx_load_context_t* context,
+    uint64_t enclave_addr,
+    PageRun* run)
+{
+    oe_result_t result = OE_OK;
+
+    if (run->npages)
+    {
+        result = oe_sgx_load_enclave_pages(
+            context,
+            enclave_addr,
+            run->addr,
+            run->src,
+            run->npages,
+            false,
+            run->flags,
+            true);
+        run->npages = 0;
+    }
+
+    return result;
+}
+
 static oe_result_t _add_segment_pages(
     oe_sgx_load_context_t* context,
     uint64_t enclave_addr,
     uint64_t enclave_size,
     const oe_segment_t segments[],
     size_t nsegments,
-    const oe_page_t* pages,
+    const ImagePatch patches[],
+    size_t npatches,
     size_t npages,
     uint64_t* vaddr)
 {
     oe_result_t result = OE_UNEXPECTED;
+    oe_page_t scratch;
+    PageRun run = {0, 0, 0, 0};
     size_t i;
 
     if (!context || !enclave_addr || !enclave_size || !segments || !nsegments ||
-        !pages || !npages || !vaddr)
+        !npages || !vaddr)
     {
         OE_RAISE(OE_INVALID_PARAMETER);
     }
 
-    /* Add each page to the enclave */
+    /* Add each page to the enclave, passing pages that come straight from
+     * the image in runs */
     for (i = 0; i < npages; i++)
     {
-        const oe_page_t* page = &pages[i];
-        uint64_t addr = enclave_addr + (i * OE_PAGE_SIZE);
-        uint64_t src = (uint64_t)page;
+        uint64_t offset = i * OE_PAGE_SIZE;
+        uint64_t addr = enclave_addr + offset;
+        uint64_t src;
         uint64_t flags;
-        bool extend = true;
 
         /* Get the memory protection flags for this page address */
-        _resolve_flags(segments, nsegments, src - (uint64_t)pages, &flags);
+        _resolve_flags(segments, nsegments, offset, &flags);
 
         /* If page not with segments ranges, then skip! */
         if (flags == 0)
@@ -173,13 +336,39 @@ static oe_result_t _add_segment_pages(
             OE_RAISE(OE_FAILURE);
         }
 
-        OE_CHECK(
-            oe_sgx_load_enclave_data(
-                context, enclave_addr, addr, src, flags, extend));
+        src = (uint64_t)_get_segment_page(
+            segments, nsegments, patches, npatches, offset, &scratch);
 
         (*vaddr) = (addr - enclave_addr) + OE_PAGE_SIZE;
+
+        /* Extend the current run if this page continues it */
+        if (run.npages && src != (uint64_t)&scratch && flags == run.flags &&
+            addr == run.addr + run.npages * OE_PAGE_SIZE &&
+            src == run.src + run.npages * OE_PAGE_SIZE)
+        {
+            run.npages++;
+            continue;
+        }
+
+        OE_CHECK(_flush_page_run(context, enclave_addr, &run));
+
+        /* The scratch page is reused, so add it right away */
+        if (src == (uint64_t)&scratch)
+        {
+            OE_CHECK(
+                oe_sgx_load_enclave_data(
+                    context, enclave_addr, addr, src, flags, true));
+            continue;
+        }
+
+        run.addr = addr;
+        run.src = src;
+        run.npages = 1;
+        run.flags = flags;
     }
 
+    OE_CHECK(_flush_page_run(context, enclave_addr, &run));
+
     result = OE_OK;
 
 done:
@@ -196,7 +385,6 @@ static oe_result_t _add_filled_pages(
 {
     oe_page_t page;
     oe_result_t result = OE_UNEXPECTED;
-    size_t i;
 
     /* Reject invalid parameters */
     if (!context || !enclave_addr || !vaddr)
@@ -214,17 +402,17 @@ static oe_result_t _add_filled_pages(
     else
         memset(&page, 0, sizeof(page));
 
-    /* Add the pages */
-    for (i = 0; i < npages; i++)
+    /* Add the pages as copies of this page */
+    if (npages)
     {
         uint64_t addr = enclave_addr + *vaddr;
         uint64_t src = (uint64_t)&page;
         uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W;
 
         OE_CHECK(
-            oe_sgx_load_enclave_data(
-                context, enclave_addr, addr, src, flags, extend));
-        (*vaddr) += OE_PAGE_SIZE;
+            oe_sgx_load_enclave_pages(
+                context, enclave_addr, addr, src, npages, true, flags, extend));
+        (*vaddr) += npages * OE_PAGE_SIZE;
     }
 
     result = OE_OK;
@@ -280,7 +468,7 @@ static oe_result_t _add_control_pages(
 
     /* Save the address of new TCS page into enclave object */
     {
-        if (enclave->num_bindings == OE_SGX_MAX_TCS)
+        if (!enclave->bindings || enclave->num_bindings == OE_SGX_MAX_TCS)
             OE_RAISE(OE_FAILURE);
 
         enclave->bindings[enclave->num_bindings++].tcs = enclave_addr + *vaddr;
@@ -482,14 +670,14 @@ done:
     return result;
 }
 
+/* Record that the 8 bytes at the given offset in the image hold value */
 static oe_result_t _patch_page(
-    oe_page_t* segpages,
+    ImagePatch patches[MAX_IMAGE_PATCHES],
+    size_t* npatches,
     size_t nsegpages,
     uint64_t offset,
     uint64_t value)
 {
-    uint8_t* pagebuf = (uint8_t*)segpages;
-
     /* Get the total size. */
     size_t size;
     oe_result_t ret = oe_safe_mul_sizet(nsegpages, sizeof(oe_page_t), &size);
@@ -501,20 +689,114 @@ static oe_result_t _patch_page(
         return OE_OUT_OF_BOUNDS;
 
     /* Ensure 8 byte alignment. */
-    uint64_t page;
-    ret = oe_safe_add_u64((uint64_t)pagebuf, offset, &page);
-    if (ret != OE_OK)
-        return ret;
-
-    if (page % sizeof(uint64_t) != 0)
+    if (offset % sizeof(uint64_t) != 0)
         return OE_BAD_ALIGNMENT;
 
-    /* Patch the page. */
-    *((uint64_t*)page) = value;
+    if (*npatches == MAX_IMAGE_PATCHES)
+        return OE_FAILURE;
+
+    patches[*npatches].vaddr = offset;
+    patches[*npatches].size = sizeof(uint64_t);
+    patches[*npatches].value = value;
+    patches[*npatches].clear = false;
+    (*npatches)++;
+
+    return OE_OK;
+}
+
+/* Record that the given range of the image is cleared */
+static oe_result_t _clear_range(
+    ImagePatch patches[MAX_IMAGE_PATCHES],
+    size_t* npatches,
+    uint64_t vaddr,
+    uint64_t size)
+{
+    if (*npatches == MAX_IMAGE_PATCHES)
+        return OE_FAILURE;
+
+    patches[*npatches].vaddr = vaddr;
+    patches[*npatches].size = size;
+    patches[*npatches].value = 0;
+    patches[*npatches].clear = true;
+    (*npatches)++;
 
     return OE_OK;
 }
 
+/* Hide the section headers and the .oeinfo section from the enclave: the
+ * loader zeroes them in the image rather than in the file */
+static oe_result_t _clear_image_metadata(
+    const elf64_t* elf,
+    const oe_segment_t segments[],
+    size_t nsegments,
+    ImagePatch patches[MAX_IMAGE_PATCHES],
+    size_t* npatches)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    elf64_shdr_t oeinfo;
+    size_t i;
+
+    /* Clear certain ELF header fields */
+    for (i = 0; i < nsegments; i++)
+    {
+        const oe_segment_t* seg = &segments[i];
+
+        if (seg->filesz >= sizeof(elf64_ehdr_t) &&
+            elf64_test_header((const elf64_ehdr_t*)seg->filedata) == 0)
+        {
+            OE_CHECK(
+                _clear_range(
+                    patches,
+                    npatches,
+                    seg->vaddr + OE_OFFSETOF(elf64_ehdr_t, e_shoff),
+                    sizeof(elf64_off_t)));
+            OE_CHECK(
+                _clear_range(
+                    patches,
+                    npatches,
+                    seg->vaddr + OE_OFFSETOF(elf64_ehdr_t, e_shnum),
+                    sizeof(elf64_half_t)));
+            OE_CHECK(
+                _clear_range(
+                    patches,
+                    npatches,
+                    seg->vaddr + OE_OFFSETOF(elf64_ehdr_t, e_shstrndx),
+                    sizeof(elf64_half_t)));
+            break;
+        }
+    }
+
+    /* Zero out the .oeinfo section if within a segment */
+    if (elf64_find_section_header(elf, ".oeinfo", &oeinfo) == 0 &&
+        oeinfo.sh_size)
+    {
+        for (i = 0; i < nsegments; i++)
+        {
+            const oe_segment_t* seg = &segments[i];
+
+            if (oeinfo.sh_offset < seg->offset ||
+                oeinfo.sh_offset >= seg->offset + seg->filesz)
+                continue;
+
+            /* Check the section doesn't cross the end of the segment */
+            if (oeinfo.sh_offset + oeinfo.sh_size > seg->offset + seg->filesz)
+                OE_RAISE(OE_OUT_OF_BOUNDS);
+
+            OE_CHECK(
+                _clear_range(
+                    patches,
+                    npatches,
+                    seg->vaddr + (oeinfo.sh_offset - seg->offset),
+                    oeinfo.sh_size));
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 static oe_result_t _add_pages(
     oe_sgx_load_context_t* context,
     elf64_t* elf,
@@ -531,12 +813,15 @@ static oe_result_t _add_pages(
     size_t nheappages,
     size_t nstackpages,
     size_t num_bindings,
+    const oe_sgx_enclave_properties_t* properties,
     oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
     uint64_t vaddr = 0;
     size_t i;
-    oe_page_t* segpages = NULL;
+    ImagePatch patches[MAX_IMAGE_PATCHES];
+    size_t npatches = 0;
+    size_t segments_size;
     size_t nsegpages;
     size_t base_reloc_page;
     size_t base_ecall_page;
@@ -544,13 +829,18 @@ static oe_result_t _add_pages(
 
     /* Reject invalid parameters */
     if (!context || !enclave_addr || !enclave_size || !segments || !nsegments ||
-        !num_bindings || !nstackpages || !nheappages || !enclave)
+        !num_bindings || !nstackpages || !nheappages || !properties ||
+        !enclave)
     {
         OE_RAISE(OE_INVALID_PARAMETER);
     }
 
-    /* ATTN: Eliminate this step to save memory! */
-    OE_CHECK(__oe_combine_segments(segments, nsegments, &segpages, &nsegpages));
+    /* Calculate the number of pages spanned by the segments */
+    OE_CHECK(__oe_calculate_segments_size(segments, nsegments, &segments_size));
+    nsegpages = segments_size / OE_PAGE_SIZE;
+
+    OE_CHECK(
+        _clear_image_metadata(elf, segments, nsegments, patches, &npatches));
 
     /* The relocation pages follow the segments */
     base_reloc_page = nsegpages;
@@ -570,7 +860,8 @@ static oe_result_t _add_pages(
             OE_RAISE(OE_FAILURE);
 
         OE_CHECK(
-            _patch_page(segpages, nsegpages, sym.st_value, base_reloc_page));
+            _patch_page(
+                patches, &npatches, nsegpages, sym.st_value, base_reloc_page));
     }
 
     /* Patch the "oe_num_reloc_pages" */
@@ -583,7 +874,11 @@ static oe_result_t _add_pages(
 
         OE_CHECK(
             _patch_page(
-                segpages, nsegpages, sym.st_value, reloc_size / OE_PAGE_SIZE));
+                patches,
+                &npatches,
+                nsegpages,
+                sym.st_value,
+                reloc_size / OE_PAGE_SIZE));
     }
 
     /* Patch the "oe_base_ecall_page" */
@@ -595,7 +890,8 @@ static oe_result_t _add_pages(
             OE_RAISE(OE_FAILURE);
 
         OE_CHECK(
-            _patch_page(segpages, nsegpages, sym.st_value, base_ecall_page));
+            _patch_page(
+                patches, &npatches, nsegpages, sym.st_value, base_ecall_page));
     }
 
     /* Patch the "oe_num_ecall_pages" */
@@ -608,7 +904,11 @@ static oe_result_t _add_pages(
 
         OE_CHECK(
             _patch_page(
-                segpages, nsegpages, sym.st_value, ecall_size / OE_PAGE_SIZE));
+                patches,
+                &npatches,
+                nsegpages,
+                sym.st_value,
+                ecall_size / OE_PAGE_SIZE));
     }
 
     /* Patch the "oe_base_heap_page" */
@@ -620,7 +920,8 @@ static oe_result_t _add_pages(
             OE_RAISE(OE_FAILURE);
 
         OE_CHECK(
-            _patch_page(segpages, nsegpages, sym.st_value, base_heap_page));
+            _patch_page(
+                patches, &npatches, nsegpages, sym.st_value, base_heap_page));
     }
 
     /* Patch the "oe_num_heap_pages" */
@@ -631,7 +932,9 @@ static oe_result_t _add_pages(
             0)
             OE_RAISE(OE_FAILURE);
 
-        OE_CHECK(_patch_page(segpages, nsegpages, sym.st_value, nheappages));
+        OE_CHECK(
+            _patch_page(
+                patches, &npatches, nsegpages, sym.st_value, nheappages));
     }
 
     /* Patch the "oe_num_pages" */
@@ -642,7 +945,8 @@ static oe_result_t _add_pages(
         if (elf64_find_dynamic_symbol_by_name(elf, "oe_num_pages", &sym) != 0)
             OE_RAISE(OE_FAILURE);
 
-        OE_CHECK(_patch_page(segpages, nsegpages, sym.st_value, npages));
+        OE_CHECK(
+            _patch_page(patches, &npatches, nsegpages, sym.st_value, npages));
     }
 
     /* Patch the "oe_virtual_base_addr" */
@@ -655,7 +959,9 @@ static oe_result_t _add_pages(
             OE_RAISE(OE_FAILURE);
         }
 
-        OE_CHECK(_patch_page(segpages, nsegpages, sym.st_value, sym.st_value));
+        OE_CHECK(
+            _patch_page(
+                patches, &npatches, nsegpages, sym.st_value, sym.st_value));
     }
 
     /* Add the program segments first */
@@ -666,7 +972,8 @@ static oe_result_t _add_pages(
             enclave_size,
             segments,
             nsegments,
-            segpages,
+            patches,
+            npatches,
             nsegpages,
             &vaddr));
 
@@ -680,9 +987,34 @@ static oe_result_t _add_pages(
         _add_ecall_pages(
             context, enclave_addr, ecall_data, ecall_size, &vaddr));
 
+    /* The rest of the measurement depends only on the layout */
+    OE_CHECK(
+        oe_sgx_lookup_measurement(
+            context,
+            properties,
+            vaddr,
+            nheappages,
+            nstackpages,
+            num_bindings,
+            entry));
+
     /* Create the heap */
     OE_CHECK(_add_heap_pages(context, enclave_addr, &vaddr, nheappages));
 
+    /* Allocate one thread binding per TCS */
+    {
+        if (enclave->bindings || num_bindings > OE_SGX_MAX_TCS)
+            OE_RAISE(OE_FAILURE);
+
+        if (!(enclave->bindings =
+                  (ThreadBinding*)calloc(num_bindings, sizeof(ThreadBinding))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        if (!(enclave->free_binding_next =
+                  (uint32_t*)calloc(num_bindings, sizeof(uint32_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+    }
+
     for (i = 0; i < num_bindings; i++)
     {
         /* Add guard page */
@@ -703,13 +1035,12 @@ static oe_result_t _add_pages(
     if (vaddr != enclave_end)
         OE_RAISE(OE_FAILURE);
 
+    /* Make all TCSs available to _assign_tcs() */
+    InitThreadBindings(enclave);
+
     result = OE_OK;
 
 done:
-
-    if (segpages)
-        oe_memalign_free(segpages);
-
     return result;
 }
 
@@ -759,7 +1090,7 @@ static int _visit_sym(const elf64_sym_t* sym, void* data_)
         if (!(tmp.name = oe_strdup(name)))
             goto done;
 
-        tmp.code = StrCode(name, strlen(name));
+        tmp.code = oe_fnv1a_hash(name, strlen(name));
         tmp.vaddr = sym->st_value;
 
         if (mem_cat(data->mem, &tmp, sizeof(tmp)) != 0)
@@ -801,6 +1132,32 @@ static oe_result_t _build_ecall_array(oe_enclave_t* enclave, elf64_t* elf)
         enclave->num_ecalls = mem_size(&mem) / sizeof(ECallNameAddr);
     }
 
+    /* Index the ECALLs by name hash (open addressing, linear probing). The
+     * table is a power of two at least twice the number of ECALLs, so probe
+     * sequences stay short and always reach an empty slot. */
+    {
+        size_t size = 1;
+
+        while (size < 2 * enclave->num_ecalls)
+            size *= 2;
+
+        if (!(enclave->ecall_index = (uint32_t*)calloc(size, sizeof(uint32_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        enclave->ecall_index_mask = size - 1;
+
+        for (size_t i = 0; i < enclave->num_ecalls; i++)
+        {
+            size_t j = enclave->ecalls[i].code & enclave->ecall_index_mask;
+
+            while (enclave->ecall_index[j])
+                j = (j + 1) & enclave->ecall_index_mask;
+
+            /* Slots hold the ECALL index plus one, zero marks an empty slot */
+            enclave->ecall_index[j] = (uint32_t)(i + 1);
+        }
+    }
+
     result = OE_OK;
 
 done:
@@ -942,6 +1299,12 @@ static oe_result_t _initialize_enclave(oe_enclave_t* enclave)
     // Pass the enclave handle to the enclave.
     args.enclave = enclave;
 
+    // Pass the switchless OCALL ring (if any) to the enclave.
+    args.switchless_ring = enclave->switchless_ring;
+
+    // Pass the host time page (if any) to the enclave.
+    args.time_page = oe_get_time_page(enclave);
+
     OE_CHECK(oe_ecall(enclave, OE_ECALL_INIT_ENCLAVE, (uint64_t)&args, NULL));
 
     result = OE_OK;
@@ -1196,7 +1559,6 @@ oe_result_t oe_sgx_build_enclave(
     size_t enclave_end = 0;
     size_t enclave_size = 0;
     uint64_t enclave_addr = 0;
-    size_t i;
     elf64_t elf;
     void* reloc_data = NULL;
     size_t reloc_size;
@@ -1211,6 +1573,7 @@ oe_result_t oe_sgx_build_enclave(
         if (enclave)
             memset(enclave, 0, sizeof(oe_enclave_t));
 
+        enclave->debug_layout_version = OE_ENCLAVE_DEBUG_LAYOUT_VERSION;
         enclave->debug = oe_sgx_is_debug_load_context(context);
         enclave->simulate = oe_sgx_is_simulation_load_context(context);
     }
@@ -1223,8 +1586,8 @@ oe_result_t oe_sgx_build_enclave(
     if (!context || !path || !enclave)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Load the elf object */
-    if (elf64_load(path, &elf) != 0)
+    /* Map the elf object; its segments are added to the enclave in place */
+    if (elf64_map(path, &elf) != 0)
         OE_RAISE(OE_FAILURE);
 
     // If the **properties** parameter is non-null, use those properties.
@@ -1259,10 +1622,10 @@ oe_result_t oe_sgx_build_enclave(
         }
     }
 
-    /* Load the program segments into memory */
+    /* Locate the program segments within the image */
     OE_CHECK(
         __oe_load_segments(
-            path, segments, &num_segments, &entry_addr, &start_addr));
+            &elf, segments, &num_segments, &entry_addr, &start_addr));
 
     /* Load the relocations into memory (zero-padded to next page size) */
     if (elf64_load_relocations(&elf, &reloc_data, &reloc_size) != OE_OK)
@@ -1298,21 +1661,6 @@ oe_result_t oe_sgx_build_enclave(
     enclave->addr = enclave_addr;
     enclave->size = enclave_size;
 
-    /* Clear certain ELF header fields */
-    for (i = 0; i < num_segments; i++)
-    {
-        const oe_segment_t* seg = &segments[i];
-        elf64_ehdr_t* ehdr = (elf64_ehdr_t*)seg->filedata;
-
-        if (elf64_test_header(ehdr) == 0)
-        {
-            ehdr->e_shoff = 0;
-            ehdr->e_shnum = 0;
-            ehdr->e_shstrndx = 0;
-            break;
-        }
-    }
-
     /* Add pages to enclave page cache (EPC) */
     OE_CHECK(
         _add_pages(
@@ -1331,6 +1679,7 @@ oe_result_t oe_sgx_build_enclave(
             props.header.size_settings.num_heap_pages,
             props.header.size_settings.num_stack_pages,
             props.header.size_settings.num_tcs,
+            &props,
             enclave));
 
     /* Ask the platform to initialize the enclave and finalize the hash */
@@ -1347,15 +1696,18 @@ oe_result_t oe_sgx_build_enclave(
 
     /* Set the magic number only if we have actually created an enclave */
     if (context->type == OE_SGX_LOAD_TYPE_CREATE)
+    {
+        /* Index the function symbols for backtraces while the image is
+         * loaded */
+        OE_CHECK(oe_load_symbol_index(enclave, &elf));
+
         enclave->magic = ENCLAVE_MAGIC;
+    }
 
     result = OE_OK;
 
 done:
 
-    for (i = 0; i < num_segments; i++)
-        free(segments[i].filedata);
-
     if (reloc_data)
         free(reloc_data);
 
@@ -1428,6 +1780,9 @@ oe_result_t oe_create_enclave(
     oe_result_t result = OE_UNEXPECTED;
     oe_enclave_t* enclave = NULL;
     oe_sgx_load_context_t context;
+    const oe_switchless_config_t* switchless_config = NULL;
+    size_t num_host_workers = OE_SWITCHLESS_OCALL_HOST_WORKERS;
+    size_t num_enclave_workers = OE_SWITCHLESS_ECALL_ENCLAVE_WORKERS;
 
     _initialize_enclave_host();
 
@@ -1436,13 +1791,36 @@ oe_result_t oe_create_enclave(
 
     /* Check parameters */
     if (!enclave_path || !enclave_out || enclave_type != OE_ENCLAVE_TYPE_SGX ||
-        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
+        (flags & OE_ENCLAVE_FLAG_RESERVED))
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* The only configuration is the size of the switchless worker pools */
+    if (config || config_size > 0)
+    {
+        if (!config || config_size != sizeof(oe_switchless_config_t))
+            OE_RAISE(OE_INVALID_PARAMETER);
+
+        switchless_config = (const oe_switchless_config_t*)config;
+
+        if (switchless_config->num_host_workers)
+            num_host_workers = switchless_config->num_host_workers;
+
+        if (switchless_config->num_enclave_workers)
+            num_enclave_workers = switchless_config->num_enclave_workers;
+    }
+
     /* Allocate and zero-fill the enclave structure */
     if (!(enclave = (oe_enclave_t*)calloc(1, sizeof(oe_enclave_t))))
         OE_RAISE(OE_OUT_OF_MEMORY);
 
+    /* Initialize the context parameter and any driver handles */
+    OE_CHECK(
+        oe_sgx_initialize_load_context(
+            &context, OE_SGX_LOAD_TYPE_CREATE, flags));
+
+    /* Build the enclave */
+    OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
+
 #if defined(_WIN32)
 
     /* Create Windows events for each TCS binding. Enclaves use
@@ -1467,14 +1845,6 @@ oe_result_t oe_create_enclave(
 
 #endif
 
-    /* Initialize the context parameter and any driver handles */
-    OE_CHECK(
-        oe_sgx_initialize_load_context(
-            &context, OE_SGX_LOAD_TYPE_CREATE, flags));
-
-    /* Build the enclave */
-    OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
-
     /* Push the new created enclave to the global list. */
     if (_oe_push_enclave_instance(enclave) != 0)
     {
@@ -1490,9 +1860,27 @@ oe_result_t oe_create_enclave(
     enclave->ocalls = (const oe_ocall_func_t*)ocall_table;
     enclave->num_ocalls = ocall_table_size;
 
+    /* Publish the time before the enclave can read it */
+    if (flags & OE_ENCLAVE_FLAG_SHARED_TIME)
+        OE_CHECK(oe_start_time_page(enclave));
+
+    /* Start the switchless OCALL workers before any OCALL can be made */
+    if (flags & OE_ENCLAVE_FLAG_SWITCHLESS)
+    {
+        OE_CHECK(
+            oe_start_switchless_ocall_workers(enclave, num_host_workers));
+    }
+
     /* Invoke enclave initialization. */
     OE_CHECK(_initialize_enclave(enclave));
 
+    /* Park the switchless ECALL workers once the enclave is initialized */
+    if (flags & OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS)
+    {
+        OE_CHECK(
+            oe_start_switchless_ecall_workers(enclave, num_enclave_workers));
+    }
+
     *enclave_out = enclave;
     result = OE_OK;
 
@@ -1500,10 +1888,18 @@ done:
 
     if (result != OE_OK && enclave)
     {
+        oe_stop_switchless_ecall_workers(enclave);
+        oe_stop_switchless_ocall_workers(enclave);
+        oe_stop_time_page(enclave);
+
         for (size_t i = 0; i < enclave->num_ecalls; i++)
             free(enclave->ecalls[i].name);
 
         free(enclave->ecalls);
+        free(enclave->ecall_index);
+        oe_free_host_funcs(enclave);
+        oe_free_symbol_index(enclave);
+        FreeThreadBindings(enclave);
         free(enclave);
     }
 
@@ -1520,9 +1916,19 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     if (!enclave || enclave->magic != ENCLAVE_MAGIC)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Release the TCSs held by switchless ECALL workers before the enclave
+     * destructor runs */
+    oe_stop_switchless_ecall_workers(enclave);
+
     /* Call the enclave destructor */
     OE_CHECK(oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL));
 
+    /* The enclave makes no more OCALLs, stop the switchless workers */
+    oe_stop_switchless_ocall_workers(enclave);
+
+    /* Nor reads the time */
+    oe_stop_time_page(enclave);
+
     /* Notify GDB that this enclave is terminated */
     _oe_notify_gdb_enclave_termination(
         enclave, enclave->path, (uint32_t)strlen(enclave->path));
@@ -1548,6 +1954,7 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
                 free(enclave->ecalls[i].name);
 
             free(enclave->ecalls);
+            free(enclave->ecall_index);
         }
 
 #if defined(_WIN32)
@@ -1561,8 +1968,17 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 
 #endif
 
+        /* Release the thread binding table */
+        FreeThreadBindings(enclave);
+
+        /* Invalidate the host functions interned for oe_call_host() */
+        oe_free_host_funcs(enclave);
+
         /* Free the path name of the enclave image file */
         free(enclave->path);
+
+        /* Release the symbol index used for backtraces */
+        oe_free_symbol_index(enclave);
     }
     /* Release and destroy the mutex object */
     oe_mutex_unlock(&enclave->lock);
@@ -85,6 +85,35 @@ done:
     return result;
 }
 
+oe_result_t oe_sha256_clone(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sha256_context_impl_t* dest_impl = (oe_sha256_context_impl_t*)dest;
+    const oe_sha256_context_impl_t* src_impl =
+        (const oe_sha256_context_impl_t*)src;
+
+    if (!dest || !src)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+#if defined(__linux__)
+    dest_impl->ctx = src_impl->ctx;
+#elif defined(_WIN32)
+    if (BCryptDuplicateHash(
+            src_impl->handle, &dest_impl->handle, NULL, 0, 0) !=
+        STATUS_SUCCESS)
+    {
+        OE_RAISE(OE_FAILURE);
+    }
+#endif
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sha256_final(oe_sha256_context_t* context, OE_SHA256* sha256)
 {
     oe_result_t result = OE_UNEXPECTED;
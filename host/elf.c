@@ -13,6 +13,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "fopen.h"
 #include "strings.h"
 
@@ -330,6 +335,71 @@ done:
     return rc;
 }
 
+int elf64_map(const char* path, elf64_t* elf)
+{
+#if defined(__linux__)
+    int rc = -1;
+    int fd = -1;
+    struct stat statbuf;
+    void* data = MAP_FAILED;
+
+    if (elf)
+        memset(elf, 0, sizeof(elf64_t));
+
+    if (!path || !elf)
+        goto done;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+        goto done;
+
+    if (fstat(fd, &statbuf) != 0)
+        goto done;
+
+    /* Reject non-regular and empty files */
+    if (!S_ISREG(statbuf.st_mode) || statbuf.st_size == 0)
+        goto done;
+
+    /* Map the file. Pages are read in only as they are touched, so loading
+     * a large image does not copy it into the heap first. */
+    data = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED)
+        goto done;
+
+    elf->data = data;
+    elf->size = statbuf.st_size;
+    elf->mapped = 1;
+
+    /* Validate the ELF file. */
+    if (!_is_valid_elf64(elf))
+        goto done;
+
+    /* Set the magic number */
+    elf->magic = ELF_MAGIC;
+
+    rc = 0;
+
+done:
+
+    if (fd != -1)
+        close(fd);
+
+    if (rc != 0)
+    {
+        if (data != MAP_FAILED)
+            munmap(data, statbuf.st_size);
+
+        if (elf)
+            memset(elf, 0, sizeof(elf64_t));
+    }
+
+    return rc;
+#else
+    /* No mapping support on this platform: read the file instead */
+    return elf64_load(path, elf);
+#endif
+}
+
 int elf64_unload(elf64_t* elf)
 {
     int rc = -1;
@@ -337,7 +407,14 @@ int elf64_unload(elf64_t* elf)
     if (!_is_valid_elf64(elf))
         goto done;
 
+#if defined(__linux__)
+    if (elf->mapped)
+        munmap(elf->data, elf->size);
+    else
+        free(elf->data);
+#else
     free(elf->data);
+#endif
 
     rc = 0;
 
@@ -1511,8 +1588,9 @@ int elf64_add_section(
     mem_t mem;
     elf64_shdr_t sh;
 
-    /* Reject invalid parameters */
-    if (!_is_valid_elf64(elf) || !name || !secdata || !secsize)
+    /* Reject invalid parameters (mapped images are read-only) */
+    if (!_is_valid_elf64(elf) || elf->mapped || !name || !secdata ||
+        !secsize)
         GOTO(done);
 
     /* Fail if new section name is invalid */
@@ -1683,7 +1761,7 @@ oe_result_t elf64_remove_section(elf64_t* elf, const char* name)
     oe_result_t result = OE_UNEXPECTED;
 
     /* Reject invalid parameters */
-    if (!_is_valid_elf64(elf) || !name)
+    if (!_is_valid_elf64(elf) || elf->mapped || !name)
         goto done;
 
     /* Find index of this section */
@@ -3,32 +3,88 @@
 
 #include "enclave.h"
 #include <assert.h>
+#include <stdlib.h>
 #include <openenclave/host.h>
 
-/* Get the event object from the enclave for the given TCS */
-EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs)
+/* Chain all bindings into the free list, lowest index on top, and record the
+ * TCS stride. Called before any thread can enter the enclave. */
+void InitThreadBindings(oe_enclave_t* enclave)
 {
-    EnclaveEvent* event = NULL;
+    size_t n = enclave->num_bindings;
 
-    if (!enclave)
-        return NULL;
+    for (size_t i = 0; i < n; i++)
+    {
+        enclave->free_binding_next[i] =
+            (i + 1 < n) ? (uint32_t)(i + 1) : OE_THREAD_BINDING_NONE;
+    }
 
-    oe_mutex_lock(&enclave->lock);
+    enclave->free_bindings = n ? 0 : OE_THREAD_BINDING_NONE;
+
+    /* TCSs are normally laid out at a fixed distance from each other */
+    enclave->tcs_stride = 0;
+
+    if (n > 1)
     {
-        size_t i;
+        uint64_t first = enclave->bindings[0].tcs;
+        uint64_t stride = enclave->bindings[1].tcs - first;
 
-        for (i = 0; i < enclave->num_bindings; i++)
+        for (size_t i = 2; i < n && stride; i++)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
-
-            if (binding->tcs == tcs)
-            {
-                event = &binding->event;
-                break;
-            }
+            if (enclave->bindings[i].tcs != first + i * stride)
+                stride = 0;
         }
+
+        enclave->tcs_stride = stride;
     }
-    oe_mutex_unlock(&enclave->lock);
+}
+
+void FreeThreadBindings(oe_enclave_t* enclave)
+{
+    free(enclave->bindings);
+    free(enclave->free_binding_next);
+    enclave->bindings = NULL;
+    enclave->free_binding_next = NULL;
+    enclave->num_bindings = 0;
+}
+
+/* Get the binding for the given TCS. Binding TCS addresses never change after
+ * the enclave is built, so no lock is needed. */
+ThreadBinding* GetThreadBindingByTCS(oe_enclave_t* enclave, uint64_t tcs)
+{
+    uint64_t first;
+
+    if (!enclave || !enclave->num_bindings)
+        return NULL;
+
+    first = enclave->bindings[0].tcs;
+
+    if (tcs < first)
+        return NULL;
+
+    if (enclave->tcs_stride)
+    {
+        uint64_t i = (tcs - first) / enclave->tcs_stride;
+
+        if (i < enclave->num_bindings && enclave->bindings[i].tcs == tcs)
+            return &enclave->bindings[i];
+
+        return NULL;
+    }
+
+    /* Irregular layout: fall back to a scan */
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        if (enclave->bindings[i].tcs == tcs)
+            return &enclave->bindings[i];
+    }
+
+    return NULL;
+}
+
+/* Get the event object from the enclave for the given TCS */
+EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs)
+{
+    ThreadBinding* binding = GetThreadBindingByTCS(enclave, tcs);
 
-    return event;
+    return binding ? &binding->event : NULL;
 }
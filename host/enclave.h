@@ -7,6 +7,7 @@
 #include <openenclave/bits/properties.h>
 #include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <stdbool.h>
 #include "asmdefs.h"
@@ -32,7 +33,7 @@ typedef struct _ecall_name_addr
     /* ECALL function name */
     char* name;
 
-    /* Code of the name field, calculated by StrCode() */
+    /* Hash of the name field, calculated by oe_fnv1a_hash() */
     uint64_t code;
 
     /* Virtual address of ECALL function */
@@ -89,6 +90,32 @@ OE_STATIC_ASSERT(OE_OFFSETOF(ThreadBinding, tcs) == ThreadBinding_tcs);
 /* Get thread data from thread-specific data (TSD) */
 ThreadBinding* GetThreadBinding(void);
 
+/* Terminates the free-binding list (see oe_enclave_t.free_bindings) */
+#define OE_THREAD_BINDING_NONE 0xFFFFFFFFUL
+
+/* Host function resolved for oe_call_host(), see _find_host_func() */
+typedef struct _host_func
+{
+    /* Hash of the name field, calculated by oe_fnv1a_hash() */
+    uint64_t hash;
+    char* name;
+    oe_host_func_t func;
+} HostFunc;
+
+/* Worker threads servicing switchless calls (see switchless.c) */
+typedef struct _oe_switchless_workers oe_switchless_workers_t;
+
+/* Host thread updating the enclave time page (see timepage.c) */
+typedef struct _oe_time_updater oe_time_updater_t;
+
+/* Function symbols of the enclave image, for backtraces (see symbols.c) */
+typedef struct _oe_symbol_index oe_symbol_index_t;
+
+/* Version of the oe_enclave_t layout read by the debugger. Version 1 embedded
+ * a fixed array of 32 bindings at offset 0x28, where version 2 and later store
+ * this version number instead. */
+#define OE_ENCLAVE_DEBUG_LAYOUT_VERSION 2
+
 /**
  *  This structure must be kept in sync with the defines in
  *  debugger/pythonExtension/gdb_sgx_plugin.py.
@@ -110,9 +137,19 @@ struct _oe_enclave
     /* Size of enclave in bytes */
     uint64_t size;
 
-    /* Array of thread bindings */
-    ThreadBinding bindings[OE_SGX_MAX_TCS];
+    /* Layout of this structure (OE_ENCLAVE_DEBUG_LAYOUT_VERSION) */
+    uint64_t debug_layout_version;
+
+    /* Array of thread bindings, one per TCS, allocated at load time */
+    ThreadBinding* bindings;
     size_t num_bindings;
+
+    /* Debug mode */
+    bool debug;
+
+    /* Simulation mode */
+    bool simulate;
+
     oe_mutex lock;
 
     /* Hash of enclave (MRENCLAVE) */
@@ -122,15 +159,42 @@ struct _oe_enclave
     ECallNameAddr* ecalls;
     size_t num_ecalls;
 
+    /* Hash index over ecalls[] (see _build_ecall_array()) */
+    uint32_t* ecall_index;
+    size_t ecall_index_mask;
+
     /* Array of ocall functions */
     const oe_ocall_func_t* ocalls;
     size_t num_ocalls;
 
-    /* Debug mode */
-    bool debug;
+    /* Switchless OCALL request ring shared with the enclave (or null) */
+    oe_switchless_ring_t* switchless_ring;
+    oe_switchless_workers_t* switchless_workers;
 
-    /* Simulation mode */
-    bool simulate;
+    /* Switchless ECALL request ring shared with the enclave (or null) */
+    oe_switchless_ring_t* switchless_ecall_ring;
+    oe_switchless_workers_t* switchless_ecall_workers;
+
+    /* Host thread publishing the time to the enclave (or null) */
+    oe_time_updater_t* time_updater;
+
+    /* Index of function symbols, built at creation (or null) */
+    oe_symbol_index_t* symbols;
+
+    /* Lock-free stack of unbound TCSs: the low 32 bits hold the index of the
+     * top binding (or OE_THREAD_BINDING_NONE), the high 32 bits hold a tag
+     * bumped on every update to defeat ABA */
+    volatile uint64_t free_bindings;
+    uint32_t* free_binding_next;
+
+    /* Distance between consecutive TCS addresses, for O(1) lookup by TCS */
+    uint64_t tcs_stride;
+
+    /* Host functions called by name from this enclave, indexed by the ID
+     * interned in the enclave. Entries are appended under the lock and never
+     * change afterwards. */
+    HostFunc host_funcs[OE_CALL_HOST_MAX_FUNCS];
+    volatile uint64_t num_host_funcs;
 };
 
 // Static asserts for consistency with
@@ -140,14 +204,29 @@ OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, magic) == 0);
 // Python plugin seems to code this as just 2.
 OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, addr) == 2 * sizeof(void*));
 
-// The fields up to binding correspond to 'ENCLAVE_HEADER'
-OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, bindings) == 0x28);
+// The fields up to the version correspond to 'ENCLAVE_HEADER'
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug_layout_version) == 0x28);
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, bindings) == 0x30);
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, num_bindings) == 0x38);
+OE_STATIC_ASSERT(sizeof(ThreadBinding) == 0x28);
 
-OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0x598);
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0x40);
 OE_STATIC_ASSERT(
     OE_OFFSETOF(oe_enclave_t, debug) + 1 ==
     OE_OFFSETOF(oe_enclave_t, simulate));
 
+/* Chain all bindings into the free list once the TCSs are laid out */
+void InitThreadBindings(oe_enclave_t* enclave);
+
+/* Release the thread binding table allocated when building the enclave */
+void FreeThreadBindings(oe_enclave_t* enclave);
+
+/* Get the binding for the given TCS in constant time */
+ThreadBinding* GetThreadBindingByTCS(oe_enclave_t* enclave, uint64_t tcs);
+
+/* Release the host functions interned for oe_call_host() (see calls.c) */
+void oe_free_host_funcs(oe_enclave_t* enclave);
+
 /* Get the event for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs);
 
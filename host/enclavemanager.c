@@ -162,13 +162,11 @@ oe_enclave_t* _oe_query_enclave_instance(void* tcs)
         OE_LIST_FOREACH(tmp, &g_enclave_list_head, next_entry)
         {
             oe_enclave_t* enclave = tmp->enclave;
-            for (uint32_t i = 0; i < OE_COUNTOF(enclave->bindings); i++)
+
+            if (GetThreadBindingByTCS(enclave, (uint64_t)tcs))
             {
-                if (enclave->bindings[i].tcs == (uint64_t)tcs)
-                {
-                    ret = enclave;
-                    goto cleanup;
-                }
+                ret = enclave;
+                goto cleanup;
             }
         }
     }
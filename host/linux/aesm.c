@@ -9,6 +9,9 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -27,11 +30,25 @@
 **
 **     See messages.proto from the Intel SGX SDK for the interface.
 **
+** Connections are pooled: aesm_disconnect() keeps the socket of a connection
+** whose requests succeeded open for the next aesm_connect(), so a process
+** that requests quotes or launch tokens repeatedly does not connect to the
+** service every time. Each connection carries one request at a time, and
+** concurrent requests use separate connections from the pool. A request that
+** fails on a pooled socket (for example after the service restarted) is
+** retried once on a new connection.
+**
+** The OE_AESM_SOCKET environment variable overrides the path of the service
+** socket (tests use it to talk to a mock service).
+**
 **==============================================================================
 */
 
 #define AESM_SOCKET "/var/run/aesmd/aesm.socket"
 
+/* Maximum number of idle connections kept open */
+#define AESM_POOL_SIZE 8
+
 typedef enum _wire_type {
     WIRE_TYPE_VARINT = 0,
     WIRE_TYPE_LENGTH_DELIMITED = 2
@@ -49,6 +66,12 @@ struct _aesm
 {
     uint32_t magic;
     int sock;
+
+    /* The socket came from the pool and may have been closed by AESM */
+    bool pooled;
+
+    /* A request failed and the socket must not be pooled */
+    bool broken;
 };
 
 static int _aesm_valid(const aesm_t* aesm)
@@ -274,24 +297,142 @@ done:
 
 static int _read(int sock, void* data, size_t size)
 {
-    ssize_t n;
+    uint8_t* p = (uint8_t*)data;
 
-    if ((n = read(sock, data, size)) != size)
-        return -1;
+    while (size)
+    {
+        ssize_t n = recv(sock, p, size, 0);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        /* Also fail if AESM closed the connection */
+        if (n <= 0)
+            return -1;
+
+        p += n;
+        size -= n;
+    }
 
     return 0;
 }
 
 static int _write(int sock, const void* data, size_t size)
 {
-    ssize_t n;
+    const uint8_t* p = (const uint8_t*)data;
 
-    if ((n = write(sock, data, size)) != size)
-        return -1;
+    while (size)
+    {
+        /* Do not raise SIGPIPE if AESM closed the connection */
+        ssize_t n = send(sock, p, size, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return -1;
+
+        p += n;
+        size -= n;
+    }
 
     return 0;
 }
 
+/*
+**==============================================================================
+**
+** Connection pool
+**
+**==============================================================================
+*/
+
+static pthread_mutex_t _pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _pool_once = PTHREAD_ONCE_INIT;
+static int _pool[AESM_POOL_SIZE];
+static size_t _pool_count;
+
+/* A child process must not share the connections of its parent */
+static void _reset_pool_in_child(void)
+{
+    for (size_t i = 0; i < _pool_count; i++)
+        close(_pool[i]);
+
+    _pool_count = 0;
+    pthread_mutex_init(&_pool_lock, NULL);
+}
+
+static void _initialize_pool(void)
+{
+    pthread_atfork(NULL, NULL, _reset_pool_in_child);
+}
+
+static int _open_socket(void)
+{
+    int sock = -1;
+    struct sockaddr_un addr;
+    const char* path = getenv("OE_AESM_SOCKET");
+
+    if (!path || !*path)
+        path = AESM_SOCKET;
+
+    /* Create a socket for connecting to the AESM service */
+    if ((sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+
+    /* Initialize the address */
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+
+    if (oe_strncpy_s(
+            addr.sun_path, sizeof(addr.sun_path), path, strlen(path)) != OE_OK)
+    {
+        close(sock);
+        return -1;
+    }
+
+    /* Connect to the AESM service */
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/* Take an idle connection from the pool, or return -1 if there is none */
+static int _take_pooled_socket(void)
+{
+    int sock = -1;
+
+    pthread_once(&_pool_once, _initialize_pool);
+    pthread_mutex_lock(&_pool_lock);
+
+    if (_pool_count)
+        sock = _pool[--_pool_count];
+
+    pthread_mutex_unlock(&_pool_lock);
+
+    return sock;
+}
+
+static void _return_pooled_socket(int sock)
+{
+    pthread_mutex_lock(&_pool_lock);
+
+    if (_pool_count < AESM_POOL_SIZE)
+    {
+        _pool[_pool_count++] = sock;
+        sock = -1;
+    }
+
+    pthread_mutex_unlock(&_pool_lock);
+
+    if (sock != -1)
+        close(sock);
+}
+
 static oe_result_t _write_request(
     aesm_t* aesm,
     message_type_t message_type,
@@ -401,32 +542,66 @@ done:
     return result;
 }
 
-aesm_t* aesm_connect()
+/* Send a request and receive its response. A request that fails on a pooled
+ * connection is sent again on a new connection. */
+static oe_result_t _transact(
+    aesm_t* aesm,
+    message_type_t message_type,
+    const mem_t* request,
+    mem_t* response)
 {
-    int sock = -1;
-    struct sockaddr_un addr;
-    aesm_t* aesm = NULL;
+    oe_result_t result = OE_UNEXPECTED;
 
-    /* Create a socket for connecting to the AESM service */
-    if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
-        return NULL;
+    for (;;)
+    {
+        if (_write_request(aesm, message_type, request) == OE_OK &&
+            _read_response(aesm, message_type, response) == OE_OK)
+        {
+            break;
+        }
 
-    /* Initialize the address */
-    memset(&addr, 0, sizeof(struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    oe_strncpy_s(
-        addr.sun_path, sizeof(addr.sun_path), AESM_SOCKET, strlen(AESM_SOCKET));
+        close(aesm->sock);
+        aesm->sock = -1;
 
-    /* Connect to the AESM service */
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        if (!aesm->pooled)
+        {
+            aesm->broken = true;
+            OE_RAISE(OE_FAILURE);
+        }
+
+        aesm->pooled = false;
+
+        if ((aesm->sock = _open_socket()) == -1)
+        {
+            aesm->broken = true;
+            OE_RAISE(OE_SERVICE_UNAVAILABLE);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+aesm_t* aesm_connect()
+{
+    int sock;
+    bool pooled = true;
+    aesm_t* aesm = NULL;
+
+    /* Reuse an idle connection, or connect to the AESM service */
+    if ((sock = _take_pooled_socket()) == -1)
     {
-        close(sock);
-        return NULL;
+        pooled = false;
+
+        if ((sock = _open_socket()) == -1)
+            return NULL;
     }
 
     /* Allocate and initialize the AESM struct */
     {
-        if (!(aesm = (aesm_t*)malloc(sizeof(aesm_t))))
+        if (!(aesm = (aesm_t*)calloc(1, sizeof(aesm_t))))
         {
             close(sock);
             return NULL;
@@ -434,6 +609,7 @@ aesm_t* aesm_connect()
 
         aesm->magic = AESM_MAGIC;
         aesm->sock = sock;
+        aesm->pooled = pooled;
     }
 
     return aesm;
@@ -443,7 +619,15 @@ void aesm_disconnect(aesm_t* aesm)
 {
     if (_aesm_valid(aesm))
     {
-        close(aesm->sock);
+        /* Keep the connection open for the next aesm_connect() */
+        if (aesm->sock != -1)
+        {
+            if (aesm->broken)
+                close(aesm->sock);
+            else
+                _return_pooled_socket(aesm->sock);
+        }
+
         memset(aesm, 0xDD, sizeof(aesm_t));
         free(aesm);
     }
@@ -484,11 +668,9 @@ oe_result_t aesm_get_launch_token(
         OE_CHECK(_pack_var_int(&request, 9, timeout));
     }
 
-    /* Send the request to the AESM service */
-    OE_CHECK(_write_request(aesm, MESSAGE_TYPE_GET_LAUNCH_TOKEN, &request));
-
-    /* Receive the response from AESM service */
-    OE_CHECK(_read_response(aesm, MESSAGE_TYPE_GET_LAUNCH_TOKEN, &response));
+    /* Send the request and receive the response from the AESM service */
+    OE_CHECK(
+        _transact(aesm, MESSAGE_TYPE_GET_LAUNCH_TOKEN, &request, &response));
 
     /* Unpack the response */
     {
@@ -541,11 +723,8 @@ oe_result_t aesm_init_quote(
         OE_CHECK(_pack_var_int(&request, 9, timeout));
     }
 
-    /* Send the request to the AESM service */
-    OE_CHECK(_write_request(aesm, MESSAGE_TYPE_INIT_QUOTE, &request));
-
-    /* Receive the response from AESM service */
-    OE_CHECK(_read_response(aesm, MESSAGE_TYPE_INIT_QUOTE, &response));
+    /* Send the request and receive the response from the AESM service */
+    OE_CHECK(_transact(aesm, MESSAGE_TYPE_INIT_QUOTE, &request, &response));
 
     /* Unpack the response */
     {
@@ -646,11 +825,8 @@ oe_result_t aesm_get_quote(
         OE_CHECK(_pack_var_int(&request, 9, timeout));
     }
 
-    /* Send the request to the AESM service */
-    OE_CHECK(_write_request(aesm, MESSAGE_TYPE_GET_QUOTE, &request));
-
-    /* Receive the response from AESM service */
-    OE_CHECK(_read_response(aesm, MESSAGE_TYPE_GET_QUOTE, &response));
+    /* Send the request and receive the response from the AESM service */
+    OE_CHECK(_transact(aesm, MESSAGE_TYPE_GET_QUOTE, &request, &response));
 
     /* Unpack the response */
     {
@@ -681,5 +857,8 @@ oe_result_t aesm_get_quote(
     result = OE_OK;
 
 done:
+    mem_free(&request);
+    mem_free(&response);
+
     return result;
 }
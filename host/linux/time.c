@@ -19,6 +19,19 @@ static uint64_t _time()
     return (ts.tv_sec * _SEC_TO_MSEC) + (ts.tv_nsec / _MSEC_TO_NSEC);
 }
 
+uint64_t oe_read_host_clock(oe_clock_t clock)
+{
+    struct timespec ts;
+    clockid_t id =
+        clock == OE_CLOCK_MONOTONIC ? CLOCK_MONOTONIC : CLOCK_REALTIME;
+
+    if (clock_gettime(id, &ts) != 0)
+        return 0;
+
+    return ((uint64_t)ts.tv_sec * _SEC_TO_MSEC * _MSEC_TO_NSEC) +
+           (uint64_t)ts.tv_nsec;
+}
+
 static void _sleep(uint64_t milliseconds)
 {
     struct timespec ts;
@@ -42,8 +55,19 @@ void oe_handle_sleep(uint64_t arg_in)
 
 void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out)
 {
-    OE_UNUSED(arg_in);
+    if (!arg_out)
+        return;
 
-    if (arg_out)
-        *arg_out = _time();
+    switch (arg_in)
+    {
+        case OE_GET_TIME_REALTIME_NSEC:
+            *arg_out = oe_read_host_clock(OE_CLOCK_REALTIME);
+            break;
+        case OE_GET_TIME_MONOTONIC_NSEC:
+            *arg_out = oe_read_host_clock(OE_CLOCK_MONOTONIC);
+            break;
+        default:
+            *arg_out = _time();
+            break;
+    }
 }
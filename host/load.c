@@ -1,7 +1,6 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
-#include <openenclave/bits/safecrt.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/elf.h>
 #include <openenclave/internal/load.h>
@@ -10,21 +9,17 @@
 #include <openenclave/internal/utils.h>
 #include <stdlib.h>
 #include <string.h>
-#include "memalign.h"
 
 oe_result_t __oe_load_segments(
-    const char* path,
+    const elf64_t* elf,
     oe_segment_t segments[OE_MAX_SEGMENTS],
     size_t* nsegments,
     uint64_t* entryaddr,
     uint64_t* textaddr)
 {
     oe_result_t result = OE_UNEXPECTED;
-    elf64_t elf = ELF64_INIT;
     size_t i;
     const elf64_ehdr_t* eh;
-    elf64_off_t oeinfo_offset = 0;
-    elf64_xword_t oeinfo_size = 0;
 
     if (nsegments)
         *nsegments = 0;
@@ -36,15 +31,12 @@ oe_result_t __oe_load_segments(
         *textaddr = 0;
 
     /* Check for null parameters */
-    if (!path || !segments || !nsegments || !entryaddr || !textaddr)
+    if (!elf || !segments || !nsegments || !entryaddr || !textaddr)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Load the ELF-64 object */
-    if (elf64_load(path, &elf) != 0)
-        OE_RAISE(OE_FAILURE);
-
     /* Save pointer to header for convenience */
-    eh = (elf64_ehdr_t*)elf.data;
+    if (!(eh = elf64_get_header(elf)))
+        OE_RAISE(OE_FAILURE);
 
 /* Fail if not a dynamic object */
 #if 0
@@ -63,31 +55,23 @@ oe_result_t __oe_load_segments(
     /* Save entry point address */
     *entryaddr = eh->e_entry;
 
-    /* Find the addresses of the ".text" and ".oeinfo" sections */
+    /* Find the address of the ".text" section */
     {
         for (i = 0; i < eh->e_shnum; i++)
         {
-            const elf64_shdr_t* sh = elf64_get_section_header(&elf, i);
+            const elf64_shdr_t* sh = elf64_get_section_header(elf, i);
 
             /* Invalid section header. The elf file is corrupted. */
             if (sh == NULL)
                 OE_RAISE(OE_FAILURE);
 
             const char* name =
-                elf64_get_string_from_shstrtab(&elf, sh->sh_name);
+                elf64_get_string_from_shstrtab(elf, sh->sh_name);
 
             if (name && strcmp(name, ".text") == 0)
             {
                 *textaddr = sh->sh_offset;
-            }
-            else if (name && strcmp(name, ".oeinfo") == 0)
-            {
-                oeinfo_offset = sh->sh_offset;
-                oeinfo_size = sh->sh_size;
-                OE_TRACE_INFO(
-                    "Found properties block offset %lx size %lx",
-                    oeinfo_offset,
-                    oeinfo_size);
+                break;
             }
         }
 
@@ -99,7 +83,7 @@ oe_result_t __oe_load_segments(
     /* Add all loadable program segments to SEGMENTS array */
     for (i = 0; i < eh->e_phnum; i++)
     {
-        const elf64_phdr_t* ph = elf64_get_program_header(&elf, i);
+        const elf64_phdr_t* ph = elf64_get_program_header(elf, i);
         oe_segment_t seg;
 
         /* Check for corrupted program header. */
@@ -145,34 +129,8 @@ oe_result_t __oe_load_segments(
                 seg.flags |= OE_SEGMENT_FLAG_EXEC;
         }
 
-        /* Make a heap copy of this segment */
-        if (elf64_get_segment(&elf, i))
-        {
-            if (!(seg.filedata = malloc(seg.filesz)))
-                OE_RAISE(OE_OUT_OF_MEMORY);
-
-            OE_CHECK(
-                oe_memcpy_s(
-                    seg.filedata,
-                    seg.filesz,
-                    elf64_get_segment(&elf, i),
-                    seg.filesz));
-
-            /* Zero out the .oeinfo section if within this segment */
-            if (oeinfo_size && (oeinfo_offset >= seg.offset) &&
-                (oeinfo_offset <= seg.offset + seg.filesz))
-            {
-                /* Check the section doesn't cross the end of the segment */
-                if ((oeinfo_offset + oeinfo_size) > (seg.offset + seg.filesz))
-                    OE_RAISE(OE_OUT_OF_BOUNDS);
-
-                memset( // All sizes/address calculations in bytes
-                    ((char*)seg.filedata) + oeinfo_offset - seg.offset,
-                    0,
-                    oeinfo_size);
-                OE_TRACE_INFO("Zeroed out properties block in segment %lu", i);
-            }
-        }
+        /* Refer to the segment data in place */
+        seg.filedata = elf64_get_segment(elf, i);
 
         /* Check for array overflow */
         if (*nsegments == OE_MAX_SEGMENTS)
@@ -190,21 +148,8 @@ oe_result_t __oe_load_segments(
 
 done:
 
-    if (result != OE_OK)
-    {
-        if (segments)
-        {
-            for (i = 0; i < *nsegments; i++)
-            {
-                oe_segment_t* seg = &segments[i];
-                free(seg->filedata);
-            }
-
-            *nsegments = 0;
-        }
-    }
-
-    elf64_unload(&elf);
+    if (result != OE_OK && nsegments)
+        *nsegments = 0;
 
     return result;
 }
@@ -255,77 +200,3 @@ done:
 
     return result;
 }
-
-oe_result_t __oe_combine_segments(
-    const oe_segment_t* segments,
-    size_t nsegments,
-    oe_page_t** pages,
-    size_t* npages)
-{
-    oe_result_t result = OE_UNEXPECTED;
-    uint64_t lo = 0xFFFFFFFFFFFFFFFF; /* lowest address of all segments */
-    uint64_t hi = 0;                  /* highest address of all segments */
-    size_t i;
-    unsigned char* data = NULL;
-    size_t size;
-
-    if (pages)
-        *pages = NULL;
-
-    if (npages)
-        *npages = 0;
-
-    /* Reject bad parameters */
-    if (!segments || nsegments == 0 || !pages || !npages)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
-    /* Calculate boundaries (LO and HI) of the image */
-    {
-        for (i = 0; i < nsegments; i++)
-        {
-            const oe_segment_t* seg = &segments[i];
-
-            if (seg->vaddr < lo)
-                lo = seg->vaddr;
-
-            if (seg->vaddr + seg->memsz > hi)
-                hi = seg->vaddr + seg->memsz;
-        }
-
-        if (lo != 0)
-            OE_RAISE(OE_FAILURE);
-
-        if (hi == 0)
-            OE_RAISE(OE_FAILURE);
-    }
-
-    /* Calculate the full size of the image (rounded up to the page size) */
-    OE_CHECK(__oe_calculate_segments_size(segments, nsegments, &size));
-
-    /* Allocate data on a page boundary */
-    if (!(data = (unsigned char*)oe_memalign(OE_PAGE_SIZE, size)))
-        OE_RAISE(OE_OUT_OF_MEMORY);
-
-    /* Clear the image memory */
-    memset(data, 0, size);
-
-    /* Copy data from ELF file onto image memory */
-    for (i = 0; i < nsegments; i++)
-    {
-        const oe_segment_t* seg = &segments[i];
-        OE_CHECK(
-            oe_memcpy_s(
-                data + seg->vaddr, seg->filesz, seg->filedata, seg->filesz));
-    }
-
-    *pages = (oe_page_t*)data;
-    *npages = size / OE_PAGE_SIZE;
-
-    result = OE_OK;
-
-done:
-    if (result != OE_OK)
-        oe_memalign_free(data);
-
-    return result;
-}
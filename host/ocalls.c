@@ -5,10 +5,12 @@
 #include <stdio.h>
 
 #if defined(__linux__)
+#include <errno.h>
 #include <linux/futex.h>
 #include <stdlib.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 #elif defined(_WIN32)
@@ -19,7 +21,6 @@
 #include <openenclave/bits/safemath.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/calls.h>
-#include <openenclave/internal/elf.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
@@ -27,6 +28,7 @@
 #include "ocalls.h"
 #include "quote.h"
 #include "sgxquoteprovider.h"
+#include "symbols.h"
 
 void HandleMalloc(uint64_t arg_in, uint64_t* arg_out)
 {
@@ -69,6 +71,74 @@ void HandlePrint(uint64_t arg_in)
     }
 }
 
+void HandleWritev(uint64_t arg_in)
+{
+    oe_writev_args_t* args = (oe_writev_args_t*)arg_in;
+    FILE* stream;
+    uint64_t iovcnt;
+
+    if (!args)
+        return;
+
+    if (args->device == 0)
+        stream = stdout;
+    else if (args->device == 1)
+        stream = stderr;
+    else
+        return;
+
+    iovcnt = args->iovcnt;
+
+    if (iovcnt > OE_WRITEV_MAX_IOV)
+        return;
+
+    /* Write out any host output buffered in the stream first */
+    fflush(stream);
+
+#if defined(__linux__)
+
+    struct iovec iov[OE_WRITEV_MAX_IOV];
+    int fd = fileno(stream);
+    uint64_t i = 0;
+
+    for (uint64_t j = 0; j < iovcnt; j++)
+    {
+        iov[j].iov_base = (void*)args->iov[j].base;
+        iov[j].iov_len = args->iov[j].len;
+    }
+
+    /* Resume after short writes until every buffer is written */
+    while (i < iovcnt)
+    {
+        ssize_t n = writev(fd, &iov[i], (int)(iovcnt - i));
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        while (i < iovcnt && (size_t)n >= iov[i].iov_len)
+            n -= (ssize_t)iov[i++].iov_len;
+
+        if (i < iovcnt)
+        {
+            iov[i].iov_base = (char*)iov[i].iov_base + n;
+            iov[i].iov_len -= (size_t)n;
+        }
+    }
+
+#elif defined(_WIN32)
+
+    for (uint64_t i = 0; i < iovcnt; i++)
+        fwrite(args->iov[i].base, 1, args->iov[i].len, stream);
+
+    fflush(stream);
+
+#endif
+}
+
 void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
 {
     const uint64_t tcs = arg_in;
@@ -103,6 +173,76 @@ void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
 #endif
 }
 
+void HandleThreadTimedWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    oe_thread_timed_wait_args_t* args = (oe_thread_timed_wait_args_t*)arg_in;
+    bool timed_out = false;
+    uint64_t now;
+
+    if (!args)
+        return;
+
+    const uint64_t tcs = (uint64_t)args->tcs;
+    const uint64_t deadline = args->deadline;
+    EnclaveEvent* event = GetEnclaveEvent(enclave, tcs);
+    assert(event);
+
+#if defined(__linux__)
+
+    if (__sync_fetch_and_add(&event->value, -1) == 0)
+    {
+        do
+        {
+            oe_handle_get_time(0, &now);
+
+            if (now >= deadline)
+            {
+                // Cancel the wait, unless a wake raced with the timeout (in
+                // which case event->value is no longer -1 and the loop ends).
+                if (__sync_bool_compare_and_swap(&event->value, -1, 0))
+                {
+                    timed_out = true;
+                    break;
+                }
+
+                continue;
+            }
+
+            struct timespec ts;
+            ts.tv_sec = (time_t)((deadline - now) / 1000);
+            ts.tv_nsec = (long)(((deadline - now) % 1000) * 1000000);
+
+            syscall(
+                __NR_futex,
+                &event->value,
+                FUTEX_WAIT_PRIVATE,
+                -1,
+                &ts,
+                NULL,
+                0);
+            // As in HandleThreadWait(), spurious wakes and timeouts go back
+            // to FUTEX_WAIT while event->value is still -1.
+        } while (event->value == -1);
+    }
+
+#elif defined(_WIN32)
+
+    oe_handle_get_time(0, &now);
+
+    DWORD timeout = now < deadline ? (DWORD)(deadline - now) : 0;
+
+    if (WaitForSingleObject(event->handle, timeout) == WAIT_TIMEOUT)
+        timed_out = true;
+
+#endif
+
+    if (arg_out)
+        *arg_out = timed_out;
+}
+
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg_in)
 {
     const uint64_t tcs = arg_in;
@@ -142,6 +282,21 @@ void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in)
 #endif
 }
 
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in)
+{
+    oe_thread_wake_multiple_args_t* args =
+        (oe_thread_wake_multiple_args_t*)arg_in;
+
+    if (!args)
+        return;
+
+    /* Read the count once, since the enclave owns this buffer */
+    const uint64_t num_tcs = args->num_tcs;
+
+    for (uint64_t i = 0; i < num_tcs; i++)
+        HandleThreadWake(enclave, (uint64_t)args->tcs[i]);
+}
+
 void HandleGetQuote(uint64_t arg_in)
 {
     oe_get_quote_args_t* args = (oe_get_quote_args_t*)arg_in;
@@ -181,24 +336,18 @@ static char** _backtrace_symbols(
     int size)
 {
     char** ret = NULL;
-    elf64_t elf = ELF64_INIT;
-    bool elf_loaded = false;
     size_t malloc_size = 0;
     const char unknown[] = "<unknown>";
+    const char** names = NULL;
     char* ptr = NULL;
 
-    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !buffer || !size)
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !buffer || size <= 0)
         goto done;
 
-    /* Open the enclave ELF64 image */
-    {
-        if (elf64_load(enclave->path, &elf) != 0)
-            goto done;
-
-        elf_loaded = true;
-    }
+    if (!(names = (const char**)calloc((size_t)size, sizeof(char*))))
+        goto done;
 
-    /* Determine total memory requirements */
+    /* Look up each name once and determine total memory requirements */
     {
         /* Calculate space for the array of string pointers */
         if (oe_safe_mul_sizet(size, sizeof(char*), &malloc_size) != OE_OK)
@@ -208,13 +357,12 @@ static char** _backtrace_symbols(
         for (int i = 0; i < size; i++)
         {
             const uint64_t vaddr = (uint64_t)buffer[i] - enclave->addr;
-            const char* name = elf64_get_function_name(&elf, vaddr);
 
-            if (!name)
-                name = unknown;
+            if (!(names[i] = oe_find_symbol_name(enclave, vaddr)))
+                names[i] = unknown;
 
-            if (oe_safe_add_sizet(malloc_size, strlen(name), &malloc_size) !=
-                OE_OK)
+            if (oe_safe_add_sizet(
+                    malloc_size, strlen(names[i]), &malloc_size) != OE_OK)
                 goto done;
 
             if (oe_safe_add_sizet(malloc_size, sizeof(char), &malloc_size) !=
@@ -236,22 +384,15 @@ static char** _backtrace_symbols(
     /* Copy strings into return buffer */
     for (int i = 0; i < size; i++)
     {
-        const uint64_t vaddr = (uint64_t)buffer[i] - enclave->addr;
-        const char* name = elf64_get_function_name(&elf, vaddr);
-
-        if (!name)
-            name = unknown;
-
-        size_t name_size = strlen(name) + sizeof(char);
-        oe_memcpy_s(ptr, name_size, name, name_size);
+        size_t name_size = strlen(names[i]) + sizeof(char);
+        oe_memcpy_s(ptr, name_size, names[i], name_size);
         ret[i] = ptr;
         ptr += name_size;
     }
 
 done:
 
-    if (elf_loaded)
-        elf64_unload(&elf);
+    free(names);
 
     return ret;
 }
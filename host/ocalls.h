@@ -4,17 +4,26 @@
 #ifndef _OE_HOST_OCALLS_H
 #define _OE_HOST_OCALLS_H
 
+#include <openenclave/internal/time.h>
 #include "enclave.h"
 
+void oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave);
+
 void HandlePrint(uint64_t arg_in);
+void HandleWritev(uint64_t arg_in);
 
 void HandleMalloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleRealloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleFree(uint64_t arg);
 
 void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg);
+void HandleThreadTimedWait(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out);
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg);
 void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in);
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in);
 
 void HandleGetQuote(uint64_t arg_in);
 void HandleGetQETargetInfo(uint64_t arg_in);
@@ -24,6 +33,9 @@ void oe_handle_sleep(uint64_t arg_in);
 
 void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out);
 
+/* Read a host clock in nanoseconds (0 on error) */
+uint64_t oe_read_host_clock(oe_clock_t clock);
+
 void oe_handle_backtrace_symbols(oe_enclave_t* enclave, uint64_t arg);
 
 #endif /* _OE_HOST_OCALLS_H */
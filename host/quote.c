@@ -9,6 +9,7 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/utils.h>
+#include "hostthread.h"
 
 #if defined(OE_USE_LIBSGX)
 #include "sgxquote.h"
@@ -142,7 +143,28 @@ done:
 
 #endif
 
-oe_result_t sgx_get_qetarget_info(sgx_target_info_t* target_info)
+/*
+**==============================================================================
+**
+** Quoting Enclave target info cache:
+**
+**     The target info of the Quoting Enclave changes only when the QE is
+**     updated or the platform TCB changes, so it is fetched once per process.
+**     So is the quote size reported by the QE. A report targeted at an
+**     outdated QE fails to be quoted, so a failed quote request drops both
+**     and the next request fetches them again.
+**
+**==============================================================================
+*/
+
+static sgx_target_info_t _qe_target_info;
+static bool _qe_target_info_cached;
+#if defined(OE_USE_LIBSGX)
+static size_t _qe_quote_size;
+#endif
+static oe_mutex _qe_target_info_lock = OE_H_MUTEX_INITIALIZER;
+
+static oe_result_t _sgx_get_qetarget_info(sgx_target_info_t* target_info)
 {
     oe_result_t result = OE_UNEXPECTED;
     memset(target_info, 0, sizeof(sgx_target_info_t));
@@ -165,6 +187,46 @@ done:
     return result;
 }
 
+oe_result_t sgx_get_qetarget_info(sgx_target_info_t* target_info)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!target_info)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_mutex_lock(&_qe_target_info_lock);
+
+    if (!_qe_target_info_cached)
+    {
+        result = _sgx_get_qetarget_info(&_qe_target_info);
+        _qe_target_info_cached = (result == OE_OK);
+    }
+    else
+    {
+        result = OE_OK;
+    }
+
+    if (result == OE_OK)
+        *target_info = _qe_target_info;
+
+    oe_mutex_unlock(&_qe_target_info_lock);
+
+    OE_CHECK(result);
+
+done:
+    return result;
+}
+
+void sgx_invalidate_qetarget_info(void)
+{
+    oe_mutex_lock(&_qe_target_info_lock);
+    _qe_target_info_cached = false;
+#if defined(OE_USE_LIBSGX)
+    _qe_quote_size = 0;
+#endif
+    oe_mutex_unlock(&_qe_target_info_lock);
+}
+
 oe_result_t sgx_get_quote_size(size_t* quote_size)
 {
     oe_result_t result = OE_UNEXPECTED;
@@ -177,7 +239,21 @@ oe_result_t sgx_get_quote_size(size_t* quote_size)
 
 #if defined(OE_USE_LIBSGX)
 
-    result = oe_sgx_qe_get_quote_size(quote_size);
+    oe_mutex_lock(&_qe_target_info_lock);
+
+    if (_qe_quote_size == 0)
+    {
+        if ((result = oe_sgx_qe_get_quote_size(&_qe_quote_size)) != OE_OK)
+            _qe_quote_size = 0;
+    }
+    else
+    {
+        result = OE_OK;
+    }
+
+    *quote_size = _qe_quote_size;
+
+    oe_mutex_unlock(&_qe_target_info_lock);
 
 #else
 
@@ -235,6 +311,10 @@ oe_result_t sgx_get_quote(
         *quote_size);
 #endif
 
+    // The report may target a Quoting Enclave that has since changed.
+    if (result != OE_OK)
+        sgx_invalidate_qetarget_info();
+
 done:
 
     return result;
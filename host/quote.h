@@ -28,6 +28,20 @@ oe_result_t sgx_get_quote_size(size_t* quote_size);
 
 oe_result_t sgx_get_qetarget_info(sgx_target_info_t* target_info);
 
+/*
+**==============================================================================
+**
+** sgx_invalidate_qetarget_info()
+**
+**     Drop the Quoting Enclave target info and quote size cached by
+**     sgx_get_qetarget_info() and sgx_get_quote_size(). sgx_get_quote() calls
+**     it when quoting fails.
+**
+**==============================================================================
+*/
+
+void sgx_invalidate_qetarget_info(void);
+
 /*
 **==============================================================================
 **
@@ -7,9 +7,17 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/utils.h>
+#include <stdlib.h>
 #include "../common/quote.h"
+#include "hostthread.h"
 #include "quote.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
 #if defined(OE_USE_LIBSGX)
 #include "sgxquoteprovider.h"
 #endif
@@ -24,7 +32,7 @@ static oe_result_t _oe_get_local_report(
     size_t* report_buffer_size)
 {
     oe_result_t result = OE_UNEXPECTED;
-    oe_get_sgx_report_args_t* arg = NULL;
+    oe_get_sgx_report_args_t arg = {0};
 
     // opt_params, if specified, must be a sgx_target_info_t. When opt_params is
     // NULL, opt_params_size must be zero.
@@ -46,34 +54,26 @@ static oe_result_t _oe_get_local_report(
     /*
      * Populate arg fields.
      */
-    arg = calloc(1, sizeof(*arg));
-    if (arg == NULL)
-        OE_RAISE(OE_OUT_OF_MEMORY);
-
     if (opt_params != NULL)
         OE_CHECK(
             oe_memcpy_s(
-                arg->opt_params, opt_params_size, opt_params, opt_params_size));
+                arg.opt_params, opt_params_size, opt_params, opt_params_size));
 
-    arg->opt_params_size = opt_params_size;
+    arg.opt_params_size = opt_params_size;
 
-    OE_CHECK(oe_ecall(enclave, OE_ECALL_GET_SGX_REPORT, (uint64_t)arg, NULL));
+    OE_CHECK(oe_ecall(enclave, OE_ECALL_GET_SGX_REPORT, (uint64_t)&arg, NULL));
 
     OE_CHECK(
         oe_memcpy_s(
             report_buffer,
             *report_buffer_size,
-            &arg->sgx_report,
+            &arg.sgx_report,
             sizeof(sgx_report_t)));
     *report_buffer_size = sizeof(sgx_report_t);
     result = OE_OK;
 
 done:
-    if (arg)
-    {
-        oe_secure_zero_fill(arg, sizeof(*arg));
-        free(arg);
-    }
+    oe_secure_zero_fill(&arg, sizeof(arg));
 
     return result;
 }
@@ -86,9 +86,10 @@ static oe_result_t _oe_get_remote_report(
     size_t* report_buffer_size)
 {
     oe_result_t result = OE_UNEXPECTED;
-    sgx_target_info_t* sgx_target_info = NULL;
-    sgx_report_t* sgx_report = NULL;
+    sgx_target_info_t sgx_target_info = {{0}};
+    sgx_report_t sgx_report = {{{0}}};
     size_t sgx_report_size = sizeof(sgx_report_t);
+    size_t quote_size = 0;
 
     // For remote attestation, the Quoting Enclave's target info is used.
     // opt_params must not be supplied.
@@ -101,57 +102,64 @@ static oe_result_t _oe_get_remote_report(
     if (report_buffer == NULL)
         *report_buffer_size = 0;
 
-    /*
-     * Get target info from Quoting Enclave.
-     */
-    sgx_target_info = calloc(1, sizeof(sgx_target_info_t));
-
-    if (sgx_target_info == NULL)
-        OE_RAISE(OE_OUT_OF_MEMORY);
+    // Report the quote size without creating a report for a buffer that is
+    // too small.
+    OE_CHECK(sgx_get_quote_size(&quote_size));
 
-    OE_CHECK(sgx_get_qetarget_info(sgx_target_info));
+    if (*report_buffer_size < quote_size)
+    {
+        *report_buffer_size = quote_size;
+        OE_RAISE(OE_BUFFER_TOO_SMALL);
+    }
 
-    /*
-     * Get sgx_report_t from the enclave.
-     */
-    sgx_report = (sgx_report_t*)calloc(1, sizeof(sgx_report_t));
+    // A quote fails if the cached target info of the Quoting Enclave is out
+    // of date. sgx_get_quote() then drops it, so try once more with the
+    // current target info.
+    for (size_t attempt = 0; attempt < 2; attempt++)
+    {
+        size_t size = *report_buffer_size;
 
-    if (sgx_report == NULL)
-        OE_RAISE(OE_OUT_OF_MEMORY);
+        /*
+         * Get target info from Quoting Enclave.
+         */
+        OE_CHECK(sgx_get_qetarget_info(&sgx_target_info));
 
-    OE_CHECK(
-        _oe_get_local_report(
-            enclave,
-            sgx_target_info,
-            sizeof(*sgx_target_info),
-            (uint8_t*)sgx_report,
-            &sgx_report_size));
+        /*
+         * Get sgx_report_t from the enclave.
+         */
+        OE_CHECK(
+            _oe_get_local_report(
+                enclave,
+                &sgx_target_info,
+                sizeof(sgx_target_info),
+                (uint8_t*)&sgx_report,
+                &sgx_report_size));
+
+        /*
+         * Get quote from Quoting Enclave.
+         */
+        result = sgx_get_quote(&sgx_report, report_buffer, &size);
+
+        if (result == OE_OK || result == OE_BUFFER_TOO_SMALL ||
+            result == OE_INVALID_PARAMETER)
+        {
+            *report_buffer_size = size;
+            break;
+        }
+    }
 
-    /*
-     * Get quote from Quoting Enclave.
-     */
-    OE_CHECK(sgx_get_quote(sgx_report, report_buffer, report_buffer_size));
+    OE_CHECK(result);
 
     result = OE_OK;
 
 done:
-
-    if (sgx_target_info)
-    {
-        oe_secure_zero_fill(sgx_target_info, sizeof(*sgx_target_info));
-        free(sgx_target_info);
-    }
-
-    if (sgx_report)
-    {
-        oe_secure_zero_fill(sgx_report, sizeof(*sgx_report));
-        free(sgx_report);
-    }
+    oe_secure_zero_fill(&sgx_target_info, sizeof(sgx_target_info));
+    oe_secure_zero_fill(&sgx_report, sizeof(sgx_report));
 
     return result;
 }
 
-oe_result_t oe_get_report(
+static oe_result_t _get_report(
     oe_enclave_t* enclave,
     uint32_t flags,
     const void* opt_params,
@@ -162,12 +170,6 @@ oe_result_t oe_get_report(
     oe_result_t result = OE_FAILURE;
     oe_report_header_t* header = (oe_report_header_t*)report_buffer;
 
-#if defined(OE_USE_LIBSGX)
-    // The two host side attestation API's are oe_get_report and
-    // oe_verify_report. Initialize the quote provider in both these APIs.
-    OE_CHECK(oe_initialize_quote_provider());
-#endif
-
     // Reserve space in the buffer for header.
     if (report_buffer && report_buffer_size)
     {
@@ -225,7 +227,38 @@ done:
     return result;
 }
 
-oe_result_t oe_verify_report(
+oe_result_t oe_get_report(
+    oe_enclave_t* enclave,
+    uint32_t flags,
+    const void* opt_params,
+    size_t opt_params_size,
+    uint8_t* report_buffer,
+    size_t* report_buffer_size)
+{
+    oe_result_t result = OE_FAILURE;
+
+#if defined(OE_USE_LIBSGX)
+    // The two host side attestation API's are oe_get_report and
+    // oe_verify_report. Initialize the quote provider in both these APIs.
+    OE_CHECK(oe_initialize_quote_provider());
+#endif
+
+    OE_CHECK(
+        _get_report(
+            enclave,
+            flags,
+            opt_params,
+            opt_params_size,
+            report_buffer,
+            report_buffer_size));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static oe_result_t _verify_report(
     oe_enclave_t* enclave,
     const uint8_t* report,
     size_t report_size,
@@ -236,12 +269,6 @@ oe_result_t oe_verify_report(
     oe_verify_report_args_t arg = {0};
     oe_report_header_t* header = (oe_report_header_t*)report;
 
-#if defined(OE_USE_LIBSGX)
-    // The two host side attestation API's are oe_get_report and
-    // oe_verify_report. Initialize the quote provider in both these APIs.
-    OE_CHECK(oe_initialize_quote_provider());
-#endif
-
     if (report == NULL)
         OE_RAISE(OE_INVALID_PARAMETER);
 
@@ -297,3 +324,350 @@ oe_result_t oe_verify_report(
 done:
     return result;
 }
+
+oe_result_t oe_verify_report(
+    oe_enclave_t* enclave,
+    const uint8_t* report,
+    size_t report_size,
+    oe_report_t* parsed_report)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+#if defined(OE_USE_LIBSGX)
+    // The two host side attestation API's are oe_get_report and
+    // oe_verify_report. Initialize the quote provider in both these APIs.
+    OE_CHECK(oe_initialize_quote_provider());
+#endif
+
+    OE_CHECK(_verify_report(enclave, report, report_size, parsed_report));
+
+    result = OE_OK;
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** Batches:
+**
+**     oe_get_reports() and oe_verify_reports() process a batch of reports on
+**     several threads. Each thread claims the next report of the batch until
+**     none is left, so a thread waiting for an ECALL or for the quoting
+**     service does not hold up the other reports.
+**
+**==============================================================================
+*/
+
+typedef struct _batch batch_t;
+
+struct _batch
+{
+    size_t count;
+
+    /* Process report i of the batch */
+    void (*process)(batch_t* batch, size_t i);
+
+    /* Next report to process */
+    oe_mutex lock;
+    size_t next;
+};
+
+static void _process_batch(batch_t* batch)
+{
+    for (;;)
+    {
+        size_t i;
+
+        oe_mutex_lock(&batch->lock);
+        i = batch->next++;
+        oe_mutex_unlock(&batch->lock);
+
+        if (i >= batch->count)
+            break;
+
+        batch->process(batch, i);
+    }
+}
+
+#if defined(__linux__)
+static void* _batch_thread(void* arg)
+{
+    _process_batch((batch_t*)arg);
+    return NULL;
+}
+typedef pthread_t _batch_thread_t;
+#elif defined(_WIN32)
+static DWORD WINAPI _batch_thread(LPVOID arg)
+{
+    _process_batch((batch_t*)arg);
+    return 0;
+}
+typedef HANDLE _batch_thread_t;
+#endif
+
+/* Process the batch on up to num_threads threads, including the caller */
+static oe_result_t _run_batch(batch_t* batch, size_t num_threads)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    _batch_thread_t* threads = NULL;
+    size_t num_started = 0;
+
+    if (oe_mutex_init(&batch->lock) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    batch->next = 0;
+
+    if (num_threads > batch->count)
+        num_threads = batch->count;
+
+    if (num_threads > 1)
+    {
+        threads = (_batch_thread_t*)calloc(
+            num_threads - 1, sizeof(_batch_thread_t));
+
+        /* Without threads the calling thread processes the whole batch */
+        for (size_t i = 0; threads && i < num_threads - 1; i++)
+        {
+#if defined(__linux__)
+            if (pthread_create(&threads[i], NULL, _batch_thread, batch) != 0)
+                break;
+#elif defined(_WIN32)
+            if (!(threads[i] =
+                      CreateThread(NULL, 0, _batch_thread, batch, 0, NULL)))
+                break;
+#endif
+            num_started++;
+        }
+    }
+
+    _process_batch(batch);
+
+    for (size_t i = 0; i < num_started; i++)
+    {
+#if defined(__linux__)
+        pthread_join(threads[i], NULL);
+#elif defined(_WIN32)
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#endif
+    }
+
+    free(threads);
+    oe_mutex_destroy(&batch->lock);
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_reports()
+**
+**     Get a batch of reports on several threads. Each thread makes its own
+**     ECALL and quote request, so the ECALL of one report overlaps the quote
+**     request of another, and quote requests overlap each other on separate
+**     connections to the quoting service.
+**
+**==============================================================================
+*/
+
+typedef struct _get_reports_batch
+{
+    batch_t base;
+    oe_enclave_t* enclave;
+    uint32_t flags;
+    const void* opt_params;
+    size_t opt_params_size;
+    uint8_t** report_buffers;
+    size_t* report_buffer_sizes;
+    oe_result_t* results;
+} get_reports_batch_t;
+
+static void _get_batch_report(batch_t* base, size_t i)
+{
+    get_reports_batch_t* batch = (get_reports_batch_t*)base;
+
+    batch->results[i] = _get_report(
+        batch->enclave,
+        batch->flags,
+        batch->opt_params,
+        batch->opt_params_size,
+        batch->report_buffers[i],
+        &batch->report_buffer_sizes[i]);
+}
+
+oe_result_t oe_get_reports(
+    oe_enclave_t* enclave,
+    uint32_t flags,
+    const void* opt_params,
+    size_t opt_params_size,
+    size_t count,
+    size_t num_threads,
+    uint8_t** report_buffers,
+    size_t* report_buffer_sizes,
+    oe_result_t* results)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    get_reports_batch_t batch = {{0}};
+
+    if (!report_buffers || !report_buffer_sizes || !results ||
+        num_threads == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+#if defined(OE_USE_LIBSGX)
+    OE_CHECK(oe_initialize_quote_provider());
+#endif
+
+    batch.base.count = count;
+    batch.base.process = _get_batch_report;
+    batch.enclave = enclave;
+    batch.flags = flags;
+    batch.opt_params = opt_params;
+    batch.opt_params_size = opt_params_size;
+    batch.report_buffers = report_buffers;
+    batch.report_buffer_sizes = report_buffer_sizes;
+    batch.results = results;
+
+    OE_CHECK(_run_batch(&batch.base, num_threads));
+
+    // Return the result of the first report that failed.
+    for (size_t i = 0; i < count; i++)
+        OE_CHECK(results[i]);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_verify_reports()
+**
+**     Verify a batch of reports on several threads. Identical reports share
+**     the result of the first one. One remote report is verified before the
+**     other threads start, so that the PCK certificate chain and the
+**     revocation collateral that the batch's quotes usually share are fetched
+**     and cached once rather than by every thread.
+**
+**==============================================================================
+*/
+
+typedef struct _verify_reports_batch
+{
+    batch_t base;
+    oe_enclave_t* enclave;
+    const uint8_t* const* reports;
+    const size_t* report_sizes;
+    oe_result_t* results;
+    oe_report_t* parsed_reports;
+
+    /* Index of the first report identical to each report */
+    size_t* first;
+
+    /* Report verified before the threads start, or count if none */
+    size_t warm;
+} verify_reports_batch_t;
+
+static void _verify_batch_report(batch_t* base, size_t i)
+{
+    verify_reports_batch_t* batch = (verify_reports_batch_t*)base;
+
+    if (batch->first[i] != i || i == batch->warm)
+        return;
+
+    batch->results[i] = _verify_report(
+        batch->enclave,
+        batch->reports[i],
+        batch->report_sizes[i],
+        batch->parsed_reports ? &batch->parsed_reports[i] : NULL);
+}
+
+oe_result_t oe_verify_reports(
+    oe_enclave_t* enclave,
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    size_t num_threads,
+    oe_result_t* results,
+    oe_report_t* parsed_reports)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    verify_reports_batch_t batch = {{0}};
+
+    if (!reports || !report_sizes || !results || num_threads == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+#if defined(OE_USE_LIBSGX)
+    OE_CHECK(oe_initialize_quote_provider());
+#endif
+
+    if (!(batch.first = (size_t*)calloc(count ? count : 1, sizeof(size_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(
+        oe_find_duplicate_reports(
+            reports, report_sizes, count, batch.first));
+
+    batch.base.count = count;
+    batch.base.process = _verify_batch_report;
+    batch.enclave = enclave;
+    batch.reports = reports;
+    batch.report_sizes = report_sizes;
+    batch.results = results;
+    batch.parsed_reports = parsed_reports;
+    batch.warm = count;
+
+    /* Verify the first remote report alone to cache its collateral */
+    for (size_t i = 0; i < count; i++)
+    {
+        const oe_report_header_t* header =
+            (const oe_report_header_t*)reports[i];
+
+        if (reports[i] && report_sizes[i] >= sizeof(oe_report_header_t) &&
+            header->report_type == OE_REPORT_TYPE_SGX_REMOTE)
+        {
+            _verify_batch_report(&batch.base, i);
+            batch.warm = i;
+            break;
+        }
+    }
+
+    OE_CHECK(_run_batch(&batch.base, num_threads));
+
+    /* Local reports that found every TCS of the enclave in use are verified
+     * again on the calling thread, now that the other threads are done */
+    for (size_t i = 0; i < count; i++)
+    {
+        if (batch.first[i] == i && results[i] == OE_OUT_OF_THREADS)
+            _verify_batch_report(&batch.base, i);
+    }
+
+    /* Identical reports share the result of the first one */
+    result = OE_OK;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t j = batch.first[i];
+
+        if (j != i)
+        {
+            results[i] = results[j];
+
+            if (results[i] == OE_OK && parsed_reports)
+                results[i] = oe_parse_report(
+                    reports[i], report_sizes[i], &parsed_reports[i]);
+        }
+
+        if (results[i] != OE_OK)
+            result = OE_VERIFY_FAILED;
+    }
+
+done:
+    free(batch.first);
+    return result;
+}
@@ -281,6 +281,15 @@ done:
 #endif /* defined(_WIN32) */
 }
 
+/* If sigstruct doesn't have expected header, treat enclave as unsigned */
+static bool _is_signed(const oe_sgx_enclave_properties_t* properties)
+{
+    return memcmp(
+               ((sgx_sigstruct_t*)properties->sigstruct)->header,
+               SGX_SIGSTRUCT_HEADER,
+               sizeof(SGX_SIGSTRUCT_HEADER)) == 0;
+}
+
 static oe_result_t _get_sig_struct(
     const oe_sgx_enclave_properties_t* properties,
     const OE_SHA256* mrenclave,
@@ -290,11 +299,7 @@ static oe_result_t _get_sig_struct(
 
     memset(sigstruct, 0, sizeof(sgx_sigstruct_t));
 
-    /* If sigstruct doesn't have expected header, treat enclave as unsigned */
-    if (memcmp(
-            ((sgx_sigstruct_t*)properties->sigstruct)->header,
-            SGX_SIGSTRUCT_HEADER,
-            sizeof(SGX_SIGSTRUCT_HEADER)) != 0)
+    if (!_is_signed(properties))
     {
         /* Only debug-sign unsigned enclaves in debug mode, fail otherwise */
         if (!(properties->config.attributes & SGX_FLAGS_DEBUG))
@@ -534,17 +539,164 @@ done:
     return result;
 }
 
-oe_result_t oe_sgx_load_enclave_data(
+/* Add one page to a hardware enclave */
+static oe_result_t _add_hardware_page(
+    oe_sgx_load_context_t* context,
+    uint64_t addr,
+    uint64_t src,
+    uint64_t flags,
+    bool extend)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+#if defined(OE_USE_LIBSGX)
+
+    uint32_t protect =
+        _make_memory_protect_param(flags, false /*not simulate*/);
+    if (!extend)
+        protect |= ENCLAVE_PAGE_UNVALIDATED;
+
+    uint32_t enclave_error;
+    if (enclave_load_data(
+            (void*)addr,
+            OE_PAGE_SIZE,
+            (const void*)src,
+            protect,
+            &enclave_error) != OE_PAGE_SIZE)
+    {
+        OE_RAISE(OE_PLATFORM_ERROR);
+    }
+
+#elif defined(__linux__)
+
+    /* Ask the Linux SGX driver to add a page to the enclave */
+    if (sgx_ioctl_enclave_add_page(context->dev, addr, src, flags, extend) != 0)
+        OE_RAISE(OE_IOCTL_FAILED);
+
+#elif defined(_WIN32)
+
+    /* Ask the OS to add a page to the enclave */
+    SIZE_T num_bytes = 0;
+    DWORD enclave_error;
+
+    DWORD protect = _make_memory_protect_param(flags, false /*not simulate*/);
+    if (!extend)
+        protect |= PAGE_ENCLAVE_UNVALIDATED;
+
+    if (!LoadEnclaveData(
+            GetCurrentProcess(),
+            (LPVOID)addr,
+            (LPCVOID)src,
+            OE_PAGE_SIZE,
+            protect,
+            NULL,
+            0,
+            &num_bytes,
+            &enclave_error))
+    {
+        OE_RAISE(OE_PLATFORM_ERROR);
+    }
+
+#endif
+
+    result = OE_OK;
+
+done:
+
+    return result;
+}
+
+static bool _is_zero_page(const void* page)
+{
+    const uint64_t* p = (const uint64_t*)page;
+
+    for (size_t i = 0; i < OE_PAGE_SIZE / sizeof(uint64_t); i++)
+    {
+        if (p[i])
+            return false;
+    }
+
+    return true;
+}
+
+/* Add a run of pages to a simulated enclave with one copy and one change of
+ * page protection */
+static oe_result_t _add_simulated_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    bool repeat,
+    uint64_t flags)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const uint8_t* sim_start = (const uint8_t*)context->sim.addr;
+    const uint8_t* sim_end = sim_start + context->sim.size;
+    size_t size;
+
+    if (oe_safe_mul_sizet(npages, OE_PAGE_SIZE, &size) != OE_OK)
+        OE_RAISE(OE_INTEGER_OVERFLOW);
+
+    /* Verify that the pages are within enclave boundaries */
+    if ((const uint8_t*)addr < sim_start ||
+        (const uint8_t*)addr > sim_end ||
+        size > (size_t)(sim_end - (const uint8_t*)addr))
+    {
+        OE_RAISE(OE_FAILURE);
+    }
+
+    /* Copy page contents onto memory-mapped region. The region starts out
+     * zero-filled, so a repeated zero page (the heap) is left untouched. */
+    if (!repeat)
+    {
+        OE_CHECK(oe_memcpy_s((void*)addr, size, (const void*)src, size));
+    }
+    else if (!_is_zero_page((const void*)src))
+    {
+        for (size_t i = 0; i < npages; i++)
+        {
+            OE_CHECK(
+                oe_memcpy_s(
+                    (uint8_t*)addr + i * OE_PAGE_SIZE,
+                    OE_PAGE_SIZE,
+                    (const void*)src,
+                    OE_PAGE_SIZE));
+        }
+    }
+
+    /* Set page access permissions */
+    {
+        uint32_t prot = _make_memory_protect_param(flags, true /*simulate*/);
+
+#if defined(__linux__)
+        if (mprotect((void*)addr, size, prot) != 0)
+            OE_RAISE(OE_FAILURE);
+#elif defined(_WIN32)
+        DWORD old;
+        if (!VirtualProtect((LPVOID)addr, size, prot, &old))
+            OE_RAISE(OE_FAILURE);
+#endif
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+oe_result_t oe_sgx_load_enclave_pages(
     oe_sgx_load_context_t* context,
     uint64_t base,
     uint64_t addr,
     uint64_t src,
+    size_t npages,
+    bool repeat,
     uint64_t flags,
     bool extend)
 {
     oe_result_t result = OE_UNEXPECTED;
 
-    if (!context || !base || !addr || !src || !flags)
+    if (!context || !base || !addr || !src || !npages || !flags)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
@@ -554,10 +706,22 @@ oe_result_t oe_sgx_load_enclave_data(
     if (addr % OE_PAGE_SIZE)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Measure this operation */
-    OE_CHECK(
-        oe_sgx_measure_load_enclave_data(
-            &context->hash_context, base, addr, src, flags, extend));
+    /* Measure each page as its own EADD (and EEXTEND), unless the final
+     * measurement was found in the cache */
+    for (size_t i = 0; i < npages && !context->measurement.found; i++)
+    {
+        uint64_t page_addr = addr + i * OE_PAGE_SIZE;
+        uint64_t page_src = repeat ? src : src + i * OE_PAGE_SIZE;
+
+        OE_CHECK(
+            oe_sgx_measure_load_enclave_data(
+                &context->hash_context,
+                base,
+                page_addr,
+                page_src,
+                flags,
+                extend));
+    }
 
     if (context->type == OE_SGX_LOAD_TYPE_MEASURE)
     {
@@ -568,93 +732,107 @@ oe_result_t oe_sgx_load_enclave_data(
     else if (oe_sgx_is_simulation_load_context(context))
     {
         /* Simulate enclave add page */
-        /* Verify that page is within enclave boundaries */
-        if ((void*)addr < context->sim.addr ||
-            (uint8_t*)addr >
-                (uint8_t*)context->sim.addr + context->sim.size - OE_PAGE_SIZE)
-        {
-            OE_RAISE(OE_FAILURE);
-        }
-
-        /* Copy page contents onto memory-mapped region */
         OE_CHECK(
-            oe_memcpy_s(
-                (uint8_t*)addr, OE_PAGE_SIZE, (uint8_t*)src, OE_PAGE_SIZE));
-
-        /* Set page access permissions */
+            _add_simulated_pages(context, addr, src, npages, repeat, flags));
+    }
+    else
+    {
+        for (size_t i = 0; i < npages; i++)
         {
-            uint32_t prot =
-                _make_memory_protect_param(flags, true /*simulate*/);
+            uint64_t page_addr = addr + i * OE_PAGE_SIZE;
+            uint64_t page_src = repeat ? src : src + i * OE_PAGE_SIZE;
 
-#if defined(__linux__)
-            if (mprotect((void*)addr, OE_PAGE_SIZE, prot) != 0)
-                OE_RAISE(OE_FAILURE);
-#elif defined(_WIN32)
-            DWORD old;
-            if (!VirtualProtect((LPVOID)addr, OE_PAGE_SIZE, prot, &old))
-                OE_RAISE(OE_FAILURE);
-#endif
+            OE_CHECK(
+                _add_hardware_page(
+                    context, page_addr, page_src, flags, extend));
         }
     }
-    else
-    {
-#if defined(OE_USE_LIBSGX)
 
-        uint32_t protect =
-            _make_memory_protect_param(flags, false /*not simulate*/);
-        if (!extend)
-            protect |= ENCLAVE_PAGE_UNVALIDATED;
+    result = OE_OK;
 
-        uint32_t enclave_error;
-        if (enclave_load_data(
-                (void*)addr,
-                OE_PAGE_SIZE,
-                (const void*)src,
-                protect,
-                &enclave_error) != OE_PAGE_SIZE)
-        {
-            OE_RAISE(OE_PLATFORM_ERROR);
-        }
+done:
 
-#elif defined(__linux__)
+    return result;
+}
 
-        /* Ask the Linux SGX driver to add a page to the enclave */
-        if (sgx_ioctl_enclave_add_page(
-                context->dev, addr, src, flags, extend) != 0)
-            OE_RAISE(OE_IOCTL_FAILED);
+oe_result_t oe_sgx_load_enclave_data(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    uint64_t flags,
+    bool extend)
+{
+    return oe_sgx_load_enclave_pages(
+        context, base, addr, src, 1, false, flags, extend);
+}
 
-#elif defined(_WIN32)
+oe_result_t oe_sgx_lookup_measurement(
+    oe_sgx_load_context_t* context,
+    const oe_sgx_enclave_properties_t* properties,
+    uint64_t vaddr,
+    size_t num_heap_pages,
+    size_t num_stack_pages,
+    size_t num_tcs,
+    uint64_t entry)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_sgx_measurement_key_t* key;
+    oe_sha256_context_t prefix_context;
+    OE_SHA256 mrenclave;
 
-        /* Ask the OS to add a page to the enclave */
-        SIZE_T num_bytes = 0;
-        DWORD enclave_error;
+    if (!context || !properties)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-        DWORD protect =
-            _make_memory_protect_param(flags, false /*not simulate*/);
-        if (!extend)
-            protect |= PAGE_ENCLAVE_UNVALIDATED;
+    if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-        if (!LoadEnclaveData(
-                GetCurrentProcess(),
-                (LPVOID)addr,
-                (LPCVOID)src,
-                OE_PAGE_SIZE,
-                protect,
-                NULL,
-                0,
-                &num_bytes,
-                &enclave_error))
+    /* Only cache the measurements of enclaves created by this process */
+    if (context->type != OE_SGX_LOAD_TYPE_CREATE)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    key = &context->measurement.key;
+    memset(key, 0, sizeof(*key));
+
+    /* Hash the measurement so far without disturbing it */
+    OE_CHECK(oe_sha256_clone(&prefix_context, &context->hash_context));
+    OE_CHECK(oe_sha256_final(&prefix_context, &key->prefix));
+
+    key->vaddr = vaddr;
+    key->num_heap_pages = num_heap_pages;
+    key->num_stack_pages = num_stack_pages;
+    key->num_tcs = num_tcs;
+    key->entry = entry;
+    context->measurement.keyed = true;
+
+    if (oe_sgx_measure_cache_find(key, &mrenclave))
+    {
+        const sgx_sigstruct_t* sigstruct =
+            (const sgx_sigstruct_t*)properties->sigstruct;
+
+        /* A signed enclave only uses a measurement that matches its
+         * SIGSTRUCT; otherwise measure it again and replace the entry */
+        if (_is_signed(properties) &&
+            memcmp(
+                mrenclave.buf,
+                sigstruct->enclavehash,
+                sizeof(sigstruct->enclavehash)) != 0)
         {
-            OE_RAISE(OE_PLATFORM_ERROR);
+            oe_sgx_measure_cache_remove(key);
+        }
+        else
+        {
+            context->measurement.mrenclave = mrenclave;
+            context->measurement.found = true;
         }
-
-#endif
     }
 
     result = OE_OK;
 
 done:
-
     return result;
 }
 
@@ -675,9 +853,20 @@ oe_result_t oe_sgx_initialize_enclave(
     if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Measure this operation */
-    OE_CHECK(
-        oe_sgx_measure_initialize_enclave(&context->hash_context, mrenclave));
+    /* Measure this operation, or use the measurement found in the cache */
+    if (context->measurement.found)
+    {
+        *mrenclave = context->measurement.mrenclave;
+    }
+    else
+    {
+        OE_CHECK(
+            oe_sgx_measure_initialize_enclave(
+                &context->hash_context, mrenclave));
+
+        if (context->measurement.keyed)
+            oe_sgx_measure_cache_add(&context->measurement.key, mrenclave);
+    }
 
     /* EINIT has no further action in measurement/simulation mode */
     if (context->type == OE_SGX_LOAD_TYPE_CREATE &&
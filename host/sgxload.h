@@ -37,6 +37,36 @@ oe_result_t oe_sgx_load_enclave_data(
     uint64_t flags,
     bool extend);
 
+/* Add npages consecutive pages with the same flags. The pages are copied
+ * from src, or if repeat is true, each page is a copy of the page at src.
+ * The measurement is the same as adding the pages one at a time with
+ * oe_sgx_load_enclave_data(), but a simulated enclave does one copy and
+ * one protection change for the whole range. */
+oe_result_t oe_sgx_load_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    bool repeat,
+    uint64_t flags,
+    bool extend);
+
+/* Look up the measurement of the pages that follow the enclave image (heap,
+ * stacks and control pages) once the image pages are added. The arguments
+ * describe the layout of the remaining pages. If the measurement is cached,
+ * those pages are added without being measured and
+ * oe_sgx_initialize_enclave() reports the cached measurement; otherwise
+ * oe_sgx_initialize_enclave() caches the measurement it computes. */
+oe_result_t oe_sgx_lookup_measurement(
+    oe_sgx_load_context_t* context,
+    const oe_sgx_enclave_properties_t* properties,
+    uint64_t vaddr,
+    size_t num_heap_pages,
+    size_t num_stack_pages,
+    size_t num_tcs,
+    uint64_t entry);
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
@@ -6,6 +6,8 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/trace.h>
+#include <string.h>
+#include "hostthread.h"
 
 static void _measure_zeros(oe_sha256_context_t* context, size_t size)
 {
@@ -26,25 +28,49 @@ static void _measure_zeros(oe_sha256_context_t* context, size_t size)
     }
 }
 
-static void _measure_eextend(
-    oe_sha256_context_t* context,
-    uint64_t vaddr,
-    uint64_t flags,
-    const void* page)
-{
-    uint64_t pgoff = 0;
-    const uint64_t CHUNK_SIZE = 256;
+/*
+**==============================================================================
+**
+** Page measurement:
+**
+**     EADD and EEXTEND extend MRENCLAVE with 64-byte records: an 8-byte tag,
+**     the page offset, the SECINFO flags (EADD only) and zero padding. Each
+**     EEXTEND record is followed by the 256 bytes it covers. The records of
+**     a page are formatted in one buffer and hashed with a single update,
+**     rather than with many small updates for the tags, offsets and padding.
+**
+**==============================================================================
+*/
+
+#define MEASURE_RECORD_SIZE 64
+#define EEXTEND_CHUNK_SIZE 256
 
-    /* Write this page one chunk at a time */
-    for (pgoff = 0; pgoff < OE_PAGE_SIZE; pgoff += CHUNK_SIZE)
+typedef struct _page_measurement
+{
+    uint8_t eadd[MEASURE_RECORD_SIZE];
+    struct
     {
-        const uint64_t moffset = vaddr + pgoff;
+        uint8_t header[MEASURE_RECORD_SIZE];
+        uint8_t data[EEXTEND_CHUNK_SIZE];
+    } eextend[OE_PAGE_SIZE / EEXTEND_CHUNK_SIZE];
+} page_measurement_t;
 
-        oe_sha256_update(context, "EEXTEND", 8);
-        oe_sha256_update(context, &moffset, sizeof(moffset));
-        _measure_zeros(context, 48);
-        oe_sha256_update(context, (const uint8_t*)page + pgoff, CHUNK_SIZE);
-    }
+OE_STATIC_ASSERT(
+    sizeof(page_measurement_t) ==
+    MEASURE_RECORD_SIZE +
+        (OE_PAGE_SIZE / EEXTEND_CHUNK_SIZE) *
+            (MEASURE_RECORD_SIZE + EEXTEND_CHUNK_SIZE));
+
+static void _format_record(
+    uint8_t record[MEASURE_RECORD_SIZE],
+    const char tag[8],
+    uint64_t offset,
+    uint64_t flags)
+{
+    memset(record, 0, MEASURE_RECORD_SIZE);
+    memcpy(record, tag, 8);
+    memcpy(record + 8, &offset, sizeof(offset));
+    memcpy(record + 16, &flags, sizeof(flags));
 }
 
 oe_result_t oe_sgx_measure_create_enclave(
@@ -81,19 +107,34 @@ oe_result_t oe_sgx_measure_load_enclave_data(
 {
     oe_result_t result = OE_UNEXPECTED;
     uint64_t vaddr = addr - base;
+    page_measurement_t m;
+    size_t size;
 
     if (!context || !base || !addr || !src || !flags || addr < base)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Measure EADD */
-    oe_sha256_update(context, "EADD\0\0\0", 8);
-    oe_sha256_update(context, &vaddr, sizeof(vaddr));
-    oe_sha256_update(context, &flags, sizeof(flags));
-    _measure_zeros(context, 40);
+    _format_record(m.eadd, "EADD\0\0\0", vaddr, flags);
+    size = sizeof(m.eadd);
 
-    /* Measure EEXTEND if requested */
+    /* Measure EEXTEND if requested, one chunk at a time */
     if (extend)
-        _measure_eextend(context, vaddr, flags, (void*)src);
+    {
+        for (size_t i = 0; i < OE_COUNTOF(m.eextend); i++)
+        {
+            const uint64_t pgoff = i * EEXTEND_CHUNK_SIZE;
+
+            _format_record(m.eextend[i].header, "EEXTEND", vaddr + pgoff, 0);
+            memcpy(
+                m.eextend[i].data,
+                (const uint8_t*)src + pgoff,
+                EEXTEND_CHUNK_SIZE);
+        }
+
+        size = sizeof(m);
+    }
+
+    OE_CHECK(oe_sha256_update(context, &m, size));
 
     result = OE_OK;
 
@@ -118,3 +159,110 @@ oe_result_t oe_sgx_measure_initialize_enclave(
 done:
     return result;
 }
+
+/*
+**==============================================================================
+**
+** Measurement cache:
+**
+**     The measurement of the pages that follow the enclave image (heap,
+**     stacks and control pages) depends only on the measurement so far and
+**     on the layout of those pages, which the key captures. Creating the same
+**     enclave again finds its final measurement here, so the host no longer
+**     hashes its stacks and control pages. The cache lives in this process
+**     only and keeps the most recently added layouts.
+**
+**==============================================================================
+*/
+
+#define MEASUREMENT_CACHE_SIZE 16
+
+typedef struct _measurement_cache_entry
+{
+    bool used;
+    oe_sgx_measurement_key_t key;
+    OE_SHA256 mrenclave;
+} measurement_cache_entry_t;
+
+static measurement_cache_entry_t _measurement_cache[MEASUREMENT_CACHE_SIZE];
+static size_t _measurement_cache_next;
+static oe_mutex _measurement_cache_lock = OE_H_MUTEX_INITIALIZER;
+
+/* Called with the lock held */
+static measurement_cache_entry_t* _find_measurement(
+    const oe_sgx_measurement_key_t* key)
+{
+    for (size_t i = 0; i < MEASUREMENT_CACHE_SIZE; i++)
+    {
+        measurement_cache_entry_t* entry = &_measurement_cache[i];
+
+        if (entry->used && memcmp(&entry->key, key, sizeof(*key)) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+bool oe_sgx_measure_cache_find(
+    const oe_sgx_measurement_key_t* key,
+    OE_SHA256* mrenclave)
+{
+    bool found = false;
+    measurement_cache_entry_t* entry;
+
+    if (!key || !mrenclave)
+        return false;
+
+    oe_mutex_lock(&_measurement_cache_lock);
+
+    if ((entry = _find_measurement(key)))
+    {
+        *mrenclave = entry->mrenclave;
+        found = true;
+    }
+
+    oe_mutex_unlock(&_measurement_cache_lock);
+
+    return found;
+}
+
+void oe_sgx_measure_cache_add(
+    const oe_sgx_measurement_key_t* key,
+    const OE_SHA256* mrenclave)
+{
+    measurement_cache_entry_t* entry;
+
+    if (!key || !mrenclave)
+        return;
+
+    oe_mutex_lock(&_measurement_cache_lock);
+
+    /* Replace the oldest entry unless the key is already cached */
+    if (!(entry = _find_measurement(key)))
+    {
+        entry = &_measurement_cache[_measurement_cache_next];
+        _measurement_cache_next =
+            (_measurement_cache_next + 1) % MEASUREMENT_CACHE_SIZE;
+    }
+
+    entry->used = true;
+    entry->key = *key;
+    entry->mrenclave = *mrenclave;
+
+    oe_mutex_unlock(&_measurement_cache_lock);
+}
+
+void oe_sgx_measure_cache_remove(const oe_sgx_measurement_key_t* key)
+{
+    measurement_cache_entry_t* entry;
+
+    if (!key)
+        return;
+
+    oe_mutex_lock(&_measurement_cache_lock);
+
+    if ((entry = _find_measurement(key)))
+        memset(entry, 0, sizeof(*entry));
+
+    oe_mutex_unlock(&_measurement_cache_lock);
+}
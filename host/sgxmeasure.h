@@ -4,6 +4,7 @@
 #ifndef _OE_SGXMEASURE_H
 #define _OE_SGXMEASURE_H
 
+#include <openenclave/internal/sgxcreate.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/sha.h>
 
@@ -25,6 +26,19 @@ oe_result_t oe_sgx_measure_initialize_enclave(
     oe_sha256_context_t* context,
     OE_SHA256* mrenclave);
 
+/* Find the final measurement cached for the given key */
+bool oe_sgx_measure_cache_find(
+    const oe_sgx_measurement_key_t* key,
+    OE_SHA256* mrenclave);
+
+/* Cache the final measurement for the given key */
+void oe_sgx_measure_cache_add(
+    const oe_sgx_measurement_key_t* key,
+    const OE_SHA256* mrenclave);
+
+/* Drop the measurement cached for the given key */
+void oe_sgx_measure_cache_remove(const oe_sgx_measurement_key_t* key);
+
 OE_EXTERNC_END
 
 #endif /* _OE_SGXMEASURE_H */
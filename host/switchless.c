@@ -0,0 +1,543 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/bits/safemath.h>
+#include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include "hostthread.h"
+#include "memalign.h"
+#include "ocalls.h"
+
+/* Idle polls before a worker starts yielding the CPU */
+#define _IDLE_SPINS 1024
+
+/* Idle polls before a worker starts sleeping between polls */
+#define _IDLE_YIELDS (_IDLE_SPINS + 1024)
+
+/* Sleep interval of an idle worker in microseconds */
+#define _IDLE_SLEEP_USEC 50
+
+#if defined(__linux__)
+typedef pthread_t _worker_handle_t;
+#elif defined(_WIN32)
+typedef HANDLE _worker_handle_t;
+#endif
+
+/* Body of a worker thread; returns when the ring is stopped */
+typedef void (*_worker_routine_t)(
+    oe_enclave_t* enclave,
+    oe_switchless_ring_t* ring);
+
+struct _oe_switchless_workers
+{
+    oe_enclave_t* enclave;
+    oe_switchless_ring_t* ring;
+    _worker_routine_t routine;
+    size_t num_workers;
+#if defined(_WIN32)
+    /* Released once for each wake of a parked enclave worker */
+    HANDLE semaphore;
+#endif
+    OE_ZERO_SIZED_ARRAY _worker_handle_t handles[];
+};
+
+static void _idle(size_t* idle_count)
+{
+    size_t n = ++(*idle_count);
+
+    if (n < _IDLE_SPINS)
+    {
+#if defined(__linux__)
+        asm volatile("pause");
+#elif defined(_WIN32)
+        YieldProcessor();
+#endif
+    }
+    else if (n < _IDLE_YIELDS)
+    {
+#if defined(__linux__)
+        sched_yield();
+#elif defined(_WIN32)
+        SwitchToThread();
+#endif
+    }
+    else
+    {
+#if defined(__linux__)
+        struct timespec ts = {0, _IDLE_SLEEP_USEC * 1000};
+        nanosleep(&ts, NULL);
+#elif defined(_WIN32)
+        Sleep(0);
+#endif
+    }
+}
+
+/*
+**==============================================================================
+**
+** _ocall_worker()
+**
+**     Poll the OCALL request ring and run the posted OCALLs until asked to
+**     stop. A worker takes a request by moving its slot from POSTED to
+**     RUNNING, which races with the enclave withdrawing the same request.
+**
+**==============================================================================
+*/
+
+static void _ocall_worker(oe_enclave_t* enclave, oe_switchless_ring_t* ring)
+{
+    size_t idle_count = 0;
+
+    while (!ring->stop)
+    {
+        bool found = false;
+
+        for (uint64_t i = 0; i < ring->num_slots; i++)
+        {
+            oe_switchless_slot_t* slot = &ring->slots[i];
+
+            if (slot->state != OE_SWITCHLESS_SLOT_POSTED)
+                continue;
+
+            if (!oe_atomic_compare_and_swap(
+                    &slot->state,
+                    OE_SWITCHLESS_SLOT_POSTED,
+                    OE_SWITCHLESS_SLOT_RUNNING))
+                continue;
+
+            oe_handle_call_host_function((uint64_t)slot->args, enclave);
+
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            slot->state = OE_SWITCHLESS_SLOT_DONE;
+            found = true;
+        }
+
+        if (found)
+            idle_count = 0;
+        else
+            _idle(&idle_count);
+    }
+}
+
+/*
+**==============================================================================
+**
+** _ecall_worker()
+**
+**     Park this thread inside the enclave, where it polls the ECALL request
+**     ring until asked to stop. The worker occupies one TCS for its lifetime.
+**     If the ECALL fails (e.g. no TCS is free), requests posted to the ring
+**     are never taken and callers fall back to regular ECALLs.
+**
+**==============================================================================
+*/
+
+static void _ecall_worker(oe_enclave_t* enclave, oe_switchless_ring_t* ring)
+{
+    uint64_t arg_out = 0;
+
+    oe_ecall(enclave, OE_ECALL_SWITCHLESS_WORKER, (uint64_t)ring, &arg_out);
+}
+
+/* Wake up to count enclave workers parked in oe_handle_switchless_wait() */
+static void _wake_workers(
+    oe_switchless_ring_t* ring,
+    oe_switchless_workers_t* workers,
+    size_t count)
+{
+#if defined(__linux__)
+
+    OE_UNUSED(workers);
+    __sync_fetch_and_add(&ring->wake_seq, 1);
+    syscall(
+        __NR_futex,
+        &ring->wake_seq,
+        FUTEX_WAKE_PRIVATE,
+        count < INT_MAX ? (int)count : INT_MAX,
+        NULL,
+        NULL,
+        0);
+
+#elif defined(_WIN32)
+
+    OE_UNUSED(ring);
+    ReleaseSemaphore(workers->semaphore, (LONG)count, NULL);
+
+#endif
+}
+
+static bool _has_posted_requests(const oe_switchless_ring_t* ring)
+{
+    for (uint64_t i = 0; i < ring->num_slots; i++)
+    {
+        if (ring->slots[i].state == OE_SWITCHLESS_SLOT_POSTED)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_switchless_wait()
+**
+**     Park an idle enclave worker (OE_OCALL_SWITCHLESS_WAIT) until a request
+**     is posted or the ring is stopped. The worker is counted in num_parked
+**     before it checks the ring, and a caller posts before it reads
+**     num_parked, so either the worker sees the request or the caller sees
+**     the worker and wakes it.
+**
+**==============================================================================
+*/
+
+void oe_handle_switchless_wait(oe_enclave_t* enclave)
+{
+    oe_switchless_ring_t* ring = enclave->switchless_ecall_ring;
+    oe_switchless_workers_t* workers = enclave->switchless_ecall_workers;
+
+    if (!ring || !workers)
+        return;
+
+#if defined(__linux__)
+    const uint32_t seq = ring->wake_seq;
+#endif
+
+    oe_atomic_increment(&ring->num_parked);
+
+    if (!ring->stop && !_has_posted_requests(ring))
+    {
+#if defined(__linux__)
+        /* Returns at once if a caller bumped wake_seq since it was read */
+        syscall(
+            __NR_futex,
+            &ring->wake_seq,
+            FUTEX_WAIT_PRIVATE,
+            seq,
+            NULL,
+            NULL,
+            0);
+#elif defined(_WIN32)
+        WaitForSingleObject(workers->semaphore, INFINITE);
+#endif
+    }
+
+    oe_atomic_decrement(&ring->num_parked);
+}
+
+#if defined(__linux__)
+static void* _worker_thread(void* arg)
+{
+    oe_switchless_workers_t* workers = (oe_switchless_workers_t*)arg;
+    workers->routine(workers->enclave, workers->ring);
+    return NULL;
+}
+#elif defined(_WIN32)
+static DWORD WINAPI _worker_thread(LPVOID arg)
+{
+    oe_switchless_workers_t* workers = (oe_switchless_workers_t*)arg;
+    workers->routine(workers->enclave, workers->ring);
+    return 0;
+}
+#endif
+
+static void _join_workers(oe_switchless_workers_t* workers)
+{
+    for (size_t i = 0; i < workers->num_workers; i++)
+    {
+#if defined(__linux__)
+        pthread_join(workers->handles[i], NULL);
+#elif defined(_WIN32)
+        WaitForSingleObject(workers->handles[i], INFINITE);
+        CloseHandle(workers->handles[i]);
+#endif
+    }
+
+    workers->num_workers = 0;
+}
+
+/* Stop the workers, then release them and their ring */
+static void _stop_workers(
+    oe_switchless_ring_t* ring,
+    oe_switchless_workers_t* workers)
+{
+    /* Workers finish the request they are running before exiting. Requests
+     * that are posted but not taken are withdrawn by the caller. */
+    ring->stop = 1;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+
+    if (workers)
+    {
+        /* Release enclave workers parked on the ring */
+        _wake_workers(ring, workers, workers->num_workers);
+        _join_workers(workers);
+
+#if defined(_WIN32)
+        if (workers->semaphore)
+            CloseHandle(workers->semaphore);
+#endif
+
+        free(workers);
+    }
+
+    oe_memalign_free(ring);
+}
+
+static oe_result_t _start_workers(
+    oe_enclave_t* enclave,
+    size_t num_workers,
+    size_t slots_per_worker,
+    _worker_routine_t routine,
+    oe_switchless_ring_t** ring_out,
+    oe_switchless_workers_t** workers_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_ring_t* ring = NULL;
+    oe_switchless_workers_t* workers = NULL;
+    size_t num_slots;
+    size_t size;
+
+    /* Allocate the request ring, cache-line aligned */
+    {
+        OE_CHECK(oe_safe_mul_sizet(num_workers, slots_per_worker, &num_slots));
+        OE_CHECK(
+            oe_safe_mul_sizet(num_slots, sizeof(oe_switchless_slot_t), &size));
+        OE_CHECK(oe_safe_add_sizet(size, sizeof(oe_switchless_ring_t), &size));
+
+        if (!(ring = (oe_switchless_ring_t*)oe_memalign(64, size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        memset(ring, 0, size);
+        ring->num_slots = num_slots;
+    }
+
+    /* Allocate the worker handles */
+    {
+        OE_CHECK(
+            oe_safe_mul_sizet(num_workers, sizeof(_worker_handle_t), &size));
+        OE_CHECK(
+            oe_safe_add_sizet(size, sizeof(oe_switchless_workers_t), &size));
+
+        if (!(workers = (oe_switchless_workers_t*)calloc(1, size)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        workers->enclave = enclave;
+        workers->ring = ring;
+        workers->routine = routine;
+
+#if defined(_WIN32)
+        if (!(workers->semaphore =
+                  CreateSemaphore(NULL, 0, LONG_MAX, NULL)))
+            OE_RAISE(OE_FAILURE);
+#endif
+    }
+
+    /* Publish the ring first: a parking enclave worker looks it up */
+    *ring_out = ring;
+    *workers_out = workers;
+
+    /* Start the workers */
+    for (size_t i = 0; i < num_workers; i++)
+    {
+#if defined(__linux__)
+        if (pthread_create(
+                &workers->handles[i], NULL, _worker_thread, workers) != 0)
+            OE_RAISE(OE_FAILURE);
+#elif defined(_WIN32)
+        if (!(workers->handles[i] =
+                  CreateThread(NULL, 0, _worker_thread, workers, 0, NULL)))
+            OE_RAISE(OE_FAILURE);
+#endif
+        workers->num_workers++;
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (result != OE_OK && ring)
+    {
+        _stop_workers(ring, workers);
+        *ring_out = NULL;
+        *workers_out = NULL;
+    }
+
+    return result;
+}
+
+oe_result_t oe_start_switchless_ocall_workers(
+    oe_enclave_t* enclave,
+    size_t num_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!enclave || !num_workers || enclave->switchless_ring)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(
+        _start_workers(
+            enclave,
+            num_workers,
+            OE_SWITCHLESS_OCALL_SLOTS_PER_WORKER,
+            _ocall_worker,
+            &enclave->switchless_ring,
+            &enclave->switchless_workers));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_stop_switchless_ocall_workers(oe_enclave_t* enclave)
+{
+    if (!enclave || !enclave->switchless_ring)
+        return;
+
+    _stop_workers(enclave->switchless_ring, enclave->switchless_workers);
+    enclave->switchless_ring = NULL;
+    enclave->switchless_workers = NULL;
+}
+
+oe_result_t oe_start_switchless_ecall_workers(
+    oe_enclave_t* enclave,
+    size_t num_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!enclave || !num_workers || enclave->switchless_ecall_ring)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Leave at least one TCS for regular ECALLs */
+    if (num_workers >= enclave->num_bindings)
+        OE_RAISE(OE_OUT_OF_THREADS);
+
+    OE_CHECK(
+        _start_workers(
+            enclave,
+            num_workers,
+            OE_SWITCHLESS_ECALL_SLOTS_PER_WORKER,
+            _ecall_worker,
+            &enclave->switchless_ecall_ring,
+            &enclave->switchless_ecall_workers));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+void oe_stop_switchless_ecall_workers(oe_enclave_t* enclave)
+{
+    if (!enclave || !enclave->switchless_ecall_ring)
+        return;
+
+    /* The enclave workers observe the stop flag and return from their
+     * OE_ECALL_SWITCHLESS_WORKER calls, releasing their TCSs */
+    _stop_workers(
+        enclave->switchless_ecall_ring, enclave->switchless_ecall_workers);
+    enclave->switchless_ecall_ring = NULL;
+    enclave->switchless_ecall_workers = NULL;
+}
+
+/* Claim a free slot, starting at a per-thread offset to spread contention */
+static oe_switchless_slot_t* _claim_slot(oe_switchless_ring_t* ring)
+{
+    uint64_t start = ((uint64_t)oe_thread_self() >> 6) % ring->num_slots;
+
+    for (uint64_t i = 0; i < ring->num_slots; i++)
+    {
+        oe_switchless_slot_t* slot =
+            &ring->slots[(start + i) % ring->num_slots];
+
+        if (slot->state == OE_SWITCHLESS_SLOT_FREE &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_FREE,
+                OE_SWITCHLESS_SLOT_CLAIMED))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    oe_call_enclave_function_args_t* args)
+{
+    oe_switchless_ring_t* ring = enclave->switchless_ecall_ring;
+    oe_switchless_slot_t* slot;
+    uint64_t spins = 0;
+    size_t idle_count = 0;
+
+    if (!ring || ring->stop)
+        return OE_BUSY;
+
+    /* All slots busy: the workers are saturated */
+    if (!(slot = _claim_slot(ring)))
+        return OE_BUSY;
+
+    slot->args = args;
+
+    /* Post with a full barrier before reading num_parked, which pairs with
+     * the barrier in oe_handle_switchless_wait() */
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_CLAIMED, OE_SWITCHLESS_SLOT_POSTED);
+
+    if (ring->num_parked)
+        _wake_workers(ring, enclave->switchless_ecall_workers, 1);
+
+    /* Wait for a worker to take the request */
+    while (slot->state == OE_SWITCHLESS_SLOT_POSTED)
+    {
+        if (++spins < OE_SWITCHLESS_ECALL_SPIN_BUDGET)
+        {
+#if defined(__linux__)
+            asm volatile("pause");
+#elif defined(_WIN32)
+            YieldProcessor();
+#endif
+            continue;
+        }
+
+        /* No worker took the request in time. Withdraw it unless a worker
+         * takes it concurrently, in which case wait for that worker. */
+        if (oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_FREE))
+        {
+            return OE_BUSY;
+        }
+    }
+
+    /* Wait for the worker to finish. ECALLs may run for long, so back off
+     * the same way an idle host worker does. */
+    while (slot->state != OE_SWITCHLESS_SLOT_DONE)
+        _idle(&idle_count);
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+    slot->state = OE_SWITCHLESS_SLOT_FREE;
+
+    return OE_OK;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SWITCHLESS_H
+#define _OE_HOST_SWITCHLESS_H
+
+#include <openenclave/internal/switchless.h>
+#include "enclave.h"
+
+/* Allocate the switchless OCALL ring and start the host worker threads */
+oe_result_t oe_start_switchless_ocall_workers(
+    oe_enclave_t* enclave,
+    size_t num_workers);
+
+/* Stop the host worker threads and release the switchless OCALL ring */
+void oe_stop_switchless_ocall_workers(oe_enclave_t* enclave);
+
+/* Allocate the switchless ECALL ring and park the given number of host
+ * threads inside the enclave to service it */
+oe_result_t oe_start_switchless_ecall_workers(
+    oe_enclave_t* enclave,
+    size_t num_workers);
+
+/* Release the enclave worker threads and the switchless ECALL ring */
+void oe_stop_switchless_ecall_workers(oe_enclave_t* enclave);
+
+/* Block an idle enclave worker (OE_OCALL_SWITCHLESS_WAIT) until a request is
+ * posted to the switchless ECALL ring or the ring is stopped */
+void oe_handle_switchless_wait(oe_enclave_t* enclave);
+
+/* Post a call to an enclave worker thread without entering the enclave.
+ * Returns OE_BUSY if switchless ECALLs are off or no worker took the request,
+ * in which case the caller must perform a regular ECALL. */
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    oe_call_enclave_function_args_t* args);
+
+#endif /* _OE_HOST_SWITCHLESS_H */
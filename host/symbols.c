@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "symbols.h"
+#include <stdlib.h>
+#include <string.h>
+#include <openenclave/bits/safecrt.h>
+#include <openenclave/bits/safemath.h>
+#include <openenclave/internal/raise.h>
+
+/*
+**==============================================================================
+**
+** Symbol index:
+**
+**     The function symbols of .symtab sorted by start address, with a copy
+**     of .strtab holding their names. The index is built when the enclave
+**     is created and serves every OE_OCALL_BACKTRACE_SYMBOLS (backtraces and
+**     debug malloc leak reports) with a binary search instead of reloading
+**     the image and scanning the symbol table for each address.
+**
+**     Functions may overlap (aliases, zero-size or nested symbols), so each
+**     entry also records the largest end address of the entries sorted up
+**     to it. A lookup walks back from the nearest start address until no
+**     earlier entry can reach the address, and returns the containing
+**     function that comes first in .symtab, as elf64_get_function_name()
+**     does. A malformed symbol table is not an error: bad symbols are
+**     skipped, and a table that cannot be read yields an empty index.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_symbol
+{
+    uint64_t start;
+    uint64_t end; /* Inclusive, as in elf64_get_function_name() */
+    uint64_t reach; /* Largest end of this and all earlier entries */
+    uint32_t name;
+    uint32_t order; /* Position in .symtab, to pick among overlapping ones */
+} oe_symbol_t;
+
+struct _oe_symbol_index
+{
+    oe_symbol_t* symbols;
+    size_t num_symbols;
+    char* strtab;
+    size_t strtab_size;
+};
+
+static int _compare_symbols(const void* p1, const void* p2)
+{
+    const oe_symbol_t* s1 = (const oe_symbol_t*)p1;
+    const oe_symbol_t* s2 = (const oe_symbol_t*)p2;
+
+    if (s1->start != s2->start)
+        return s1->start < s2->start ? -1 : 1;
+
+    if (s1->order != s2->order)
+        return s1->order < s2->order ? -1 : 1;
+
+    return 0;
+}
+
+oe_result_t oe_load_symbol_index(oe_enclave_t* enclave, const elf64_t* elf)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_symbol_index_t* index = NULL;
+    elf64_shdr_t shdr;
+    uint8_t* symtab_data;
+    size_t symtab_size;
+    uint8_t* strtab_data;
+    size_t strtab_size;
+    const elf64_sym_t* symtab;
+    size_t n;
+
+    if (!enclave || !elf)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(index = (oe_symbol_index_t*)calloc(1, sizeof(oe_symbol_index_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Stripped images have no symbols to index */
+    if (elf64_find_section_header(elf, ".symtab", &shdr) != 0 ||
+        elf64_find_section(elf, ".symtab", &symtab_data, &symtab_size) != 0 ||
+        elf64_find_section(elf, ".strtab", &strtab_data, &strtab_size) != 0)
+    {
+        goto ready;
+    }
+
+    /* Leave the index empty if the symbol table cannot be read */
+    if (shdr.sh_type != SHT_SYMTAB || shdr.sh_entsize != sizeof(elf64_sym_t))
+        goto ready;
+
+    /* Every name must end inside the string table */
+    if (!symtab_data || !strtab_data || strtab_size == 0 ||
+        strtab_data[strtab_size - 1] != '\0' || strtab_size > OE_UINT32_MAX)
+    {
+        goto ready;
+    }
+
+    symtab = (const elf64_sym_t*)symtab_data;
+    n = symtab_size / sizeof(elf64_sym_t);
+
+    if (n > OE_UINT32_MAX)
+        goto ready;
+
+    if (n && !(index->symbols = (oe_symbol_t*)calloc(n, sizeof(oe_symbol_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Collect the function symbols (entry 0 is the null symbol) */
+    for (size_t i = 1; i < n; i++)
+    {
+        const elf64_sym_t* p = &symtab[i];
+        oe_symbol_t* sym = &index->symbols[index->num_symbols];
+
+        if ((p->st_info & 0x0F) != STT_FUNC || p->st_name >= strtab_size)
+            continue;
+
+        /* Skip functions whose end address overflows */
+        if (oe_safe_add_u64(p->st_value, p->st_size, &sym->end) != OE_OK)
+            continue;
+
+        sym->start = p->st_value;
+        sym->name = p->st_name;
+        sym->order = (uint32_t)i;
+        index->num_symbols++;
+    }
+
+    qsort(
+        index->symbols,
+        index->num_symbols,
+        sizeof(oe_symbol_t),
+        _compare_symbols);
+
+    for (size_t i = 0; i < index->num_symbols; i++)
+    {
+        oe_symbol_t* sym = &index->symbols[i];
+
+        sym->reach = sym->end;
+
+        if (i > 0 && index->symbols[i - 1].reach > sym->reach)
+            sym->reach = index->symbols[i - 1].reach;
+    }
+
+    if (!(index->strtab = (char*)malloc(strtab_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    OE_CHECK(
+        oe_memcpy_s(index->strtab, strtab_size, strtab_data, strtab_size));
+    index->strtab_size = strtab_size;
+
+ready:
+    enclave->symbols = index;
+    index = NULL;
+    result = OE_OK;
+
+done:
+
+    if (index)
+    {
+        free(index->symbols);
+        free(index->strtab);
+        free(index);
+    }
+
+    return result;
+}
+
+const char* oe_find_symbol_name(const oe_enclave_t* enclave, uint64_t vaddr)
+{
+    const oe_symbol_index_t* index;
+    const oe_symbol_t* found = NULL;
+    size_t lo = 0;
+    size_t hi;
+
+    if (!enclave || !(index = enclave->symbols))
+        return NULL;
+
+    /* Find the first symbol that starts after the address */
+    hi = index->num_symbols;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->symbols[mid].start <= vaddr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Of the symbols starting at or before the address, prefer the
+     * containing one that comes first in .symtab, like a linear scan would.
+     * Stop once no earlier symbol reaches the address. */
+    while (hi > 0 && index->symbols[hi - 1].reach >= vaddr)
+    {
+        const oe_symbol_t* sym = &index->symbols[--hi];
+
+        if (vaddr <= sym->end && (!found || sym->order < found->order))
+            found = sym;
+    }
+
+    return found ? index->strtab + found->name : NULL;
+}
+
+void oe_free_symbol_index(oe_enclave_t* enclave)
+{
+    if (!enclave || !enclave->symbols)
+        return;
+
+    free(enclave->symbols->symbols);
+    free(enclave->symbols->strtab);
+    free(enclave->symbols);
+    enclave->symbols = NULL;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SYMBOLS_H
+#define _OE_HOST_SYMBOLS_H
+
+#include <openenclave/internal/elf.h>
+#include "enclave.h"
+
+/* Index the function symbols of the enclave image for oe_find_symbol_name().
+ * Images without a readable symbol table get an empty index. */
+oe_result_t oe_load_symbol_index(oe_enclave_t* enclave, const elf64_t* elf);
+
+/* Return the name of the function containing the given offset from the
+ * enclave base address, or null if no function contains it */
+const char* oe_find_symbol_name(const oe_enclave_t* enclave, uint64_t vaddr);
+
+/* Release the symbol index */
+void oe_free_symbol_index(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SYMBOLS_H */
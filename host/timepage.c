@@ -0,0 +1,145 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "timepage.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <time.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/host.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include "memalign.h"
+#include "ocalls.h"
+
+struct _oe_time_updater
+{
+    oe_time_page_t* page;
+#if defined(__linux__)
+    pthread_t thread;
+#elif defined(_WIN32)
+    HANDLE thread;
+#endif
+};
+
+/* Publish new readings; readers retry while sequence is odd or changes */
+static void _update(oe_time_page_t* page)
+{
+    const uint64_t sequence = page->sequence;
+
+    page->sequence = sequence + 1;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+
+    page->realtime = oe_read_host_clock(OE_CLOCK_REALTIME);
+    page->monotonic = oe_read_host_clock(OE_CLOCK_MONOTONIC);
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    page->sequence = sequence + 2;
+}
+
+static void _run(oe_time_page_t* page)
+{
+    while (!page->stop)
+    {
+        _update(page);
+
+#if defined(__linux__)
+        struct timespec ts = {0, OE_TIME_PAGE_UPDATE_USEC * 1000};
+        nanosleep(&ts, NULL);
+#elif defined(_WIN32)
+        Sleep((OE_TIME_PAGE_UPDATE_USEC + 999) / 1000);
+#endif
+    }
+}
+
+#if defined(__linux__)
+static void* _thread(void* arg)
+{
+    _run((oe_time_page_t*)arg);
+    return NULL;
+}
+#elif defined(_WIN32)
+static DWORD WINAPI _thread(LPVOID arg)
+{
+    _run((oe_time_page_t*)arg);
+    return 0;
+}
+#endif
+
+oe_result_t oe_start_time_page(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_time_updater_t* updater = NULL;
+
+    if (!enclave || enclave->time_updater)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(updater = (oe_time_updater_t*)calloc(1, sizeof(*updater))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Keep the page on its own cache line */
+    if (!(updater->page =
+              (oe_time_page_t*)oe_memalign(64, sizeof(oe_time_page_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(updater->page, 0, sizeof(oe_time_page_t));
+
+    /* The page is valid before the enclave can read it */
+    _update(updater->page);
+
+#if defined(__linux__)
+    if (pthread_create(&updater->thread, NULL, _thread, updater->page) != 0)
+        OE_RAISE(OE_FAILURE);
+#elif defined(_WIN32)
+    if (!(updater->thread =
+              CreateThread(NULL, 0, _thread, updater->page, 0, NULL)))
+        OE_RAISE(OE_FAILURE);
+#endif
+
+    enclave->time_updater = updater;
+    updater = NULL;
+    result = OE_OK;
+
+done:
+
+    if (updater)
+    {
+        oe_memalign_free(updater->page);
+        free(updater);
+    }
+
+    return result;
+}
+
+oe_time_page_t* oe_get_time_page(oe_enclave_t* enclave)
+{
+    return enclave->time_updater ? enclave->time_updater->page : NULL;
+}
+
+void oe_stop_time_page(oe_enclave_t* enclave)
+{
+    oe_time_updater_t* updater;
+
+    if (!enclave || !(updater = enclave->time_updater))
+        return;
+
+    updater->page->stop = 1;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+
+#if defined(__linux__)
+    pthread_join(updater->thread, NULL);
+#elif defined(_WIN32)
+    WaitForSingleObject(updater->thread, INFINITE);
+    CloseHandle(updater->thread);
+#endif
+
+    oe_memalign_free(updater->page);
+    free(updater);
+    enclave->time_updater = NULL;
+}
@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_TIMEPAGE_H
+#define _OE_HOST_TIMEPAGE_H
+
+#include <openenclave/internal/time.h>
+#include "enclave.h"
+
+/* Allocate the time page of this enclave and start the host thread that
+ * keeps it up to date (see OE_ENCLAVE_FLAG_SHARED_TIME) */
+oe_result_t oe_start_time_page(oe_enclave_t* enclave);
+
+/* Return the time page of this enclave, or null if there is none */
+oe_time_page_t* oe_get_time_page(oe_enclave_t* enclave);
+
+/* Stop the update thread and release the time page */
+void oe_stop_time_page(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_TIMEPAGE_H */
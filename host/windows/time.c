@@ -4,6 +4,7 @@
 #include <openenclave/bits/types.h>
 #include <openenclave/internal/time.h>
 #include <windows.h>
+#include "../ocalls.h"
 
 /*
 **==============================================================================
@@ -45,6 +46,37 @@ static uint64_t _time()
     return (x.QuadPart / TICKS_PER_MILLISECOND);
 }
 
+uint64_t oe_read_host_clock(oe_clock_t clock)
+{
+    if (clock == OE_CLOCK_MONOTONIC)
+    {
+        LARGE_INTEGER count;
+        LARGE_INTEGER frequency;
+        const uint64_t NSEC_PER_SEC = 1000000000UL;
+
+        QueryPerformanceCounter(&count);
+        QueryPerformanceFrequency(&frequency);
+
+        /* Split the conversion to avoid overflowing 64 bits */
+        return ((uint64_t)count.QuadPart / frequency.QuadPart) * NSEC_PER_SEC +
+               ((uint64_t)count.QuadPart % frequency.QuadPart) * NSEC_PER_SEC /
+                   frequency.QuadPart;
+    }
+    else
+    {
+        FILETIME ft;
+        ULARGE_INTEGER x;
+        const uint64_t NSEC_PER_TICK = 100;
+
+        GetSystemTimeAsFileTime(&ft);
+        x.u.LowPart = ft.dwLowDateTime;
+        x.u.HighPart = ft.dwHighDateTime;
+        x.QuadPart -= POSIX_TO_WINDOWS_EPOCH_TICKS;
+
+        return x.QuadPart * NSEC_PER_TICK;
+    }
+}
+
 void oe_handle_sleep(uint64_t arg_in)
 {
     const uint64_t milliseconds = arg_in;
@@ -53,8 +85,19 @@ void oe_handle_sleep(uint64_t arg_in)
 
 void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out)
 {
-    OE_UNUSED(arg_in);
+    if (!arg_out)
+        return;
 
-    if (arg_out)
-        *arg_out = _time();
+    switch (arg_in)
+    {
+        case OE_GET_TIME_REALTIME_NSEC:
+            *arg_out = oe_read_host_clock(OE_CLOCK_REALTIME);
+            break;
+        case OE_GET_TIME_MONOTONIC_NSEC:
+            *arg_out = oe_read_host_clock(OE_CLOCK_MONOTONIC);
+            break;
+        default:
+            *arg_out = _time();
+            break;
+    }
 }
@@ -26,8 +26,9 @@ OE_EXTERNC_BEGIN
 /* Injected by OE_SET_ENCLAVE_SGX macro and by the signing tool (oesign) */
 #define OE_INFO_SECTION_NAME ".oeinfo"
 
-/* Max number of threads in an enclave supported */
-#define OE_SGX_MAX_TCS 32
+/* Max number of threads in an enclave supported. The host sizes its thread
+ * binding table from the num_tcs setting of each enclave. */
+#define OE_SGX_MAX_TCS 1024
 
 typedef struct _oe_enclave_size_settings
 {
@@ -253,6 +253,11 @@ typedef enum _oe_result {
      */
     OE_INVALID_UTC_DATE_TIME,
 
+    /**
+     * The operation did not complete before its deadline.
+     */
+    OE_TIMEOUT,
+
     __OE_RESULT_MAX = OE_ENUM_MAX,
 } oe_result_t;
 /**< typedef enum _oe_result oe_result_t*/
@@ -63,6 +63,30 @@ oe_result_t oe_call_host_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Allocate a buffer in host memory for marshaling the arguments of an OCALL.
+ *
+ * Buffers of up to about 4 KB are carved from a per-thread cache of host
+ * memory that is kept across ECALLs, so that the OCALL costs a single enclave
+ * exit instead of additional exits for oe_host_malloc() and oe_host_free().
+ * Larger buffers are allocated with oe_host_malloc().
+ *
+ * Buffers must be released with oe_free_ocall_buffer(), in reverse order of
+ * allocation, before the calling thread leaves the enclave.
+ *
+ * @param size The size of the buffer in bytes.
+ *
+ * @return The host buffer or NULL if the allocation failed.
+ */
+void* oe_allocate_ocall_buffer(size_t size);
+
+/**
+ * Release a buffer allocated by oe_allocate_ocall_buffer().
+ *
+ * @param buffer The buffer to release (may be NULL).
+ */
+void oe_free_ocall_buffer(void* buffer);
+
 /**
  * For hand-written enclaves, that use the older calling mechanism, define empty
  * ecall tables.
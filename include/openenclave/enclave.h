@@ -398,6 +398,35 @@ oe_result_t oe_verify_report(
     size_t report_size,
     oe_report_t* parsed_report);
 
+/**
+ * Verify the integrity of a batch of reports and their signatures.
+ *
+ * This function is equivalent to calling oe_verify_report() on each report,
+ * but verifies identical reports once. Remote reports of the batch share the
+ * cached certificate chain and revocation collateral of their platform, and
+ * local reports share the cached report key of their KEYID.
+ *
+ * @param reports Array of **count** buffers containing the reports to verify.
+ * @param report_sizes Array of **count** sizes of the **reports** buffers.
+ * @param count The number of reports.
+ * @param results Array of **count** results receiving the result of
+ * oe_verify_report() for each report.
+ * @param parsed_reports Optional array of **count** **oe_report_t** structures
+ * to populate with the properties of each verified report.
+ *
+ * @retval OE_OK All the reports were successfully verified.
+ * @retval OE_VERIFY_FAILED At least one report failed to verify. The
+ * **results** array holds the result of each report.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ *
+ */
+oe_result_t oe_verify_reports(
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    oe_result_t* results,
+    oe_report_t* parsed_reports);
+
 /**
  * This enumeration type defines the policy used to derive a seal key.
  */
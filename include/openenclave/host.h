@@ -44,15 +44,61 @@ OE_EXTERNC_BEGIN
  */
 #define OE_ENCLAVE_FLAG_SIMULATE 0x00000002
 
+/**
+ *  Flag passed into oe_create_enclave to enable switchless OCALLs. The host
+ *  starts a pool of worker threads that poll a request ring shared with the
+ *  enclave. Calls made through the oeedger8r-generated OCALL table are posted
+ *  to the ring instead of exiting the enclave, and fall back to a regular
+ *  OCALL when all workers are busy. Switchless OCALLs run on a host worker
+ *  thread rather than on the thread that made the ECALL.
+ */
+#define OE_ENCLAVE_FLAG_SWITCHLESS 0x00000004
+
+/**
+ *  Flag passed into oe_create_enclave to enable switchless ECALLs. One TCS
+ *  per worker is reserved for a thread that stays inside the enclave and
+ *  polls a request ring shared with the host. Calls made through the
+ *  oeedger8r-generated ECALL wrappers are posted to the ring instead of
+ *  entering the enclave, and fall back to a regular ECALL when the workers
+ *  are busy. Idle workers park on the host until a call is posted. There is
+ *  one worker unless oe_switchless_config_t says otherwise, and the enclave
+ *  must be configured with at least one more TCS than there are workers.
+ */
+#define OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS 0x00000008
+
+/**
+ *  Flag passed into oe_create_enclave to publish the time to the enclave in
+ *  shared host memory. A host thread refreshes the readings every few hundred
+ *  microseconds, and the enclave reads CLOCK_REALTIME and CLOCK_MONOTONIC
+ *  from them without an OCALL. The time is provided by the host and is no
+ *  more trustworthy than the time returned by an OCALL.
+ */
+#define OE_ENCLAVE_FLAG_SHARED_TIME 0x00000010
+
 /**
  * @cond DEV
  */
 #define OE_ENCLAVE_FLAG_RESERVED \
-    (~(OE_ENCLAVE_FLAG_DEBUG | OE_ENCLAVE_FLAG_SIMULATE))
+    (~(OE_ENCLAVE_FLAG_DEBUG | OE_ENCLAVE_FLAG_SIMULATE | \
+       OE_ENCLAVE_FLAG_SWITCHLESS | OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS | \
+       OE_ENCLAVE_FLAG_SHARED_TIME))
 /**
  * @endcond
  */
 
+/**
+ * Configuration that may be passed to oe_create_enclave() to size the
+ * switchless worker pools. A count of zero selects the default.
+ */
+typedef struct _oe_switchless_config
+{
+    /** Host worker threads for OE_ENCLAVE_FLAG_SWITCHLESS */
+    uint32_t num_host_workers;
+
+    /** Enclave worker threads (TCSs) for OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS */
+    uint32_t num_enclave_workers;
+} oe_switchless_config_t;
+
 /**
  * Type of each function in an ocall-table.
  */
@@ -76,9 +122,17 @@ typedef void (*oe_ocall_func_t)(void*);
  *     - OE_ENCLAVE_FLAG_SIMULATE - runs the enclave in simulation mode
  *     - OE_ENCLAVE_FLAG_DEBUG - runs the enclave in debug mode.
  *                               DO NOT SHIP CODE with this flag
+ *     - OE_ENCLAVE_FLAG_SWITCHLESS - services OCALLs on host worker threads
+ *                                    without exiting the enclave
+ *     - OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS - services ECALLs on enclave
+ *                                           worker threads without entering
+ *                                           the enclave
+ *     - OE_ENCLAVE_FLAG_SHARED_TIME - lets the enclave read the time from
+ *                                     host memory without an OCALL
  *
  * @param config Additional enclave creation configuration data for the specific
- * enclave type. This parameter is reserved and must be NULL.
+ * enclave type. This parameter is either NULL or points to an
+ * oe_switchless_config_t.
  *
  * @param config_size The size of the **config** data buffer in bytes.
  *
@@ -149,6 +203,55 @@ oe_result_t oe_call_enclave(
     const char* func,
     void* args);
 
+/**
+ * Handle of an enclave function, obtained with oe_get_enclave_function().
+ */
+typedef uint64_t oe_enclave_function_handle_t;
+
+/**
+ * Resolve the name of an enclave function to a handle.
+ *
+ * This function looks up the enclave function whose name is given by the
+ * **func** parameter, as oe_call_enclave() does, and returns a handle that
+ * can be passed to oe_call_enclave_by_handle() any number of times. The
+ * handle remains valid until the enclave is terminated.
+ *
+ * @param enclave The instance of the enclave that defines the function.
+ *
+ * @param func The name of the enclave function.
+ *
+ * @param handle The handle of the enclave function.
+ *
+ * @returns This function return **OE_OK** on success and **OE_NOT_FOUND** if
+ * the enclave does not define the function.
+ *
+ */
+oe_result_t oe_get_enclave_function(
+    oe_enclave_t* enclave,
+    const char* func,
+    oe_enclave_function_handle_t* handle);
+
+/**
+ * Perform a high-level enclave function call (ECALL) by handle.
+ *
+ * This function behaves as oe_call_enclave() but calls the function whose
+ * handle was obtained with oe_get_enclave_function(), skipping the name
+ * lookup.
+ *
+ * @param enclave The instance of the enclave to be called.
+ *
+ * @param handle The handle of the enclave function that will be called.
+ *
+ * @param args The arguments to be passed to the enclave function.
+ *
+ * @returns This function return **OE_OK** on success.
+ *
+ */
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    oe_enclave_function_handle_t handle,
+    void* args);
+
 /**
  * Get a report signed by the enclave platform for use in attestation.
  *
@@ -184,6 +287,47 @@ oe_result_t oe_get_report(
     uint8_t* report_buffer,
     size_t* report_buffer_size);
 
+/**
+ * Get a batch of reports signed by the enclave platform.
+ *
+ * This function is equivalent to calling oe_get_report() for each report
+ * buffer, but gets the reports concurrently on up to **num_threads** threads,
+ * including the calling thread. For remote attestation, the ECALL creating
+ * one report then overlaps the quote request of another. Each thread makes
+ * its own ECALLs, so the enclave should have at least **num_threads** thread
+ * control structures.
+ *
+ * @param enclave The instance of the enclave that will generate the reports.
+ * @param flags The flags passed to oe_get_report() for each report.
+ * @param opt_params The optional parameters passed to oe_get_report() for each
+ * report.
+ * @param opt_params_size The size of the **opt_params** buffer.
+ * @param count The number of reports.
+ * @param num_threads The maximum number of threads getting reports.
+ * @param report_buffers Array of **count** buffers to where the resulting
+ * reports will be copied.
+ * @param report_buffer_sizes Array of **count** sizes of the
+ * **report_buffers** buffers. Each size is set as by oe_get_report().
+ * @param results Array of **count** results receiving the result of
+ * oe_get_report() for each report.
+ *
+ * @retval OE_OK All the reports were successfully created.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval Otherwise the result of the first report that failed. The
+ * **results** array holds the result of each report.
+ *
+ */
+oe_result_t oe_get_reports(
+    oe_enclave_t* enclave,
+    uint32_t flags,
+    const void* opt_params,
+    size_t opt_params_size,
+    size_t count,
+    size_t num_threads,
+    uint8_t** report_buffers,
+    size_t* report_buffer_sizes,
+    oe_result_t* results);
+
 /**
  * Extracts additional platform specific data from the report and writes
  * it to *target_info_buffer*. After calling this function, the
@@ -257,6 +401,43 @@ oe_result_t oe_verify_report(
     size_t report_size,
     oe_report_t* parsed_report);
 
+/**
+ * Verify the integrity of a batch of reports and their signatures.
+ *
+ * This function is equivalent to calling oe_verify_report() on each report,
+ * but verifies identical reports once and verifies the others concurrently
+ * on up to **num_threads** threads, including the calling thread. Local
+ * reports are verified by ECALLs made from these threads. A local report that
+ * finds every thread control structure of the enclave in use is verified
+ * again on the calling thread after the other threads are done.
+ *
+ * @param enclave The instance of the enclave that will be used to
+ * verify the local reports. If all reports are remote, this parameter can be
+ * NULL.
+ * @param reports Array of **count** buffers containing the reports to verify.
+ * @param report_sizes Array of **count** sizes of the **reports** buffers.
+ * @param count The number of reports.
+ * @param num_threads The maximum number of threads verifying reports.
+ * @param results Array of **count** results receiving the result of
+ * oe_verify_report() for each report.
+ * @param parsed_reports Optional array of **count** **oe_report_t** structures
+ * to populate with the properties of each verified report.
+ *
+ * @retval OE_OK All the reports were successfully verified.
+ * @retval OE_VERIFY_FAILED At least one report failed to verify. The
+ * **results** array holds the result of each report.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ *
+ */
+oe_result_t oe_verify_reports(
+    oe_enclave_t* enclave,
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    size_t num_threads,
+    oe_result_t* results,
+    oe_report_t* parsed_reports);
+
 OE_EXTERNC_END
 
 #endif /* _OE_HOST_H */
@@ -35,4 +35,22 @@ OE_INLINE uint64_t oe_atomic_decrement(volatile uint64_t* x)
 #endif
 }
 
+/* Atomically set **x** to **desired** if it equals **expected**. Return true
+ * if the exchange took place */
+OE_INLINE bool oe_atomic_compare_and_swap(
+    volatile uint64_t* x,
+    uint64_t expected,
+    uint64_t desired)
+{
+#if defined(__GNUC__)
+    return __sync_bool_compare_and_swap(x, expected, desired);
+#elif defined(_MSC_VER)
+    return InterlockedCompareExchange64(
+               (volatile LONG64*)x, (LONG64)desired, (LONG64)expected) ==
+           (LONG64)expected;
+#else
+#error "unsupported"
+#endif
+}
+
 #endif /* _OE_ATOMIC_H */
@@ -76,6 +76,7 @@ typedef enum _oe_func {
     OE_ECALL_VERIFY_REPORT,
     OE_ECALL_GET_SGX_REPORT,
     OE_ECALL_VIRTUAL_EXCEPTION_HANDLER,
+    OE_ECALL_SWITCHLESS_WORKER,
     /* Caution: always add new ECALL function numbers here */
 
     OE_OCALL_CALL_HOST = OE_OCALL_BASE,
@@ -94,6 +95,10 @@ typedef enum _oe_func {
     OE_OCALL_SLEEP,
     OE_OCALL_GET_TIME,
     OE_OCALL_BACKTRACE_SYMBOLS,
+    OE_OCALL_THREAD_WAKE_MULTIPLE,
+    OE_OCALL_THREAD_TIMED_WAIT,
+    OE_OCALL_WRITEV,
+    OE_OCALL_SWITCHLESS_WAIT,
     /* Caution: always add new OCALL function numbers here */
 
     __OE_FUNC_MAX = OE_ENUM_MAX,
@@ -285,10 +290,23 @@ typedef void (*oe_host_func_t)(void* args, oe_enclave_t* enclave);
 **==============================================================================
 */
 
+/* Maximum number of host functions interned per enclave for oe_call_host() */
+#define OE_CALL_HOST_MAX_FUNCS 256
+
+/* Value of oe_call_host_args_t.func_id for a function not yet interned */
+#define OE_CALL_HOST_FUNC_ID_NONE OE_UINT64_MAX
+
 typedef struct _oe_call_host_args
 {
     void* args;
     oe_result_t result;
+
+    /* In: the ID the host assigned to the function by an earlier call, in
+     * which case func may be empty, or OE_CALL_HOST_FUNC_ID_NONE.
+     * Out: the ID of the function named by func, or OE_CALL_HOST_FUNC_ID_NONE
+     * if the host could not intern it. */
+    uint64_t func_id;
+
     OE_ZERO_SIZED_ARRAY char func[];
 } oe_call_host_args_t;
 
@@ -323,6 +341,33 @@ typedef struct _oe_print_args
     char* str;
 } oe_print_args_t;
 
+/*
+**==============================================================================
+**
+** oe_writev_args_t
+**
+**     Write the 'iovcnt' buffers in 'iov' to stdout (device == 0) or stderr
+**     (device == 1) with a single host write. The buffers follow the
+**     arguments in host memory.
+**
+**==============================================================================
+*/
+
+#define OE_WRITEV_MAX_IOV 16
+
+typedef struct _oe_writev_iov
+{
+    const void* base;
+    uint64_t len;
+} oe_writev_iov_t;
+
+typedef struct _oe_writev_args
+{
+    int device;
+    uint64_t iovcnt;
+    OE_ZERO_SIZED_ARRAY oe_writev_iov_t iov[];
+} oe_writev_args_t;
+
 /*
 **==============================================================================
 **
@@ -347,14 +392,20 @@ typedef struct _oe_realloc_args
 **     Runtime state to initialize enclave state with, includes
 **     - First 8 leaves of CPUID for enclave emulation
 **     - Enclave handle obtained by oe_create_enclave()
+**     - Switchless OCALL request ring (null if switchless mode is off)
+**     - Host time page (null unless OE_ENCLAVE_FLAG_SHARED_TIME is set)
 **
 **==============================================================================
 */
 
+typedef struct _oe_switchless_ring oe_switchless_ring_t;
+
 typedef struct _oe_init_enclave_args
 {
     uint32_t cpuid_table[OE_CPUID_LEAF_COUNT][OE_CPUID_REG_COUNT];
     oe_enclave_t* enclave;
+    oe_switchless_ring_t* switchless_ring;
+    struct _oe_time_page* time_page; /* See time.h */
 } oe_init_enclave_args_t;
 
 /*
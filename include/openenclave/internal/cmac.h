@@ -46,6 +46,49 @@ oe_result_t oe_aes_cmac_sign(
     size_t message_length,
     oe_aes_cmac_t* aes_cmac);
 
+/* Opaque representation of an AES-CMAC key and its key schedule */
+typedef struct _oe_aes_cmac_context
+{
+    /* Internal implementation */
+    uint64_t impl[16];
+} oe_aes_cmac_context_t;
+
+/**
+ * oe_aes_cmac_init sets up the key schedule of an AES-CMAC key, so that
+ * oe_aes_cmac_compute can compute the AES-CMAC of several messages with it.
+ *
+ * @param context The context to initialize. Release it with oe_aes_cmac_free.
+ * @param key The key used to compute the AES-CMACs.
+ * @param key_size The size of the key in bytes.
+ */
+oe_result_t oe_aes_cmac_init(
+    oe_aes_cmac_context_t* context,
+    const uint8_t* key,
+    size_t key_size);
+
+/**
+ * oe_aes_cmac_compute computes the AES-CMAC for the given message using the
+ * key of the context. The context is not thread safe.
+ *
+ * @param context The context initialized by oe_aes_cmac_init.
+ * @param message Pointer to start of the message.
+ * @param message_length Length of the message in bytes.
+ *
+ * @param cmac Output parameter where the computed AES-CMAC will be written to.
+ */
+oe_result_t oe_aes_cmac_compute(
+    oe_aes_cmac_context_t* context,
+    const uint8_t* message,
+    size_t message_length,
+    oe_aes_cmac_t* aes_cmac);
+
+/**
+ * oe_aes_cmac_free zeroes the key schedule and releases the context.
+ *
+ * @param context The context initialized by oe_aes_cmac_init.
+ */
+void oe_aes_cmac_free(oe_aes_cmac_context_t* context);
+
 OE_EXTERNC_END
 
 #endif /* _OE_CMAC_H */
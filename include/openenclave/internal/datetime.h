@@ -52,6 +52,12 @@ int32_t oe_datetime_compare(
     const oe_datetime_t* date1,
     const oe_datetime_t* date2);
 
+/**
+ * Get the current UTC date and time. Inside an enclave, the time is provided
+ * by the host (see oe_get_time()).
+ */
+oe_result_t oe_datetime_now(oe_datetime_t* value);
+
 OE_EXTERNC_END
 
 #endif /* _OE_INTERNAL_DATETIME_H */
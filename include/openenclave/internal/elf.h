@@ -224,7 +224,7 @@ typedef struct
         ELF_MAGIC, NULL, 0 \
     }
 
-typedef struct
+typedef struct _elf64
 {
     /* Magic number (ELF_MAGIC) */
     unsigned int magic;
@@ -234,12 +234,20 @@ typedef struct
 
     /* File image size */
     size_t size;
+
+    /* Non-zero if data is a read-only mapping of the file (see elf64_map) */
+    int mapped;
 } elf64_t;
 
 int elf64_test_header(const elf64_ehdr_t* header);
 
 int elf64_load(const char* path, elf64_t* elf);
 
+/* Like elf64_load() but map the file read-only instead of reading it into
+ * memory. The image cannot be modified (elf64_add_section() and
+ * elf64_remove_section() fail). Release it with elf64_unload(). */
+int elf64_map(const char* path, elf64_t* elf);
+
 int elf64_unload(elf64_t* elf);
 
 const void* elf64_get_symbol_table_section(const elf64_t* elf);
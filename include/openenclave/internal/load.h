@@ -19,8 +19,8 @@ OE_EXTERNC_BEGIN
 
 typedef struct _oe_segment
 {
-    /* Pointer to segment from ELF file */
-    void* filedata;
+    /* Pointer to segment within the ELF image (not owned, read-only) */
+    const void* filedata;
 
     /* Size of this segment in the ELF file */
     size_t filesz;
@@ -49,8 +49,12 @@ OE_INLINE uint64_t __oe_round_down_to_page_size(uint64_t x)
     return x & ~(OE_PAGE_SIZE - 1);
 }
 
+struct _elf64; /* See elf.h */
+
+/* Describe the loadable segments of the given ELF image. The segments point
+ * into the image, which must stay loaded while they are in use. */
 oe_result_t __oe_load_segments(
-    const char* path,
+    const struct _elf64* elf,
     oe_segment_t segments[OE_MAX_SEGMENTS],
     size_t* nsegments,
     uint64_t* entryaddr, /* virtual address of entry point */
@@ -61,12 +65,6 @@ oe_result_t __oe_calculate_segments_size(
     size_t nsegments,
     size_t* size);
 
-oe_result_t __oe_combine_segments(
-    const oe_segment_t* segments,
-    size_t nsegments,
-    oe_page_t** pages,
-    size_t* npages);
-
 OE_EXTERNC_END
 
 #endif /* _OE_LOAD_H */
@@ -9,8 +9,19 @@
 
 OE_EXTERNC_BEGIN
 
+/* Write to the host's stdout (device 0) or stderr (device 1). Output is
+ * collected in a per-thread line buffer and written to the host when it
+ * contains a newline, when it fills up or when oe_host_flush() is called. */
 int oe_host_write(int device, const char* str, size_t size);
 
+/* Write the calling thread's buffered output to the host */
+int oe_host_flush(void);
+
+/* Enable or disable output buffering for all threads (enabled by default).
+ * Disabling it writes each call through immediately, which keeps crash
+ * diagnostics from being lost in a buffer. */
+void oe_host_set_output_buffering(bool enabled);
+
 int oe_host_vfprintf(int device, const char* fmt, oe_va_list ap_);
 
 /**
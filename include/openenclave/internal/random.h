@@ -21,6 +21,26 @@ OE_EXTERNC_BEGIN
  */
 oe_result_t oe_random_internal(void* data, size_t size);
 
+#ifdef _OE_ENCLAVE_H
+
+/**
+ * Set how often the enclave's random generators reseed.
+ *
+ * Each enclave thread has its own generator, which draws fresh entropy from
+ * the CPU after every **interval** requests. A smaller interval reseeds
+ * more often at the cost of throughput. The change applies to every thread
+ * on its next request.
+ *
+ * @param interval the number of requests between reseeds, from 1 up to the
+ *        default of MBEDTLS_CTR_DRBG_RESEED_INTERVAL (10000)
+ *
+ * @return OE_OK on success
+ * @return OE_INVALID_PARAMETER if **interval** is out of range
+ */
+oe_result_t oe_random_set_reseed_interval(uint32_t interval);
+
+#endif /* _OE_ENCLAVE_H */
+
 OE_EXTERNC_END
 
 #endif /* _OE_RANDOM_H */
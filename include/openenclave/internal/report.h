@@ -142,4 +142,21 @@ OE_STATIC_ASSERT(
 
 #define OE_REPORT_HEADER_VERSION (1)
 
+/*
+**==============================================================================
+**
+** oe_find_duplicate_reports()
+**
+**     Set first[i] to the index of the first report of the batch that is
+**     identical to report i, or to i if no earlier report is identical.
+**     Used by oe_verify_reports() to verify each distinct report once.
+**
+**==============================================================================
+*/
+oe_result_t oe_find_duplicate_reports(
+    const uint8_t* const* reports,
+    const size_t* report_sizes,
+    size_t count,
+    size_t* first);
+
 #endif //_OE_INCLUDE_REPORT_H_
@@ -32,6 +32,21 @@ typedef enum _oe_sgx_load_state {
 
 OE_STATIC_ASSERT(sizeof(oe_sgx_load_state_t) == sizeof(unsigned int));
 
+/* Identifies the measurement of the pages that follow the enclave image: the
+ * heap, the stacks and the control pages (see oe_sgx_lookup_measurement) */
+typedef struct _oe_sgx_measurement_key
+{
+    /* Hash of the measurement up to the end of the image pages */
+    OE_SHA256 prefix;
+
+    /* Layout of the remaining pages */
+    uint64_t vaddr;
+    uint64_t num_heap_pages;
+    uint64_t num_stack_pages;
+    uint64_t num_tcs;
+    uint64_t entry;
+} oe_sgx_measurement_key_t;
+
 typedef struct _oe_sgx_load_context
 {
     oe_sgx_load_type_t type;
@@ -55,6 +70,21 @@ typedef struct _oe_sgx_load_context
 
     /* Hash context used to measure enclave as it is loaded */
     oe_sha256_context_t hash_context;
+
+    /* State of the measurement cache lookup, OE_SGX_LOAD_TYPE_CREATE only */
+    struct
+    {
+        /* The key was computed and the measurement may be cached */
+        bool keyed;
+
+        /* The measurement was found: hash_context is no longer extended */
+        bool found;
+
+        oe_sgx_measurement_key_t key;
+
+        /* The cached final measurement, valid if found is set */
+        OE_SHA256 mrenclave;
+    } measurement;
 } oe_sgx_load_context_t;
 
 oe_result_t oe_sgx_initialize_load_context(
@@ -589,8 +589,34 @@ typedef struct _td
     // for details).
     uint64_t pthread[64];
 
+    /* Per-thread cache of small heap chunks (see enclave/core/malloc.c) */
+    void* malloc_cache;
+
+    /* Wait/wake handshake state of this thread (see enclave/core/thread.c) */
+    volatile uint64_t wait_state;
+
+    /* Line buffer for host console output (see enclave/core/hostcalls.c).
+     * It lives here rather than on the heap so that printing never needs to
+     * allocate (oe_assert() may print while the heap lock is held). */
+    uint32_t host_output_device;
+    uint32_t host_output_size;
+    char host_output[1024];
+
+    /* Random generator state of this thread (see enclave/random.c) */
+    uint64_t drbg_seeded;
+    uint64_t drbg[64];
+
+    /* Host stack buckets of this thread (see enclave/core/hoststack.c) */
+    void* host_stack;
+
+    /* Thread wait counters of this thread, and the link to the next thread
+     * that has counted any (see enclave/core/thread.c) */
+    uint64_t wait_stats[5];
+    uint64_t wait_stats_listed;
+    void* wait_stats_next;
+
     /* Reserved */
-    uint8_t reserved[3324];
+    uint8_t reserved[1692];
 } td_t;
 OE_PACK_END
 
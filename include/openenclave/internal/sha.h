@@ -52,6 +52,21 @@ oe_result_t oe_sha256_update(
     const void* data,
     size_t size);
 
+/**
+ * Copies the state of a SHA-256 context
+ *
+ * This function initializes **dest** with the state of **src**, so that the
+ * two contexts can be extended and finalized independently.
+ *
+ * @param dest handle of context to be initialized
+ * @param src handle of context to be copied
+ *
+ * @return OE_OK upon success
+ */
+oe_result_t oe_sha256_clone(
+    oe_sha256_context_t* dest,
+    const oe_sha256_context_t* src);
+
 /**
  * Computes the final SHA-256 hash
  *
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SWITCHLESS_H
+#define _OE_SWITCHLESS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include "calls.h"
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** Switchless calls:
+**
+**     A request ring is a set of slots in untrusted memory, each holding a
+**     pointer to the argument block of one call. The caller claims a free
+**     slot, posts the pointer and spins until a worker marks the slot as
+**     done. If no slot is free, or no worker picks up the request within the
+**     spin budget, the caller withdraws it and falls back to a regular
+**     transition.
+**
+**     Switchless OCALLs: the enclave posts oe_call_host_function_args_t
+**     requests that are run by a pool of host worker threads, instead of
+**     exiting the enclave.
+**
+**     Switchless ECALLs: the host posts oe_call_enclave_function_args_t
+**     requests that are run by enclave worker threads, each of which is a
+**     host thread parked inside an OE_ECALL_SWITCHLESS_WORKER call on its own
+**     TCS, instead of entering the enclave.
+**
+**     Slot state transitions:
+**
+**         FREE -> CLAIMED -> POSTED -> RUNNING -> DONE -> FREE
+**                              |
+**                              +-> FREE (request withdrawn by the caller)
+**
+**     Only the caller moves a slot out of FREE, POSTED (withdraw) and DONE.
+**     Only a worker moves a slot out of POSTED (take) and RUNNING.
+**
+**     An enclave worker that stays idle past its spin budget parks on the
+**     host through OE_OCALL_SWITCHLESS_WAIT. The host counts the parked
+**     workers in the ring, and a caller that posts a request while one is
+**     parked bumps wake_seq and wakes it.
+**
+**==============================================================================
+*/
+
+#define OE_SWITCHLESS_SLOT_FREE 0
+#define OE_SWITCHLESS_SLOT_CLAIMED 1
+#define OE_SWITCHLESS_SLOT_POSTED 2
+#define OE_SWITCHLESS_SLOT_RUNNING 3
+#define OE_SWITCHLESS_SLOT_DONE 4
+
+/* Number of host worker threads started for OE_ENCLAVE_FLAG_SWITCHLESS */
+#define OE_SWITCHLESS_OCALL_HOST_WORKERS 2
+
+/* Number of request slots per host worker thread */
+#define OE_SWITCHLESS_OCALL_SLOTS_PER_WORKER 2
+
+/* Number of pause iterations the enclave waits for a worker to take a posted
+ * request before withdrawing it and falling back to a regular OCALL */
+#define OE_SWITCHLESS_OCALL_SPIN_BUDGET (1 << 14)
+
+/* Default number of TCSs parked in the enclave for
+ * OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS. At least one TCS is always left for
+ * regular ECALLs. */
+#define OE_SWITCHLESS_ECALL_ENCLAVE_WORKERS 1
+
+/* Number of request slots per enclave worker thread */
+#define OE_SWITCHLESS_ECALL_SLOTS_PER_WORKER 2
+
+/* Number of pause iterations the host waits for a worker to take a posted
+ * request before withdrawing it and falling back to a regular ECALL */
+#define OE_SWITCHLESS_ECALL_SPIN_BUDGET (1 << 14)
+
+/* Idle polls after which an enclave worker parks on the host until a request
+ * is posted */
+#define OE_SWITCHLESS_ECALL_IDLE_SPINS (1 << 16)
+
+/* Each slot occupies its own cache line to avoid false sharing */
+typedef struct _oe_switchless_slot
+{
+    volatile uint64_t state;
+
+    /* oe_call_host_function_args_t* for OCALL rings or
+     * oe_call_enclave_function_args_t* for ECALL rings */
+    void* args;
+    uint8_t padding[48];
+} oe_switchless_slot_t;
+
+OE_STATIC_ASSERT(sizeof(oe_switchless_slot_t) == 64);
+
+/* oe_switchless_ring_t is declared in calls.h */
+struct _oe_switchless_ring
+{
+    /* Number of entries in the slots array */
+    uint64_t num_slots;
+
+    /* Set by the host to ask the workers to exit */
+    volatile uint64_t stop;
+
+    /* Number of workers parked on the host, maintained by the host */
+    volatile uint64_t num_parked;
+
+    /* Bumped by a caller that wakes a parked worker (a futex word on Linux) */
+    volatile uint32_t wake_seq;
+
+    uint8_t padding[36];
+
+    OE_ZERO_SIZED_ARRAY oe_switchless_slot_t slots[];
+};
+
+OE_STATIC_ASSERT(sizeof(oe_switchless_ring_t) == 64);
+
+OE_EXTERNC_END
+
+#endif /* _OE_SWITCHLESS_H */
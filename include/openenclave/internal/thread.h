@@ -7,6 +7,7 @@
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/result.h>
 #include <openenclave/bits/types.h>
+#include <openenclave/internal/defs.h>
 
 /*
 **==============================================================================
@@ -22,6 +23,40 @@ typedef struct _oe_thread_wake_wait_args
     const void* self_tcs;
 } oe_thread_wake_wait_args_t;
 
+/*
+**==============================================================================
+**
+** oe_thread_timed_wait_args_t
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_timed_wait_args
+{
+    const void* tcs;
+
+    /* Absolute deadline in milliseconds since the Epoch */
+    uint64_t deadline;
+} oe_thread_timed_wait_args_t;
+
+/*
+**==============================================================================
+**
+** oe_thread_wake_multiple_args_t
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_wake_multiple_args
+{
+    uint64_t num_tcs;
+    OE_ZERO_SIZED_ARRAY const void* tcs[];
+} oe_thread_wake_multiple_args_t;
+
+/* Default number of polling iterations before an enclave thread blocks in the
+ * host (see oe_thread_set_spin_count()) */
+#define OE_THREAD_DEFAULT_SPIN_COUNT 1000
+
 #ifdef _OE_ENCLAVE_H
 OE_EXTERNC_BEGIN
 
@@ -252,6 +287,23 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex);
  */
 oe_result_t oe_mutex_trylock(oe_mutex_t* mutex);
 
+/**
+ * Acquire a lock on a mutex, waiting no longer than a deadline.
+ *
+ * This function behaves like oe_mutex_lock(), except that it gives up once
+ * the given deadline has passed.
+ *
+ * @param mutex Acquire a lock on this mutex.
+ * @param deadline The absolute deadline in milliseconds since the Epoch
+ *        (see oe_get_time()).
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_TIMEOUT the deadline passed before the mutex was acquired
+ *
+ */
+oe_result_t oe_mutex_timedlock(oe_mutex_t* mutex, uint64_t deadline);
+
 /**
  * Release a mutex.
  *
@@ -336,6 +388,29 @@ oe_result_t oe_cond_init(oe_cond_t* cond);
  */
 oe_result_t oe_cond_wait(oe_cond_t* cond, oe_mutex_t* mutex);
 
+/**
+ * Wait on a condition variable until a deadline.
+ *
+ * This function behaves like oe_cond_wait(), except that it stops waiting
+ * once the given deadline has passed. In either case, the mutex is locked
+ * again before this function returns.
+ *
+ * @param cond Wait on this condition variable.
+ * @param mutex This mutex must be locked by the caller.
+ * @param deadline The absolute deadline in milliseconds since the Epoch
+ *        (see oe_get_time()).
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the mutex is not locked by the calling thread.
+ * @return OE_TIMEOUT the deadline passed before the thread was signaled.
+ *
+ */
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* cond,
+    oe_mutex_t* mutex,
+    uint64_t deadline);
+
 /**
  * Signal a thread waiting on a condition variable.
  *
@@ -638,6 +713,55 @@ oe_result_t oe_thread_setspecific(oe_thread_key_t key, const void* value);
  */
 void* oe_thread_getspecific(oe_thread_key_t key);
 
+/**
+ * @cond DEV
+ */
+
+/**
+ * Set the spin budget of mutexes, condition variables and r/w locks.
+ *
+ * A thread that must wait on one of these objects first polls it this many
+ * times before it exits the enclave to block in the host. Likewise, waking a
+ * thread that is still polling does not exit the enclave. A budget of zero
+ * blocks immediately. The default is OE_THREAD_DEFAULT_SPIN_COUNT.
+ *
+ * @param spin_count The number of polling iterations.
+ */
+void oe_thread_set_spin_count(uint64_t spin_count);
+
+/* Counters of how thread waits and wake-ups were resolved */
+typedef struct _oe_thread_wait_stats
+{
+    /* Locks acquired by spinning, without blocking in the host */
+    uint64_t spin_acquires;
+
+    /* Waits that were satisfied while spinning */
+    uint64_t spin_wakeups;
+
+    /* Waits that blocked in the host (OE_OCALL_THREAD_WAIT) */
+    uint64_t host_waits;
+
+    /* Wake-ups delivered to a spinning thread without an OCALL */
+    uint64_t elided_wakes;
+
+    /* Wake-ups that required an OCALL (OE_OCALL_THREAD_WAKE) */
+    uint64_t host_wakes;
+} oe_thread_wait_stats_t;
+
+/**
+ * Obtain the thread wait counters of the calling enclave.
+ *
+ * @param stats[out] The counters accumulated since the enclave was created.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER **stats** is null
+ */
+oe_result_t oe_get_thread_wait_stats(oe_thread_wait_stats_t* stats);
+
+/**
+ * @endcond
+ */
+
 OE_EXTERNC_END
 
 #endif //_OE_ENCLAVE_H
@@ -4,6 +4,7 @@
 #ifndef _OE_INCLUDE_TIME_H
 #define _OE_INCLUDE_TIME_H
 
+#include <openenclave/bits/defs.h>
 #include <openenclave/bits/types.h>
 
 OE_EXTERNC_BEGIN
@@ -35,6 +36,92 @@ int oe_sleep(uint64_t milliseconds);
 
 uint64_t oe_get_time(void);
 
+/*
+**==============================================================================
+**
+** oe_get_clock_time()
+**
+**     Read the given clock in nanoseconds. Returns (uint64_t)-1 on error.
+**
+**     OE_CLOCK_REALTIME counts from the Epoch. OE_CLOCK_MONOTONIC counts from
+**     an unspecified point and never goes backwards within an enclave, even
+**     if the host reports otherwise.
+**
+**==============================================================================
+*/
+
+typedef enum _oe_clock {
+    OE_CLOCK_REALTIME,
+    OE_CLOCK_MONOTONIC,
+    __OE_CLOCK_MAX = OE_ENUM_MAX,
+} oe_clock_t;
+
+uint64_t oe_get_clock_time(oe_clock_t clock);
+
+/* Values of the OE_OCALL_GET_TIME argument (default: milliseconds since the
+ * Epoch). The nanosecond variants return the reading of an oe_clock_t. */
+#define OE_GET_TIME_MSEC 0
+#define OE_GET_TIME_REALTIME_NSEC 1
+#define OE_GET_TIME_MONOTONIC_NSEC 2
+
+/*
+**==============================================================================
+**
+** oe_time_page_t
+**
+**     Clock readings published by a host thread into host memory, so that
+**     the enclave can read the time without an OCALL (see
+**     OE_ENCLAVE_FLAG_SHARED_TIME). The host makes sequence odd while it
+**     updates the readings, so a reader retries until it sees the same even
+**     sequence before and after reading them.
+**
+**==============================================================================
+*/
+
+/* Interval between host updates of the time page in microseconds */
+#define OE_TIME_PAGE_UPDATE_USEC 500
+
+typedef struct _oe_time_page
+{
+    volatile uint64_t sequence;
+
+    /* Nanoseconds since the Epoch */
+    volatile uint64_t realtime;
+
+    /* Nanoseconds since an unspecified point */
+    volatile uint64_t monotonic;
+
+    /* Set by the host to stop the update thread */
+    volatile uint64_t stop;
+} oe_time_page_t;
+
+/*
+**==============================================================================
+**
+** oe_set_time_policy()
+**
+**     Select where the enclave reads the time from:
+**
+**     OE_TIME_POLICY_SHARED_PAGE - read the host time page when the enclave
+**         was created with OE_ENCLAVE_FLAG_SHARED_TIME, else make an OCALL.
+**         Readings are only as fresh as the last host update.
+**
+**     OE_TIME_POLICY_OCALL - always ask the host with an OCALL.
+**
+**     Both sources are provided by the host and are equally untrusted; the
+**     enclave only enforces that OE_CLOCK_MONOTONIC never goes backwards.
+**
+**==============================================================================
+*/
+
+typedef enum _oe_time_policy {
+    OE_TIME_POLICY_SHARED_PAGE,
+    OE_TIME_POLICY_OCALL,
+    __OE_TIME_POLICY_MAX = OE_ENUM_MAX,
+} oe_time_policy_t;
+
+int oe_set_time_policy(oe_time_policy_t policy);
+
 OE_EXTERNC_END
 
 #endif /* _OE_INCLUDE_TIME_H */
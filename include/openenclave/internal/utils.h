@@ -96,6 +96,21 @@ OE_INLINE uint64_t StrCode(const char* s, uint64_t n)
     return (uint64_t)s[0] | ((uint64_t)s[n - 1] << 8) | ((uint64_t)n << 16);
 }
 
+/* 64-bit FNV-1a hash of the given bytes */
+OE_INLINE uint64_t oe_fnv1a_hash(const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
 /**
  * Acquire and Release memory barriers for open enclave.
  *
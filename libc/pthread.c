@@ -45,11 +45,30 @@ OE_INLINE int _to_errno(oe_result_t result)
             return EPERM;
         case OE_OUT_OF_MEMORY:
             return ENOMEM;
+        case OE_TIMEOUT:
+            return ETIMEDOUT;
         default:
             return EINVAL; /* unreachable */
     }
 }
 
+/* Convert an absolute CLOCK_REALTIME time to milliseconds since the Epoch,
+ * rounding up so that a timed wait never returns before its deadline */
+static int _to_deadline(const struct timespec* ts, uint64_t* deadline)
+{
+    if (!ts || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000)
+        return EINVAL;
+
+    /* Times before the Epoch have already passed */
+    if (ts->tv_sec < 0)
+        *deadline = 0;
+    else
+        *deadline = (uint64_t)ts->tv_sec * 1000 +
+                    ((uint64_t)ts->tv_nsec + 999999) / 1000000;
+
+    return 0;
+}
+
 /*
 **==============================================================================
 **
@@ -220,6 +239,17 @@ int pthread_mutex_trylock(pthread_mutex_t* m)
     return _to_errno(oe_mutex_trylock((oe_mutex_t*)m));
 }
 
+int pthread_mutex_timedlock(pthread_mutex_t* m, const struct timespec* ts)
+{
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)) != 0)
+        return err;
+
+    return _to_errno(oe_mutex_timedlock((oe_mutex_t*)m, deadline));
+}
+
 int pthread_mutex_unlock(pthread_mutex_t* m)
 {
     return _to_errno(oe_mutex_unlock((oe_mutex_t*)m));
@@ -288,8 +318,14 @@ int pthread_cond_timedwait(
     pthread_mutex_t* mutex,
     const struct timespec* ts)
 {
-    assert("pthread_cond_timedwait(): panic" == NULL);
-    return -1;
+    uint64_t deadline;
+    int err;
+
+    if ((err = _to_deadline(ts, &deadline)) != 0)
+        return err;
+
+    return _to_errno(
+        oe_cond_timedwait((oe_cond_t*)cond, (oe_mutex_t*)mutex, deadline));
 }
 
 int pthread_cond_signal(pthread_cond_t* cond)
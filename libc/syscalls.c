@@ -28,9 +28,8 @@
 static oe_syscall_hook_t _hook;
 static oe_spinlock_t _lock;
 
-static const uint64_t _SEC_TO_MSEC = 1000UL;
-static const uint64_t _MSEC_TO_USEC = 1000UL;
-static const uint64_t _MSEC_TO_NSEC = 1000000UL;
+static const uint64_t _SEC_TO_NSEC = 1000000000UL;
+static const uint64_t _USEC_TO_NSEC = 1000UL;
 
 static long
 _syscall_open(long n, long x1, long x2, long x3, long x4, long x5, long x6)
@@ -115,6 +114,11 @@ _syscall_writev(long n, long x1, long x2, long x3, long x4, long x5, long x6)
         ret += iov[i].iov_len;
     }
 
+    /* stdio calls writev() when its own buffer is flushed (by fflush(), on
+     * unbuffered stderr, or on a full buffer), so do not hold back a partial
+     * line in the host output buffer */
+    oe_host_flush();
+
     return ret;
 }
 
@@ -123,23 +127,35 @@ static long _syscall_clock_gettime(long n, long x1, long x2)
     clockid_t clk_id = (clockid_t)x1;
     struct timespec* tp = (struct timespec*)x2;
     int ret = -1;
-    uint64_t msec;
+    uint64_t nsec;
+    oe_clock_t clock;
 
     if (!tp)
         goto done;
 
-    if (clk_id != CLOCK_REALTIME)
+    switch (clk_id)
     {
-        /* Only supporting CLOCK_REALTIME */
-        oe_assert("clock_gettime(): panic" == NULL);
-        goto done;
+        case CLOCK_REALTIME:
+        case CLOCK_REALTIME_COARSE:
+            clock = OE_CLOCK_REALTIME;
+            break;
+        case CLOCK_MONOTONIC:
+        case CLOCK_MONOTONIC_COARSE:
+        case CLOCK_MONOTONIC_RAW:
+        case CLOCK_BOOTTIME:
+            clock = OE_CLOCK_MONOTONIC;
+            break;
+        default:
+            /* CPU-time clocks are not supported */
+            oe_assert("clock_gettime(): panic" == NULL);
+            goto done;
     }
 
-    if ((msec = oe_get_time()) == (uint64_t)-1)
+    if ((nsec = oe_get_clock_time(clock)) == (uint64_t)-1)
         goto done;
 
-    tp->tv_sec = msec / _SEC_TO_MSEC;
-    tp->tv_nsec = (msec % _SEC_TO_MSEC) * _MSEC_TO_NSEC;
+    tp->tv_sec = nsec / _SEC_TO_NSEC;
+    tp->tv_nsec = nsec % _SEC_TO_NSEC;
 
     ret = 0;
 
@@ -153,7 +169,7 @@ static long _syscall_gettimeofday(long n, long x1, long x2)
     struct timeval* tv = (struct timeval*)x1;
     void* tz = (void*)x2;
     int ret = -1;
-    uint64_t msec;
+    uint64_t nsec;
 
     if (tv)
         oe_memset(tv, 0, sizeof(struct timeval));
@@ -164,11 +180,11 @@ static long _syscall_gettimeofday(long n, long x1, long x2)
     if (!tv)
         goto done;
 
-    if ((msec = oe_get_time()) == (uint64_t)-1)
+    if ((nsec = oe_get_clock_time(OE_CLOCK_REALTIME)) == (uint64_t)-1)
         goto done;
 
-    tv->tv_sec = msec / _SEC_TO_MSEC;
-    tv->tv_usec = msec % _MSEC_TO_USEC;
+    tv->tv_sec = nsec / _SEC_TO_NSEC;
+    tv->tv_usec = (nsec % _SEC_TO_NSEC) / _USEC_TO_NSEC;
 
     ret = 0;
 
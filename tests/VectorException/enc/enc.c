@@ -291,6 +291,21 @@ OE_ECALL void TestVectorException(void* args_)
     return;
 }
 
+// Occupy this thread's TCS and have the host raise an exception in the
+// enclave from another thread, which runs on the second TCS.
+OE_ECALL void TestVectorExceptionOnSecondTcs(void* args_)
+{
+    TestVectorExceptionArgs* args = (TestVectorExceptionArgs*)args_;
+
+    if (!oe_is_outside_enclave(args, sizeof(TestVectorExceptionArgs)))
+        return;
+
+    args->ret = -1;
+
+    if (oe_call_host("HostTestVectorExceptionOnNewThread", args) != OE_OK)
+        args->ret = -1;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
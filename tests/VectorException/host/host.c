@@ -10,8 +10,14 @@
 #include "../args.h"
 #include "../host/cpuid.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
 #define SKIP_RETURN_CODE 2
 
+static oe_enclave_t* _enclave;
+
 void TestVectorException(oe_enclave_t* enclave)
 {
     TestVectorExceptionArgs args;
@@ -27,6 +33,43 @@ void TestVectorException(oe_enclave_t* enclave)
     OE_TEST(args.ret == 0);
 }
 
+#if defined(__linux__)
+static void* _test_vector_exception_thread(void* args)
+{
+    oe_result_t result = oe_call_enclave(_enclave, "TestVectorException", args);
+    if (result != OE_OK)
+        oe_put_err("oe_call_enclave() failed: result=%u", result);
+
+    return NULL;
+}
+
+// Called by TestVectorExceptionOnSecondTcs while it holds the first TCS.
+OE_OCALL void HostTestVectorExceptionOnNewThread(void* args)
+{
+    pthread_t thread;
+
+    OE_TEST(
+        pthread_create(&thread, NULL, _test_vector_exception_thread, args) ==
+        0);
+    OE_TEST(pthread_join(thread, NULL) == 0);
+}
+
+// The host must find the enclave of an exception raised on any TCS.
+void TestVectorExceptionOnSecondTcs(oe_enclave_t* enclave)
+{
+    TestVectorExceptionArgs args;
+    memset(&args, 0, sizeof(args));
+    args.ret = -1;
+
+    oe_result_t result =
+        oe_call_enclave(enclave, "TestVectorExceptionOnSecondTcs", &args);
+    if (result != OE_OK)
+        oe_put_err("oe_call_enclave() failed: result=%u", result);
+
+    OE_TEST(args.ret == 0);
+}
+#endif
+
 void TestSigillHandling(oe_enclave_t* enclave)
 {
     TestSigillHandlingArgs args;
@@ -139,7 +182,12 @@ int main(int argc, const char* argv[])
         oe_call_enclave(enclave, "TestCpuidInGlobalConstructors", NULL) ==
         OE_OK);
 
+    _enclave = enclave;
+
     TestVectorException(enclave);
+#if defined(__linux__)
+    TestVectorExceptionOnSecondTcs(enclave);
+#endif
     TestSigillHandling(enclave);
 
     oe_terminate_enclave(enclave);
@@ -0,0 +1,335 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/aesm.h>
+#include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+**==============================================================================
+**
+** Mock AESM service: answers INIT_QUOTE and GET_LAUNCH_TOKEN requests on a
+** private socket with fixed data, so that the client in host/linux/aesm.c
+** can be tested without SGX hardware or aesmd.
+**
+**==============================================================================
+*/
+
+#define MESSAGE_TYPE_INIT_QUOTE 1
+#define MESSAGE_TYPE_GET_LAUNCH_TOKEN 3
+
+#define TARGET_INFO_BYTE 0xAB
+#define LAUNCH_TOKEN_BYTE 0xCD
+
+#define NUM_THREADS 4
+#define NUM_REQUESTS 16
+
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t _num_connections;
+static size_t _num_requests;
+
+/* Close the connection after the next response (like a restarted AESM) */
+static bool _close_after_response;
+
+static int _read_all(int sock, void* data, size_t size)
+{
+    uint8_t* p = (uint8_t*)data;
+
+    while (size)
+    {
+        ssize_t n = read(sock, p, size);
+
+        if (n <= 0)
+            return -1;
+
+        p += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+static size_t _pack_varint(uint8_t* p, uint32_t x)
+{
+    size_t n = 0;
+
+    while (x >= 0x80)
+    {
+        p[n++] = (uint8_t)(x | 0x80);
+        x >>= 7;
+    }
+
+    p[n++] = (uint8_t)x;
+    return n;
+}
+
+/* Append a length-delimited field */
+static size_t _pack_bytes(uint8_t* p, uint8_t field, uint8_t byte, size_t size)
+{
+    size_t n = 0;
+
+    p[n++] = (uint8_t)(field << 3 | 2);
+    n += _pack_varint(p + n, (uint32_t)size);
+    memset(p + n, byte, size);
+
+    return n + size;
+}
+
+static int _write_response(int sock, uint8_t type)
+{
+    uint8_t payload[2048];
+    uint8_t envelope[2048 + 8];
+    size_t payload_size = 0;
+    uint32_t size = 0;
+
+    /* Error code 0 */
+    payload[payload_size++] = 1 << 3;
+    payload[payload_size++] = 0;
+
+    if (type == MESSAGE_TYPE_INIT_QUOTE)
+    {
+        payload_size += _pack_bytes(
+            payload + payload_size,
+            2,
+            TARGET_INFO_BYTE,
+            sizeof(sgx_target_info_t));
+        payload_size += _pack_bytes(
+            payload + payload_size, 3, 0, sizeof(sgx_epid_group_id_t));
+    }
+    else if (type == MESSAGE_TYPE_GET_LAUNCH_TOKEN)
+    {
+        payload_size += _pack_bytes(
+            payload + payload_size,
+            2,
+            LAUNCH_TOKEN_BYTE,
+            sizeof(sgx_launch_token_t));
+    }
+    else
+    {
+        return -1;
+    }
+
+    envelope[size++] = (uint8_t)(type << 3 | 2);
+    size += _pack_varint(envelope + size, (uint32_t)payload_size);
+    memcpy(envelope + size, payload, payload_size);
+    size += payload_size;
+
+    if (write(sock, &size, sizeof(size)) != sizeof(size) ||
+        write(sock, envelope, size) != size)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void* _serve_connection(void* arg)
+{
+    int sock = (int)(intptr_t)arg;
+    uint8_t request[4096];
+    uint32_t size;
+
+    while (_read_all(sock, &size, sizeof(size)) == 0 &&
+           size <= sizeof(request) && _read_all(sock, request, size) == 0)
+    {
+        bool close_connection;
+
+        if (size == 0 || _write_response(sock, request[0] >> 3) != 0)
+            break;
+
+        pthread_mutex_lock(&_lock);
+        _num_requests++;
+        close_connection = _close_after_response;
+        _close_after_response = false;
+        pthread_mutex_unlock(&_lock);
+
+        if (close_connection)
+            break;
+    }
+
+    close(sock);
+    return NULL;
+}
+
+static void* _serve(void* arg)
+{
+    int listener = (int)(intptr_t)arg;
+    int sock;
+
+    while ((sock = accept(listener, NULL, NULL)) >= 0)
+    {
+        pthread_t thread;
+
+        pthread_mutex_lock(&_lock);
+        _num_connections++;
+        pthread_mutex_unlock(&_lock);
+
+        OE_TEST(
+            pthread_create(
+                &thread, NULL, _serve_connection, (void*)(intptr_t)sock) ==
+            0);
+        pthread_detach(thread);
+    }
+
+    return NULL;
+}
+
+static int _start_mock(const char* path, pthread_t* thread)
+{
+    struct sockaddr_un addr;
+    int listener;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+
+    OE_TEST((listener = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0);
+    OE_TEST(bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    OE_TEST(listen(listener, 16) == 0);
+    OE_TEST(
+        pthread_create(thread, NULL, _serve, (void*)(intptr_t)listener) == 0);
+
+    return listener;
+}
+
+static size_t _get_num_connections(void)
+{
+    size_t n;
+
+    pthread_mutex_lock(&_lock);
+    n = _num_connections;
+    pthread_mutex_unlock(&_lock);
+
+    return n;
+}
+
+/*
+**==============================================================================
+**
+** Tests
+**
+**==============================================================================
+*/
+
+static void _init_quote(void)
+{
+    aesm_t* aesm;
+    sgx_target_info_t target_info;
+    sgx_epid_group_id_t epid_group_id;
+
+    OE_TEST((aesm = aesm_connect()) != NULL);
+    OE_TEST(aesm_init_quote(aesm, &target_info, &epid_group_id) == OE_OK);
+    OE_TEST(target_info.mrenclave[0] == TARGET_INFO_BYTE);
+    aesm_disconnect(aesm);
+}
+
+/* Sequential requests share one connection */
+static void _test_reuse(void)
+{
+    const size_t connections = _get_num_connections();
+
+    for (size_t i = 0; i < NUM_REQUESTS; i++)
+        _init_quote();
+
+    OE_TEST(_get_num_connections() == connections + 1);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+/* A request on a connection that AESM closed is sent again */
+static void _test_reconnect(void)
+{
+    const size_t connections = _get_num_connections();
+
+    pthread_mutex_lock(&_lock);
+    _close_after_response = true;
+    pthread_mutex_unlock(&_lock);
+
+    _init_quote();
+    _init_quote();
+
+    OE_TEST(_get_num_connections() == connections + 1);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void _test_launch_token(void)
+{
+    aesm_t* aesm;
+    uint8_t mrenclave[OE_SHA256_SIZE] = {0};
+    uint8_t modulus[OE_KEY_SIZE] = {0};
+    sgx_attributes_t attributes = {0};
+    sgx_launch_token_t launch_token;
+
+    OE_TEST((aesm = aesm_connect()) != NULL);
+    OE_TEST(
+        aesm_get_launch_token(
+            aesm, mrenclave, modulus, &attributes, &launch_token) == OE_OK);
+    OE_TEST(launch_token.contents[0] == LAUNCH_TOKEN_BYTE);
+    aesm_disconnect(aesm);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+static void* _thread(void* arg)
+{
+    OE_UNUSED(arg);
+
+    for (size_t i = 0; i < NUM_REQUESTS; i++)
+        _init_quote();
+
+    return NULL;
+}
+
+/* Concurrent requests use separate pooled connections */
+static void _test_threads(void)
+{
+    pthread_t threads[NUM_THREADS];
+    const size_t connections = _get_num_connections();
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        OE_TEST(pthread_create(&threads[i], NULL, _thread, NULL) == 0);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    OE_TEST(_get_num_connections() <= connections + NUM_THREADS);
+
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+int main(int argc, const char* argv[])
+{
+    char path[64];
+    pthread_t thread;
+    int listener;
+
+    OE_UNUSED(argc);
+
+    snprintf(path, sizeof(path), "/tmp/oe-aesm-mock-%d.socket", getpid());
+    setenv("OE_AESM_SOCKET", path, 1);
+    listener = _start_mock(path, &thread);
+
+    _test_reuse();
+    _test_reconnect();
+    _test_launch_token();
+    _test_threads();
+
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    pthread_join(thread, NULL);
+    unlink(path);
+
+    printf("=== passed all tests (%s)\n", argv[0]);
+
+    return 0;
+}
@@ -44,5 +44,36 @@ void TestRandom(void)
         }
     }
 
+    /* Generate more than one DRBG request's worth of bytes at once */
+    {
+        static uint8_t big[4099];
+        size_t zeros = 0;
+
+        memset(big, 0, sizeof(big));
+        OE_TEST(oe_random_internal(big, sizeof(big)) == OE_OK);
+
+        for (size_t i = 0; i < sizeof(big); i++)
+            zeros += (big[i] == 0);
+
+        /* About 16 zero bytes are expected; an unfilled tail has hundreds */
+        OE_TEST(zeros < 128);
+        OE_TEST(memcmp(big, big + 1024, 1024) != 0);
+    }
+
+#if defined(OE_BUILD_ENCLAVE)
+    /* Reseed on every request */
+    {
+        uint8_t a[M];
+        uint8_t b[M];
+
+        OE_TEST(oe_random_set_reseed_interval(0) == OE_INVALID_PARAMETER);
+        OE_TEST(oe_random_set_reseed_interval(1) == OE_OK);
+        OE_TEST(oe_random_internal(a, sizeof(a)) == OE_OK);
+        OE_TEST(oe_random_internal(b, sizeof(b)) == OE_OK);
+        OE_TEST(memcmp(a, b, sizeof(a)) != 0);
+        OE_TEST(oe_random_set_reseed_interval(10000) == OE_OK);
+    }
+#endif
+
     printf("=== passed %s()\n", __FUNCTION__);
 }
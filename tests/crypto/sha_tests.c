@@ -24,5 +24,20 @@ void TestSHA(void)
     oe_sha256_final(&ctx, &hash);
     OE_TEST(memcmp(&hash, &ALPHABET_HASH, sizeof(OE_SHA256)) == 0);
 
+    /* A clone taken midway finishes with the same hash */
+    {
+        const size_t half = strlen(ALPHABET) / 2;
+        oe_sha256_context_t clone = {0};
+
+        memset(&hash, 0, sizeof(hash));
+        oe_sha256_init(&ctx);
+        oe_sha256_update(&ctx, ALPHABET, half);
+        OE_TEST(oe_sha256_clone(&clone, &ctx) == OE_OK);
+        oe_sha256_update(&ctx, "ignored", 7);
+        oe_sha256_update(&clone, ALPHABET + half, strlen(ALPHABET) - half);
+        oe_sha256_final(&clone, &hash);
+        OE_TEST(memcmp(&hash, &ALPHABET_HASH, sizeof(OE_SHA256)) == 0);
+    }
+
     printf("=== passed %s()\n", __FUNCTION__);
 }
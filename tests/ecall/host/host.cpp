@@ -59,6 +59,35 @@ void TestECall(oe_enclave_t* enclave)
     prev = args.thread_data.last_sp;
 }
 
+void TestECallByHandle(oe_enclave_t* enclave, size_t n)
+{
+    oe_enclave_function_handle_t handle = 0;
+    oe_enclave_function_handle_t missing = 0;
+
+    OE_TEST(oe_get_enclave_function(enclave, "Test", &handle) == OE_OK);
+    OE_TEST(handle != 0);
+
+    OE_TEST(
+        oe_get_enclave_function(enclave, "NoSuchFunction", &missing) ==
+        OE_NOT_FOUND);
+    OE_TEST(missing == 0);
+    OE_TEST(
+        oe_call_enclave_by_handle(enclave, missing, NULL) ==
+        OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        TestArgs args;
+        memset(&args, 0, sizeof(TestArgs));
+
+        OE_TEST(oe_call_enclave_by_handle(enclave, handle, &args) == OE_OK);
+        OE_TEST(args.magic == NEW_MAGIC);
+        OE_TEST(args.mm == 12);
+        OE_TEST(args.dd == 31);
+        OE_TEST(args.yyyy == 1962);
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -93,6 +122,9 @@ int main(int argc, const char* argv[])
         TestECall(enclave);
     }
 
+    printf("=== TestECallByHandle()\n");
+    TestECallByHandle(enclave, N);
+
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
     {
         oe_put_err("oe_terminate_enclave(): result=%u", result);
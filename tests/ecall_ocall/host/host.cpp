@@ -284,6 +284,32 @@ static void TestExecutionParallel(
     }
 }
 
+// Called from enclave 0. Once a call into enclave 1 has returned, a call
+// back into enclave 0 from this thread must still find the TCS blocked in
+// this OCALL.
+OE_OCALL void NestedCallAfterOtherEnclave(void*)
+{
+    OE_TEST(
+        oe_call_enclave(EnclaveWrap::Get(1), "EncSetFactor", NULL) == OE_OK);
+    OE_TEST(
+        oe_call_enclave(EnclaveWrap::Get(0), "EncSetFactor", NULL) ==
+        OE_REENTRANT_ECALL);
+}
+
+static void TestNestedCallAfterOtherEnclave()
+{
+    EncTestCallHostFunctionArg args = {};
+
+    args.result = OE_FAILURE;
+    args.function_name = "NestedCallAfterOtherEnclave";
+    OE_TEST(
+        oe_call_enclave(
+            EnclaveWrap::Get(0), "EncTestCallHostFunction", &args) == OE_OK);
+    OE_TEST(args.result == OE_OK);
+
+    printf("=== TestNestedCallAfterOtherEnclave passed\n");
+}
+
 OE_OCALL void CrossEnclaveCall(CrossEnclaveCallArg* arg)
 {
     if (arg->enclave_id < EnclaveWrap::Count())
@@ -388,6 +414,9 @@ int main(int argc, const char* argv[])
     // verify threads execute in parallel across enclaves
     TestExecutionParallel({enc1.GetId(), enc2.GetId()}, THREAD_COUNT);
 
+    // Verify that nesting into another enclave keeps this thread's binding
+    TestNestedCallAfterOtherEnclave();
+
     // Verify enclaves calling each other via the host.
     // Create 5 enclaves.
     EnclaveWrap enc3(argv[1], flags);
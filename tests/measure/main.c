@@ -0,0 +1,171 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/sha.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../host/sgxmeasure.h"
+
+/* Arbitrary enclave base address (only offsets are measured) */
+#define BASE 0x100000000
+
+/* Default size of the benchmark in megabytes (see main) */
+#define DEFAULT_BENCHMARK_MB 64
+
+static const uint64_t _flags[] = {
+    SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_X,
+    SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W,
+    SGX_SECINFO_TCS,
+};
+
+/* The measurement as specified: one update per field */
+static void _reference_measure(
+    oe_sha256_context_t* context,
+    uint64_t vaddr,
+    uint64_t flags,
+    const uint8_t* page,
+    bool extend)
+{
+    static const uint8_t zeros[48];
+
+    oe_sha256_update(context, "EADD\0\0\0", 8);
+    oe_sha256_update(context, &vaddr, sizeof(vaddr));
+    oe_sha256_update(context, &flags, sizeof(flags));
+    oe_sha256_update(context, zeros, 40);
+
+    for (uint64_t pgoff = 0; extend && pgoff < OE_PAGE_SIZE; pgoff += 256)
+    {
+        const uint64_t moffset = vaddr + pgoff;
+
+        oe_sha256_update(context, "EEXTEND", 8);
+        oe_sha256_update(context, &moffset, sizeof(moffset));
+        oe_sha256_update(context, zeros, 48);
+        oe_sha256_update(context, page + pgoff, 256);
+    }
+}
+
+static void _fill_pages(uint8_t* pages, size_t npages)
+{
+    for (size_t i = 0; i < npages * OE_PAGE_SIZE; i++)
+        pages[i] = (uint8_t)rand();
+
+    /* Include a zero page and a stack page */
+    if (npages > 2)
+    {
+        memset(pages, 0, OE_PAGE_SIZE);
+        memset(pages + OE_PAGE_SIZE, 0xcc, OE_PAGE_SIZE);
+    }
+}
+
+static double _measure_pages(
+    const uint8_t* pages,
+    size_t npages,
+    bool reference,
+    OE_SHA256* hash)
+{
+    oe_sha256_context_t context;
+    clock_t start = clock();
+
+    oe_sha256_init(&context);
+
+    for (size_t i = 0; i < npages; i++)
+    {
+        const uint64_t vaddr = i * OE_PAGE_SIZE;
+        const uint64_t flags = _flags[i % OE_COUNTOF(_flags)];
+        const uint8_t* page = pages + vaddr;
+        const bool extend = (i % 5) != 0;
+
+        if (reference)
+        {
+            _reference_measure(&context, vaddr, flags, page, extend);
+        }
+        else
+        {
+            OE_TEST(
+                oe_sgx_measure_load_enclave_data(
+                    &context,
+                    BASE,
+                    BASE + vaddr,
+                    (uint64_t)page,
+                    flags,
+                    extend) == OE_OK);
+        }
+    }
+
+    oe_sha256_final(&context, hash);
+
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void _test_measurement(void)
+{
+    const size_t npages = 64;
+    uint8_t* pages = (uint8_t*)malloc(npages * OE_PAGE_SIZE);
+    OE_SHA256 expected;
+    OE_SHA256 hash;
+
+    OE_TEST(pages != NULL);
+    _fill_pages(pages, npages);
+
+    _measure_pages(pages, npages, true, &expected);
+    _measure_pages(pages, npages, false, &hash);
+    OE_TEST(memcmp(&hash, &expected, sizeof(hash)) == 0);
+
+    free(pages);
+    printf("=== passed %s()\n", __FUNCTION__);
+}
+
+/* Compare the time taken to measure npages with both implementations */
+static void _benchmark_measurement(size_t megabytes)
+{
+    /* Measure the same buffer repeatedly to cover large enclaves */
+    const size_t npages = 4096;
+    const size_t passes = (megabytes * 1024 * 1024) / (npages * OE_PAGE_SIZE);
+    uint8_t* pages = (uint8_t*)malloc(npages * OE_PAGE_SIZE);
+    double reference_time = 0;
+    double time = 0;
+    OE_SHA256 hash;
+
+    OE_TEST(pages != NULL);
+    _fill_pages(pages, npages);
+
+    for (size_t i = 0; i < passes; i++)
+    {
+        reference_time += _measure_pages(pages, npages, true, &hash);
+        time += _measure_pages(pages, npages, false, &hash);
+    }
+
+    printf(
+        "=== measured %zu MB: %.3f sec (one update per field: %.3f sec)\n",
+        passes * npages * OE_PAGE_SIZE / (1024 * 1024),
+        time,
+        reference_time);
+
+    free(pages);
+}
+
+int main(int argc, const char* argv[])
+{
+    size_t megabytes = DEFAULT_BENCHMARK_MB;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "Usage: %s [BENCHMARK_MB]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc == 2)
+        megabytes = strtoul(argv[1], NULL, 10);
+
+    _test_measurement();
+    _benchmark_measurement(megabytes);
+
+    printf("=== passed all tests (measure)\n");
+
+    return 0;
+}
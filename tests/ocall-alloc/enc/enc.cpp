@@ -183,8 +183,9 @@ static Cmd Commands[] = {
     {'v', 0x2000, 2},
     {'a', 0xFE8, 2},
     {'v', 0x2000, 2},
+    // too large for a bucket: allocated directly with an 8-byte header
     {'a', 0xFE9, 2},
-    {'v', 0x4002, 4},
+    {'v', 0x3FE2, 4},
     {'d', 4},
 
     {'v', 0x2000, 2},
@@ -192,7 +193,7 @@ static Cmd Commands[] = {
     {'a', 1024, 20},
     {'v', 0x7000, 7},
     {'a', 1024 * 1024},
-    {'v', 0x107018, 8},
+    {'v', 0x107008, 8},
     {'d'},
     {'x', 1024, 20},
     {'d', 20},
@@ -9,6 +9,10 @@
    + __cxa_atexit
    + oe_host_malloc
    + oe_host_free
+   + oe_atexit
+
+   The wrapped allocator keeps its thread buckets in a variable of its own
+   rather than in the td_t used by the real one.
 
  */
 
@@ -16,9 +20,11 @@
 #define oe_host_free_for_call_host test_host_free_for_call_host
 #define oe_host_malloc test_host_malloc
 #define oe_host_free test_host_free
-#define oe_thread_key_create test_thread_key_create
-#define oe_thread_setspecific test_thread_setspecific
 #define oe_free_thread_buckets test_free_thread_buckets
+#define oe_atexit test_atexit
 #define __cxa_atexit test_cxa_atexit
 
+static void* _test_thread_buckets;
+#define OE_HOST_STACK_THREAD_SLOT _test_thread_buckets
+
 #include "../../../enclave/core/hoststack.c"
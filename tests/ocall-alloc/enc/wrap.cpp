@@ -8,7 +8,6 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/atexit.h>
 #include <openenclave/internal/tests.h>
-#include <openenclave/internal/thread.h>
 #include <map>
 #include <vector>
 // And local wrap
@@ -17,6 +16,7 @@
 static struct
 {
     std::vector<std::pair<void (*)(void*), void*>> exits;
+    std::vector<void (*)(void)> atexits;
     std::map<void*, size_t> allocations;
 } stats;
 
@@ -28,6 +28,13 @@ int test_cxa_atexit(void (*func)(void*), void* arg, void* dso_handle)
     return __cxa_atexit(func, arg, dso_handle);
 }
 
+int test_atexit(void (*func)(void))
+{
+    // Run by Exit() only: the wrapped buckets are not the enclave's
+    stats.atexits.push_back(func);
+    return 0;
+}
+
 void* test_host_malloc(size_t size)
 {
     void* p;
@@ -48,26 +55,6 @@ void test_host_free(void* ptr)
     oe_host_free(ptr);
 }
 
-oe_result_t test_thread_key_create(
-    oe_thread_key_t* key,
-    void (*destructor)(void* value))
-{
-    // Ignore the destrutor.
-    return oe_thread_key_create(key, NULL);
-}
-
-void test_free_thread_buckets(void* arg);
-
-oe_result_t test_thread_setspecific(oe_thread_key_t key, const void* value)
-{
-    oe_result_t result;
-
-    if ((result = oe_thread_setspecific(key, value)) == OE_OK)
-        test_cxa_atexit(test_free_thread_buckets, (void*)value, NULL);
-
-    return OE_OK;
-}
-
 OE_EXTERNC_END
 
 size_t GetAllocationCount()
@@ -87,4 +74,7 @@ void Exit()
 {
     for (auto e : stats.exits)
         e.first(e.second);
+
+    for (auto f : stats.atexits)
+        f();
 }
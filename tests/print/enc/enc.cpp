@@ -5,6 +5,7 @@
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/tests.h>
 #include <stdio.h>
+#include <string.h>
 #include "print_t.h"
 
 int enclave_test_print()
@@ -34,6 +35,32 @@ int enclave_test_print()
         oe_host_write(0, str, sizeof(str) - 1);
     }
 
+    /* Write to standard output through the line buffer */
+    {
+        /* Pieces of a line are joined before they reach the host */
+        oe_host_write(0, "oe_host_write", (size_t)-1);
+        oe_host_write(0, "(partial)\n", (size_t)-1);
+
+        OE_TEST(oe_host_write(0, "oe_host_flush()", (size_t)-1) == 0);
+        OE_TEST(oe_host_flush() == 0);
+        oe_host_write(0, "\n", (size_t)-1);
+
+        /* Output larger than the buffer is written in one piece */
+        const char line[] = "oe_host_write(long)\n";
+        char text[64 * (sizeof(line) - 1)];
+
+        for (size_t i = 0; i < sizeof(text); i += sizeof(line) - 1)
+            memcpy(text + i, line, sizeof(line) - 1);
+
+        OE_TEST(oe_host_write(0, text, sizeof(text)) == 0);
+
+        /* Unbuffered output is written through immediately */
+        oe_host_set_output_buffering(false);
+        oe_host_write(0, "oe_host_write", (size_t)-1);
+        oe_host_write(0, "(unbuffered)\n", (size_t)-1);
+        oe_host_set_output_buffering(true);
+    }
+
     /* Write to standard error */
     {
         n = fwrite("fwrite(stderr)\n", 1, 15, stderr);
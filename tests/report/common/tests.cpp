@@ -13,6 +13,8 @@
 
 #define VerifyReport oe_verify_report
 
+#define VerifyReports oe_verify_reports
+
 #define TEST_FCN OE_ECALL
 
 #else
@@ -53,6 +55,10 @@ oe_result_t VerifyReport(
     return oe_verify_report(g_enclave, report, report_size, parsed_report);
 }
 
+// Verify local reports on as many threads as the enclave has TCSs.
+#define VerifyReports(r, rs, c, res, p) \
+    oe_verify_reports(g_enclave, r, rs, c, 2, res, p)
+
 #define TEST_FCN
 
 #endif
@@ -806,3 +812,99 @@ TEST_FCN void TestRemoteVerifyReport(void* args_)
 #endif
     }
 }
+
+TEST_FCN void TestVerifyReports(void* args_)
+{
+    uint8_t target_info[sizeof(sgx_target_info_t)];
+    size_t target_info_size = sizeof(target_info);
+
+    uint8_t local_report[OE_LOCAL_REPORT_SIZE] = {0};
+    size_t local_report_size = sizeof(local_report);
+    uint8_t tampered_report[OE_LOCAL_REPORT_SIZE] = {0};
+    oe_report_header_t* header = (oe_report_header_t*)tampered_report;
+
+    const uint8_t* reports[5];
+    size_t report_sizes[5];
+    oe_result_t results[5];
+    oe_report_t parsed_reports[5];
+    size_t count = 0;
+
+    GetSGXTargetInfo((sgx_target_info_t*)target_info);
+
+    OE_TEST(
+        GetReport(
+            0,
+            NULL,
+            0,
+            target_info,
+            target_info_size,
+            local_report,
+            &local_report_size) == OE_OK);
+
+    Memcpy(tampered_report, local_report, local_report_size);
+    ((sgx_report_t*)header->report)->mac[0]++;
+
+    // A local report, an identical one and a tampered one.
+    reports[count] = local_report;
+    report_sizes[count++] = local_report_size;
+    reports[count] = local_report;
+    report_sizes[count++] = local_report_size;
+    reports[count] = tampered_report;
+    report_sizes[count++] = local_report_size;
+
+#ifdef OE_USE_LIBSGX
+    // Two remote reports of the same platform.
+    static uint8_t remote_reports[2][OE_MAX_REPORT_SIZE];
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        size_t remote_report_size = sizeof(remote_reports[i]);
+
+        OE_TEST(
+            GetReport(
+                OE_REPORT_FLAGS_REMOTE_ATTESTATION,
+                NULL,
+                0,
+                NULL,
+                0,
+                remote_reports[i],
+                &remote_report_size) == OE_OK);
+
+        reports[count] = remote_reports[i];
+        report_sizes[count++] = remote_report_size;
+    }
+#endif
+
+    OE_TEST(
+        VerifyReports(reports, report_sizes, count, results, parsed_reports) ==
+        OE_VERIFY_FAILED);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reports[i] == tampered_report)
+        {
+            OE_TEST(results[i] == OE_VERIFY_FAILED);
+            continue;
+        }
+
+        OE_TEST(results[i] == OE_OK);
+
+        // Parsed reports point into their own report.
+        OE_TEST(parsed_reports[i].enclave_report > reports[i]);
+        OE_TEST(
+            parsed_reports[i].enclave_report < reports[i] + report_sizes[i]);
+        OE_TEST(
+            Memcmp(
+                parsed_reports[i].identity.unique_id,
+                parsed_reports[0].identity.unique_id,
+                sizeof(parsed_reports[i].identity.unique_id)) == 0);
+    }
+
+    // Without the tampered report the whole batch verifies.
+    reports[2] = local_report;
+    OE_TEST(
+        VerifyReports(reports, report_sizes, count, results, NULL) == OE_OK);
+
+    // An empty batch verifies.
+    OE_TEST(VerifyReports(reports, report_sizes, 0, results, NULL) == OE_OK);
+}
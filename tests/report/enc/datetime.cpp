@@ -32,6 +32,14 @@ void TestNegative(oe_datetime_t date_time, oe_result_t result)
 
 void test_iso8601_time()
 {
+    // Current time
+    {
+        oe_datetime_t now = {0};
+        OE_TEST(oe_datetime_now(&now) == OE_OK);
+        OE_TEST(oe_datetime_is_valid(&now) == OE_OK);
+        OE_TEST(now.year >= 2018);
+    }
+
     // Single digit fields
     TestPositive(oe_datetime_t{2018, 8, 8, 0, 0, 0}, "2018-08-08T00:00:00Z");
 
@@ -7,7 +7,9 @@
 #include <openenclave/internal/hexdump.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/utils.h>
+#include <chrono>
 #include <ctime>
+#include <thread>
 #include <vector>
 #include "../../../common/tcbinfo.h"
 #include "../../../host/quote.h"
@@ -49,6 +51,163 @@ void load_and_verify_report()
 #endif
 }
 
+void test_get_reports(oe_enclave_t* enclave)
+{
+    const size_t count = 4;
+    static uint8_t buffers[count][OE_MAX_REPORT_SIZE];
+    uint8_t* report_buffers[count];
+    size_t report_sizes[count];
+    oe_result_t results[count];
+    oe_result_t verify_results[count];
+    sgx_target_info_t target_info[1];
+    size_t target_info_size = sizeof(target_info);
+
+    // Target the local reports at the enclave itself.
+    report_sizes[0] = sizeof(buffers[0]);
+    OE_TEST(
+        oe_get_report(enclave, 0, NULL, 0, buffers[0], &report_sizes[0]) ==
+        OE_OK);
+    OE_TEST(
+        oe_get_target_info(
+            buffers[0], report_sizes[0], target_info, &target_info_size) ==
+        OE_OK);
+
+    // Local reports, on as many threads as the enclave has TCSs.
+    for (size_t i = 0; i < count; i++)
+    {
+        report_buffers[i] = buffers[i];
+        report_sizes[i] = sizeof(buffers[i]);
+    }
+
+    OE_TEST(
+        oe_get_reports(
+            enclave,
+            0,
+            target_info,
+            sizeof(*target_info),
+            count,
+            2,
+            report_buffers,
+            report_sizes,
+            results) == OE_OK);
+    OE_TEST(
+        oe_verify_reports(
+            enclave,
+            report_buffers,
+            report_sizes,
+            count,
+            2,
+            verify_results,
+            NULL) == OE_OK);
+
+    // A buffer that is too small fails only its own report.
+    report_sizes[1] = 0;
+    OE_TEST(
+        oe_get_reports(
+            enclave,
+            0,
+            target_info,
+            sizeof(*target_info),
+            count,
+            2,
+            report_buffers,
+            report_sizes,
+            results) == OE_BUFFER_TOO_SMALL);
+    OE_TEST(results[0] == OE_OK);
+    OE_TEST(results[1] == OE_BUFFER_TOO_SMALL);
+    OE_TEST(report_sizes[1] == report_sizes[0]);
+
+#ifdef OE_USE_LIBSGX
+    // Remote reports.
+    for (size_t i = 0; i < count; i++)
+        report_sizes[i] = sizeof(buffers[i]);
+
+    OE_TEST(
+        oe_get_reports(
+            enclave,
+            OE_REPORT_FLAGS_REMOTE_ATTESTATION,
+            NULL,
+            0,
+            count,
+            2,
+            report_buffers,
+            report_sizes,
+            results) == OE_OK);
+    OE_TEST(
+        oe_verify_reports(
+            NULL,
+            report_buffers,
+            report_sizes,
+            count,
+            2,
+            verify_results,
+            NULL) == OE_OK);
+#endif
+}
+
+// Compare the quotes per second of oe_verify_report() and oe_verify_reports().
+void benchmark_verify_reports(oe_enclave_t* enclave)
+{
+#ifdef OE_USE_LIBSGX
+    const size_t count = 64;
+    size_t num_threads = std::thread::hardware_concurrency();
+    std::vector<std::vector<uint8_t>> quotes(count);
+    std::vector<const uint8_t*> reports(count);
+    std::vector<size_t> report_sizes(count);
+    std::vector<oe_result_t> results(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t report_size = OE_MAX_REPORT_SIZE;
+
+        quotes[i].resize(report_size);
+        OE_TEST(
+            oe_get_report(
+                enclave,
+                OE_REPORT_FLAGS_REMOTE_ATTESTATION,
+                NULL,
+                0,
+                &quotes[i][0],
+                &report_size) == OE_OK);
+        reports[i] = &quotes[i][0];
+        report_sizes[i] = report_size;
+    }
+
+    // Fetch the collateral so that both runs find it cached.
+    OE_TEST(oe_verify_report(NULL, reports[0], report_sizes[0], NULL) == OE_OK);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(
+            oe_verify_report(NULL, reports[i], report_sizes[i], NULL) ==
+            OE_OK);
+    std::chrono::duration<double> serial =
+        std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    OE_TEST(
+        oe_verify_reports(
+            NULL,
+            &reports[0],
+            &report_sizes[0],
+            count,
+            num_threads ? num_threads : 1,
+            &results[0],
+            NULL) == OE_OK);
+    std::chrono::duration<double> batch =
+        std::chrono::steady_clock::now() - start;
+
+    printf(
+        "oe_verify_report: %.0f quotes/s, oe_verify_reports (%zu threads): "
+        "%.0f quotes/s\n",
+        count / serial.count(),
+        num_threads,
+        count / batch.count());
+#else
+    OE_UNUSED(enclave);
+#endif
+}
+
 int main(int argc, const char* argv[])
 {
     sgx_target_info_t target_info;
@@ -101,6 +260,8 @@ int main(int argc, const char* argv[])
     TestRemoteReport(NULL);
     TestParseReportNegative(NULL);
     TestLocalVerifyReport(NULL);
+    TestVerifyReports(NULL);
+    test_get_reports(enclave);
 
 #ifdef OE_USE_LIBSGX
     TestRemoteVerifyReport(NULL);
@@ -126,6 +287,9 @@ int main(int argc, const char* argv[])
         oe_call_enclave(enclave, "TestLocalVerifyReport", &target_info) ==
         OE_OK);
 
+    OE_TEST(
+        oe_call_enclave(enclave, "TestVerifyReports", &target_info) == OE_OK);
+
 #ifdef OE_USE_LIBSGX
     OE_TEST(
         oe_call_enclave(enclave, "TestRemoteVerifyReport", &target_info) ==
@@ -147,6 +311,8 @@ int main(int argc, const char* argv[])
     test_minimum_issue_date(enclave, now);
 
     generate_and_save_report(enclave);
+
+    benchmark_verify_reports(enclave);
 #endif
 
     /* Terminate the enclave */
@@ -209,6 +209,42 @@ static void _test_time_functions(void)
         OE_TEST(tmp <= now + SEC_TO_USEC);
     }
 
+    /* Test gettimeofday() microseconds */
+    {
+        struct timeval tv = {0, 0};
+        OE_TEST(gettimeofday(&tv, NULL) == 0);
+        OE_TEST(tv.tv_usec >= 0 && tv.tv_usec < 1000000);
+    }
+
+    /* Test clock_gettime(CLOCK_MONOTONIC) never goes backwards */
+    {
+        struct timespec ts;
+        uint64_t last = 0;
+
+        for (size_t i = 0; i < 1000; i++)
+        {
+            OE_TEST(clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+            OE_TEST(ts.tv_nsec >= 0 && ts.tv_nsec < 1000000000);
+
+            uint64_t tmp = ts.tv_sec * 1000000000UL + ts.tv_nsec;
+            OE_TEST(tmp >= last);
+            last = tmp;
+        }
+    }
+
+    /* Test that both time policies agree within a second */
+    {
+        const uint64_t SEC_TO_NSEC = 1000000000UL;
+
+        uint64_t page = oe_get_clock_time(OE_CLOCK_REALTIME);
+        OE_TEST(oe_set_time_policy(OE_TIME_POLICY_OCALL) == 0);
+        uint64_t ocall = oe_get_clock_time(OE_CLOCK_REALTIME);
+        OE_TEST(oe_set_time_policy(OE_TIME_POLICY_SHARED_PAGE) == 0);
+
+        OE_TEST(page != (uint64_t)-1 && ocall != (uint64_t)-1);
+        OE_TEST(ocall + SEC_TO_NSEC >= page && ocall <= page + SEC_TO_NSEC);
+    }
+
     /* Test nanosleep() */
     {
         const uint64_t SLEEP_SECS = 3;
@@ -29,28 +29,14 @@ void TestStdc(oe_enclave_t* enclave)
     OE_TEST(args.strdup_ok);
 }
 
-int main(int argc, const char* argv[])
+static void _test(const char* path, uint32_t flags)
 {
     oe_result_t result;
     oe_enclave_t* enclave = NULL;
 
-    if (argc != 2)
-    {
-        fprintf(stderr, "Usage: %s ENCLAVE\n", argv[0]);
-        exit(1);
-    }
-
-    const uint32_t flags = oe_get_create_flags();
-
     if ((result = oe_create_enclave(
-             argv[1],
-             OE_ENCLAVE_TYPE_SGX,
-             flags,
-             NULL,
-             0,
-             NULL,
-             0,
-             &enclave)) != OE_OK)
+             path, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, NULL, 0, &enclave)) !=
+        OE_OK)
     {
         oe_put_err("oe_create_enclave(): result=%u", result);
     }
@@ -61,6 +47,22 @@ int main(int argc, const char* argv[])
     {
         oe_put_err("oe_terminate_enclave(): result=%u", result);
     }
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE\n", argv[0]);
+        exit(1);
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    _test(argv[1], flags);
+
+    /* Read the time from the host time page */
+    _test(argv[1], flags | OE_ENCLAVE_FLAG_SHARED_TIME);
 
     printf("=== passed all tests (%s)\n", argv[0]);
 
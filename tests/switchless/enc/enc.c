@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include "switchless_t.h"
+
+int enc_increment_many(int count)
+{
+    int value = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int return_val = -1;
+        int out = 0;
+
+        if (host_increment(&return_val, value, &out) != OE_OK)
+            return -1;
+
+        if (return_val != 0 || out != value + 1)
+            return -1;
+
+        value = out;
+    }
+
+    return value;
+}
+
+int enc_increment(int in)
+{
+    return in + 1;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    1024, /* StackPageCount */
+    3);   /* TCSCount */
@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "switchless_u.h"
+
+#define NUM_OCALLS 10000
+#define NUM_ECALLS 10000
+
+static const char* _enclave_path;
+static pthread_t _main_thread;
+static size_t _num_switchless;
+static size_t _num_regular;
+
+int host_increment(int in, int* out)
+{
+    /* Switchless OCALLs run on host worker threads */
+    if (pthread_equal(pthread_self(), _main_thread))
+        _num_regular++;
+    else
+        __sync_fetch_and_add(&_num_switchless, 1);
+
+    *out = in + 1;
+    return 0;
+}
+
+static void _test(uint32_t flags, const oe_switchless_config_t* config)
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    int return_val = -1;
+    const struct timespec idle = {0, 100 * 1000 * 1000};
+
+    _num_switchless = 0;
+    _num_regular = 0;
+
+    if ((result = oe_create_switchless_enclave(
+             _enclave_path,
+             OE_ENCLAVE_TYPE_SGX,
+             flags,
+             config,
+             config ? sizeof(*config) : 0,
+             &enclave)) != OE_OK)
+        oe_put_err("oe_create_enclave(): result=%u", result);
+
+    result = enc_increment_many(enclave, &return_val, NUM_OCALLS);
+    OE_TEST(result == OE_OK);
+    OE_TEST(return_val == NUM_OCALLS);
+    OE_TEST(_num_switchless + _num_regular == NUM_OCALLS);
+
+    /* OCALLs made by a switchless ECALL also run off the main thread, on the
+     * host thread parked in the enclave worker */
+    if (!(flags &
+          (OE_ENCLAVE_FLAG_SWITCHLESS | OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS)))
+        OE_TEST(_num_switchless == 0);
+
+    /* Host workers pick up most posted OCALLs; only those that exhaust the
+     * spin budget fall back to regular OCALLs */
+    if (flags & OE_ENCLAVE_FLAG_SWITCHLESS)
+        OE_TEST(_num_switchless > 0);
+
+    printf(
+        "flags=0x%x: %zu switchless OCALLs, %zu regular OCALLs\n",
+        flags,
+        _num_switchless,
+        _num_regular);
+
+    /* ECALLs return the same results whether an enclave worker or a
+     * regular ECALL services them */
+    for (int i = 0; i < NUM_ECALLS; i++)
+    {
+        return_val = -1;
+        result = enc_increment(enclave, &return_val, i);
+        OE_TEST(result == OE_OK);
+        OE_TEST(return_val == i + 1);
+    }
+
+    /* Let idle enclave workers park on the host: posting must wake them,
+     * and terminating the enclave must release them */
+    nanosleep(&idle, NULL);
+
+    for (int i = 0; i < 16; i++)
+    {
+        return_val = -1;
+        result = enc_increment(enclave, &return_val, i);
+        OE_TEST(result == OE_OK);
+        OE_TEST(return_val == i + 1);
+    }
+
+    nanosleep(&idle, NULL);
+
+    result = oe_terminate_enclave(enclave);
+    OE_TEST(result == OE_OK);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    _main_thread = pthread_self();
+    _enclave_path = argv[1];
+
+    const uint32_t flags = oe_get_create_flags();
+
+    const oe_switchless_config_t config = {1, 2};
+
+    _test(flags, NULL);
+    _test(flags | OE_ENCLAVE_FLAG_SWITCHLESS, NULL);
+    _test(flags | OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS, NULL);
+    _test(
+        flags | OE_ENCLAVE_FLAG_SWITCHLESS | OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS,
+        NULL);
+
+    /* One host worker and two enclave workers */
+    _test(
+        flags | OE_ENCLAVE_FLAG_SWITCHLESS | OE_ENCLAVE_FLAG_SWITCHLESS_ECALLS,
+        &config);
+
+    printf("=== passed all tests (switchless)\n");
+
+    return 0;
+}
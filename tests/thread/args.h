@@ -36,4 +36,14 @@ typedef struct _test_rwlock_args
     bool readers_and_writers;
 } TestRWLockArgs;
 
+typedef struct _thread_wait_stats_args
+{
+    // Mirrors oe_thread_wait_stats_t
+    uint64_t spin_acquires;
+    uint64_t spin_wakeups;
+    uint64_t host_waits;
+    uint64_t elided_wakes;
+    uint64_t host_wakes;
+} ThreadWaitStatsArgs;
+
 #endif /* _stdc_args_h */
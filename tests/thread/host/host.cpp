@@ -4,6 +4,7 @@
 #include <openenclave/host.h>
 #include <openenclave/internal/error.h>
 #include <openenclave/internal/tests.h>
+#include <openenclave/internal/thread.h>
 #include <cassert>
 #include <chrono>
 #include <cstdio>
@@ -230,8 +231,81 @@ void TestThreadLockingPatterns(oe_enclave_t* enclave)
     printf("TestThreadLockingPatterns Complete\n");
 }
 
+void TestTimedWaits(oe_enclave_t* enclave)
+{
+    printf("TestTimedWaits Starting\n");
+
+    OE_TEST(oe_call_enclave(enclave, "TestCondTimedWait", NULL) == OE_OK);
+
+    std::thread holder([enclave]() {
+        OE_TEST(oe_call_enclave(enclave, "HoldTimedMutex", NULL) == OE_OK);
+    });
+
+    // Let the holder lock the mutex first.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    OE_TEST(oe_call_enclave(enclave, "TestMutexTimedLock", NULL) == OE_OK);
+
+    holder.join();
+
+    printf("TestTimedWaits Complete\n");
+}
+
 void TestReadersWriterLock(oe_enclave_t* enclave);
 
+static ThreadWaitStatsArgs _get_thread_wait_stats(oe_enclave_t* enclave)
+{
+    ThreadWaitStatsArgs stats = {};
+
+    OE_TEST(
+        oe_call_enclave(enclave, "GetThreadWaitStats", &stats) == OE_OK);
+
+    return stats;
+}
+
+// Rerun the contended tests with spinning disabled, so that every wait blocks
+// in the host, and check that the wait/wake paths were counted.
+void TestSpinCount(oe_enclave_t* enclave)
+{
+    uint64_t spin_count = 0;
+
+    printf("TestSpinCount Starting\n");
+
+    ThreadWaitStatsArgs before = _get_thread_wait_stats(enclave);
+
+    OE_TEST(oe_call_enclave(enclave, "SetSpinCount", &spin_count) == OE_OK);
+
+    _args.count1 = 0;
+    _args.count2 = 0;
+    TestMutex(enclave);
+    TestThreadWakeWait(enclave);
+
+    spin_count = OE_THREAD_DEFAULT_SPIN_COUNT;
+    OE_TEST(oe_call_enclave(enclave, "SetSpinCount", &spin_count) == OE_OK);
+
+    ThreadWaitStatsArgs after = _get_thread_wait_stats(enclave);
+
+    // Waits and wake-ups were resolved one way or the other.
+    OE_TEST(
+        after.host_waits + after.spin_wakeups >
+        before.host_waits + before.spin_wakeups);
+    OE_TEST(
+        after.host_wakes + after.elided_wakes >
+        before.host_wakes + before.elided_wakes);
+
+    // Without a spin budget, locks are never acquired by spinning.
+    OE_TEST(after.spin_acquires == before.spin_acquires);
+
+    printf(
+        "TestSpinCount Complete: spin_acquires=%llu spin_wakeups=%llu "
+        "host_waits=%llu elided_wakes=%llu host_wakes=%llu\n",
+        (unsigned long long)after.spin_acquires,
+        (unsigned long long)after.spin_wakeups,
+        (unsigned long long)after.host_waits,
+        (unsigned long long)after.elided_wakes,
+        (unsigned long long)after.host_wakes);
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -270,6 +344,10 @@ int main(int argc, const char* argv[])
 
     TestReadersWriterLock(enclave);
 
+    TestSpinCount(enclave);
+
+    TestTimedWaits(enclave);
+
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
     {
         oe_put_err("oe_terminate_enclave(): result=%u", result);
@@ -4,6 +4,7 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "../args.h"
@@ -245,6 +246,67 @@ OE_ECALL void LockAndUnlockMutexes(void* arg)
     }
 }
 
+static oe_mutex_t timed_mutex = OE_MUTEX_INITIALIZER;
+
+OE_ECALL void HoldTimedMutex(void* args_)
+{
+    OE_TEST(oe_mutex_lock(&timed_mutex) == OE_OK);
+    oe_sleep(500);
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == OE_OK);
+}
+
+OE_ECALL void TestMutexTimedLock(void* args_)
+{
+    // HoldTimedMutex() holds the mutex for 500 milliseconds.
+    uint64_t start = oe_get_time();
+    OE_TEST(oe_mutex_timedlock(&timed_mutex, start + 50) == OE_TIMEOUT);
+    OE_TEST(oe_get_time() >= start + 50);
+
+    OE_TEST(oe_mutex_timedlock(&timed_mutex, start + 5000) == OE_OK);
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == OE_OK);
+}
+
+OE_ECALL void TestCondTimedWait(void* args_)
+{
+    oe_mutex_t mutex = OE_MUTEX_INITIALIZER;
+    oe_cond_t cond = OE_COND_INITIALIZER;
+
+    OE_TEST(oe_mutex_lock(&mutex) == OE_OK);
+
+    // Nobody signals the condition, so the wait times out.
+    uint64_t start = oe_get_time();
+    OE_TEST(oe_cond_timedwait(&cond, &mutex, start + 100) == OE_TIMEOUT);
+    OE_TEST(oe_get_time() >= start + 100);
+
+    // A deadline in the past times out immediately.
+    OE_TEST(oe_cond_timedwait(&cond, &mutex, 0) == OE_TIMEOUT);
+
+    // The mutex is locked again and the condition has no waiters left.
+    OE_TEST(oe_mutex_unlock(&mutex) == OE_OK);
+    OE_TEST(oe_cond_destroy(&cond) == OE_OK);
+    OE_TEST(oe_mutex_destroy(&mutex) == OE_OK);
+}
+
+OE_ECALL void SetSpinCount(void* arg)
+{
+    oe_thread_set_spin_count(*(uint64_t*)arg);
+}
+
+OE_ECALL void GetThreadWaitStats(void* args_)
+{
+    ThreadWaitStatsArgs* args = (ThreadWaitStatsArgs*)args_;
+    oe_thread_wait_stats_t stats;
+
+    OE_TEST(oe_get_thread_wait_stats(&stats) == OE_OK);
+    OE_TEST(oe_get_thread_wait_stats(NULL) == OE_INVALID_PARAMETER);
+
+    args->spin_acquires = stats.spin_acquires;
+    args->spin_wakeups = stats.spin_wakeups;
+    args->host_waits = stats.host_waits;
+    args->elided_wakes = stats.elided_wakes;
+    args->host_wakes = stats.host_wakes;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
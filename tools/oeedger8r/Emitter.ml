@@ -531,7 +531,7 @@ let oe_gen_ocall_enclave_wrapper (os:out_channel) (fd:Ast.func_decl) =
   ) fd.Ast.plist;
 
   fprintf os "\n    /* Allocate host buffer and copy inputs to host. */\n";
-  fprintf os "    __host_buffer = __host_ptr = (uint8_t*) oe_host_malloc(__host_buffer_size); \n";
+  fprintf os "    __host_buffer = __host_ptr = (uint8_t*) oe_allocate_ocall_buffer(__host_buffer_size); \n";
   fprintf os "    if (__host_buffer == 0) { \n";
   fprintf os "        __result = OE_OUT_OF_MEMORY;\n";
   fprintf os "        goto done;\n";
@@ -573,7 +573,7 @@ let oe_gen_ocall_enclave_wrapper (os:out_channel) (fd:Ast.func_decl) =
   if fd.Ast.rtype <> Ast.Void then fprintf os "    *_retval = __host_args._retval;\n";  
   fprintf os "    __result = OE_OK;\n";
   fprintf os "done:\n";  
-  fprintf os "    oe_host_free(__host_buffer);\n";
+  fprintf os "    oe_free_ocall_buffer(__host_buffer);\n";
   fprintf os "    return __result;\n";
   fprintf os "}\n\n" 
 